@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <parsebgp.hpp>
+#include <parsebgp/bgp/asn_kernels.hpp>
+#include <parsebgp/bgp/community_matcher.hpp>
+#include <parsebgp/io.hpp>
+#include <parsebgp/io/ndjson.hpp>
+#include <parsebgp/rib/origin.hpp>
+#include <parsebgp/rib/topology.hpp>
+
+#include "corpus.hpp"
+
+namespace pbgp = parsebgp;
+namespace bgp = parsebgp::bgp;
+namespace io = parsebgp::io;
+namespace mrt = parsebgp::mrt;
+namespace rib = parsebgp::rib;
+namespace fs = std::filesystem;
+
+using pbgp::bench::CorpusOptions;
+using pbgp::utils::Isa;
+
+namespace {
+
+//==============================================================================
+// Corpus
+//==============================================================================
+
+struct CorpusFile {
+  std::string path;
+  std::size_t raw_size;
+};
+
+struct Corpus {
+  fs::path dir;
+  CorpusFile rib;
+  CorpusFile rib_gz;
+  CorpusFile rib_bz2;
+  CorpusFile updates;
+  CorpusFile updates_gz;
+  CorpusFile updates_bz2;
+};
+
+/* Set once the corpus is generated, so main() knows what to remove. */
+fs::path corpus_dir;
+
+/* Generated on first use into a per-process temporary directory. */
+Corpus& corpus() {
+  static Corpus corpus = [] {
+    Corpus c;
+    c.dir = fs::temp_directory_path() / ("parsebgp_cpp_bench." + std::to_string(::getpid()));
+    fs::create_directories(c.dir);
+    corpus_dir = c.dir;
+    auto write = [&](const std::vector<uint8_t>& data, const std::string& name, auto writer) {
+      CorpusFile file{ (c.dir / name).string(), data.size() };
+      if (!writer(file.path, data)) file.path.clear();
+      return file;
+    };
+    CorpusOptions options;
+    auto rib = pbgp::bench::make_table_dump_v2(options);
+    c.rib = write(rib, "rib", pbgp::bench::write_raw);
+    c.rib_gz = write(rib, "rib.gz", pbgp::bench::write_gzip);
+    c.rib_bz2 = write(rib, "rib.bz2", pbgp::bench::write_bzip2);
+    auto updates = pbgp::bench::make_bgp4mp(options);
+    c.updates = write(updates, "updates", pbgp::bench::write_raw);
+    c.updates_gz = write(updates, "updates.gz", pbgp::bench::write_gzip);
+    c.updates_bz2 = write(updates, "updates.bz2", pbgp::bench::write_bzip2);
+    return c;
+  }();
+  return corpus;
+}
+
+pbgp::Options reader_options() {
+  pbgp::Options options;
+  options.set_ignore_not_implemented(true);
+  return options;
+}
+
+/* All messages of a file, decoded once and kept alive for accessor benchmarks. */
+std::vector<pbgp::Message> load_messages(const std::string& path) {
+  std::vector<pbgp::Message> messages;
+  auto reader = io::mrt_reader(io::FileStream(path), reader_options());
+  for (auto msg = reader.message(); msg; reader.decode_one(), msg = reader.message()) {
+    messages.push_back(reader.release_message());
+  }
+  return messages;
+}
+
+const std::vector<pbgp::Message>& rib_messages() {
+  static auto messages = load_messages(corpus().rib.path);
+  return messages;
+}
+
+/* Peers of the preloaded TABLE_DUMP_V2 corpus. */
+const mrt::table_dump_v2::PeerTable& rib_peers() {
+  static mrt::table_dump_v2::PeerTable peers = [] {
+    mrt::table_dump_v2::PeerTable p;
+    for (auto& message : rib_messages()) {
+      auto table_dump_v2 = message.to_mrt().to_table_dump_v2();
+      if (table_dump_v2.subtype().is_peer_index_table()) {
+        p.load(table_dump_v2.to_peer_index());
+        break;
+      }
+    }
+    return p;
+  }();
+  return peers;
+}
+
+/* Calls f(rib) for every RIB record of the preloaded TABLE_DUMP_V2 corpus. */
+template<typename F>
+void for_each_rib(F&& f) {
+  for (auto& message : rib_messages()) {
+    auto table_dump_v2 = message.to_mrt().to_table_dump_v2();
+    if (table_dump_v2.subtype().is_rib_ip()) f(table_dump_v2.to_rib());
+  }
+}
+
+std::size_t rib_entry_count() {
+  static std::size_t count = [] {
+    std::size_t n = 0;
+    for_each_rib([&](const mrt::table_dump_v2::Rib& rib) { n += rib.size(); });
+    return n;
+  }();
+  return count;
+}
+
+void set_records_processed(benchmark::State& state, std::size_t per_iteration) {
+  state.counters["records"] = benchmark::Counter(double(per_iteration) * double(state.iterations()),
+                                                 benchmark::Counter::kIsRate);
+}
+
+//==============================================================================
+// io::MirroredRingBuffer
+//==============================================================================
+
+/* Push chunks of state.range(0) bytes through a 1 MiB buffer, as Reader::fill_buffer() does. */
+void BM_MirroredRingBuffer(benchmark::State& state) {
+  const auto chunk = std::size_t(state.range(0));
+  std::vector<uint8_t> source(chunk, 0xa5);
+  io::MirroredRingBuffer buffer(1 << 20);
+  for (auto _ : state) {
+    while (buffer.available_write() >= chunk) {
+      std::memcpy(buffer.prepare_write().data(), source.data(), chunk);
+      buffer.commit_write(chunk);
+    }
+    while (buffer.available_read()) {
+      auto in = buffer.prepare_read();
+      auto n = std::min(in.size(), chunk);
+      benchmark::DoNotOptimize(in.data()[n - 1]);
+      buffer.commit_read(n);
+    }
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(buffer.capacity()));
+}
+BENCHMARK(BM_MirroredRingBuffer)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+//==============================================================================
+// io::Reader
+//==============================================================================
+
+/* Decode a whole file with a reader buffer of state.range(0) bytes. */
+template<typename MakeStream>
+void run_reader(benchmark::State& state, const CorpusFile& file, MakeStream make_stream) {
+  if (file.path.empty()) {
+    state.SkipWithError("Failed to write corpus.");
+    return;
+  }
+  std::size_t records = 0;
+  for (auto _ : state) {
+    records = 0;
+    auto reader =
+      io::mrt_reader(make_stream(file.path), reader_options(), std::size_t(state.range(0)));
+    for (auto msg : reader) {
+      if (!msg) break;
+      records++;
+    }
+    if (!reader.status().is_finished()) {
+      state.SkipWithError("Reader failed.");
+      return;
+    }
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(file.raw_size));
+  set_records_processed(state, records);
+}
+
+io::FileStream file_stream(const std::string& path) {
+  return io::FileStream(path);
+}
+
+io::GzipStream gzip_stream(const std::string& path) {
+  return io::GzipStream(path, 32678 * 4);
+}
+
+io::Bzip2Stream bzip2_stream(const std::string& path) {
+  return io::Bzip2Stream(path);
+}
+
+void BM_ReaderRibRaw(benchmark::State& state) {
+  run_reader(state, corpus().rib, file_stream);
+}
+void BM_ReaderRibGzip(benchmark::State& state) {
+  run_reader(state, corpus().rib_gz, gzip_stream);
+}
+void BM_ReaderRibBzip2(benchmark::State& state) {
+  run_reader(state, corpus().rib_bz2, bzip2_stream);
+}
+void BM_ReaderUpdatesRaw(benchmark::State& state) {
+  run_reader(state, corpus().updates, file_stream);
+}
+void BM_ReaderUpdatesGzip(benchmark::State& state) {
+  run_reader(state, corpus().updates_gz, gzip_stream);
+}
+void BM_ReaderUpdatesBzip2(benchmark::State& state) {
+  run_reader(state, corpus().updates_bz2, bzip2_stream);
+}
+
+BENCHMARK(BM_ReaderRibRaw)->Arg(32678)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReaderRibGzip)->Arg(32678)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReaderRibBzip2)->Arg(32678)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReaderUpdatesRaw)->Arg(32678)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReaderUpdatesGzip)->Arg(32678)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReaderUpdatesBzip2)->Arg(32678)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+// Attribute accessors and CPtrRange iteration
+//==============================================================================
+
+/* Touch the attributes most consumers read: origin, AS path, next hop and communities. */
+uint64_t visit_entry(const mrt::table_dump_v2::RibEntry& entry) {
+  uint64_t sum = entry.peer_index();
+  auto attrs = entry.path_attributes();
+  if (attrs.has_origin()) sum += attrs.origin().value();
+  if (attrs.has_as_path()) {
+    for (auto segment : attrs.as_path()) {
+      for (auto asn : segment) sum += asn;
+    }
+  }
+  if (attrs.has_next_hop()) sum += attrs.next_hop().value()[3];
+  if (attrs.has_communities()) {
+    for (auto community : attrs.communities()) sum += community.u32;
+  }
+  return sum;
+}
+
+void BM_RibAttributes(benchmark::State& state) {
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for_each_rib([&](const mrt::table_dump_v2::Rib& rib) {
+      for (auto entry : rib) sum += visit_entry(entry);
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  set_records_processed(state, rib_entry_count());
+}
+BENCHMARK(BM_RibAttributes)->Unit(benchmark::kMillisecond);
+
+/* Same as BM_RibAttributes, prefetching state.range(0) entries ahead. */
+void BM_RibAttributesPrefetched(benchmark::State& state) {
+  const auto distance = std::ptrdiff_t(state.range(0));
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for_each_rib([&](const mrt::table_dump_v2::Rib& rib) {
+      for (auto entry : rib.prefetched(distance)) sum += visit_entry(entry);
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  set_records_processed(state, rib_entry_count());
+}
+BENCHMARK(BM_RibAttributesPrefetched)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
+
+/* Random access iteration: binary search for the first entry of a peer in each record. */
+void BM_RibPartitionPoint(benchmark::State& state) {
+  std::size_t records = 0;
+  for_each_rib([&](const mrt::table_dump_v2::Rib&) { records++; });
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    uint16_t peer = 0;
+    for_each_rib([&](const mrt::table_dump_v2::Rib& rib) {
+      auto it = std::partition_point(rib.begin(), rib.end(), [&](const auto& entry) {
+        return entry.peer_index() < peer;
+      });
+      sum += std::size_t(it - rib.begin());
+      peer = uint16_t((peer + 7) % CorpusOptions().peers);
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  set_records_processed(state, records);
+}
+BENCHMARK(BM_RibPartitionPoint)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+// io::NdjsonFormatter
+//==============================================================================
+
+/*
+ * Format the preloaded TABLE_DUMP_V2 corpus, handing the text off every 1 MiB. Bytes processed are
+ * those of the MRT input, to compare with the decompression rate of BM_ReaderRibGzip.
+ */
+void BM_NdjsonRib(benchmark::State& state) {
+  auto& peers = rib_peers();
+  io::NdjsonFormatter json;
+  std::size_t json_size = 0;
+  for (auto _ : state) {
+    for (auto& message : rib_messages()) {
+      json.append(message.to_mrt(), peers);
+      if (json.size() >= 1 << 20) {
+        json_size += json.size();
+        benchmark::DoNotOptimize(json.data());
+        json.clear();
+      }
+    }
+    json_size += json.size();
+    json.clear();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(corpus().rib.raw_size));
+  state.counters["json_bytes"] = benchmark::Counter(double(json_size), benchmark::Counter::kIsRate);
+  set_records_processed(state, rib_entry_count());
+}
+BENCHMARK(BM_NdjsonRib)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+// rib::OriginTable
+//==============================================================================
+
+void BM_OriginTable(benchmark::State& state) {
+  std::size_t moas = 0;
+  std::size_t memory = 0;
+  for (auto _ : state) {
+    rib::OriginTable table;
+    for (auto& message : rib_messages()) table.load(message.to_mrt().to_table_dump_v2());
+    moas = table.moas_size();
+    memory = table.memory_usage();
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(corpus().rib.raw_size));
+  state.counters["moas"] = double(moas);
+  state.counters["memory"] = double(memory);
+  set_records_processed(state, rib_entry_count());
+}
+BENCHMARK(BM_OriginTable)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+// rib::AsTopology
+//==============================================================================
+
+void BM_AsTopology(benchmark::State& state) {
+  std::size_t edges = 0;
+  for (auto _ : state) {
+    rib::AsTopology::Options options;
+    options.peers_per_edge = 2; // Random paths: most edges are seen by a single peer.
+    rib::AsTopology topology(1 << 20, options);
+    {
+      rib::AsTopology::Extractor extractor(topology);
+      for (auto& message : rib_messages()) extractor.add(message.to_mrt(), rib_peers());
+    }
+    edges = topology.size();
+    benchmark::DoNotOptimize(topology.csr());
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(corpus().rib.raw_size));
+  state.counters["edges"] = double(edges);
+  set_records_processed(state, rib_entry_count());
+}
+BENCHMARK(BM_AsTopology)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+// bgp::asn_kernels and bgp::CommunityMatcher
+//==============================================================================
+
+/* AS_SEQUENCE segments and COMMUNITIES of all RIB entries, copied out of the messages. */
+struct Arrays {
+  std::vector<std::vector<uint32_t>> as_paths;
+  std::vector<std::vector<uint32_t>> communities;
+};
+
+const Arrays& arrays() {
+  static Arrays arrays = [] {
+    Arrays a;
+    for_each_rib([&](const mrt::table_dump_v2::Rib& rib) {
+      for (auto entry : rib) {
+        auto attrs = entry.path_attributes();
+        if (attrs.has_as_path()) {
+          for (auto segment : attrs.as_path()) {
+            if (!segment.type().is_as_seq()) continue;
+            auto asns = segment.asns();
+            a.as_paths.emplace_back(asns.begin(), asns.end());
+          }
+        }
+        if (attrs.has_communities()) {
+          auto values = attrs.communities().values();
+          a.communities.emplace_back(values.begin(), values.end());
+        }
+      }
+    });
+    return a;
+  }();
+  return arrays;
+}
+
+/* Select the ISA given as state.range(0) for both kernels and matcher; false if unsupported. */
+bool select_isa(benchmark::State& state, bgp::CommunityMatcher* matcher = nullptr) {
+  Isa isa = Isa::Value(state.range(0));
+  bool supported = bgp::asn_kernels::set_isa(isa).value() == isa.value();
+  if (matcher) matcher->set_isa(isa);
+  if (!supported) state.SkipWithError("ISA not supported by this build or CPU.");
+  return supported;
+}
+
+template<typename Kernel>
+void run_asn_kernel(benchmark::State& state, Kernel kernel) {
+  if (!select_isa(state)) return;
+  auto& paths = arrays().as_paths;
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    for (auto& path : paths) sum += kernel(bgp::asn_kernels::Asns(path.data(), path.size()));
+    benchmark::DoNotOptimize(sum);
+  }
+  bgp::asn_kernels::set_isa(pbgp::utils::supported_isa());
+  set_records_processed(state, paths.size());
+}
+
+void BM_AsnContains(benchmark::State& state) {
+  run_asn_kernel(state, [](bgp::asn_kernels::Asns asns) {
+    return std::size_t(bgp::asn_kernels::contains(asns, 3356));
+  });
+}
+void BM_AsnFindNonPublic(benchmark::State& state) {
+  run_asn_kernel(state, [](bgp::asn_kernels::Asns asns) {
+    return bgp::asn_kernels::find_non_public(asns);
+  });
+}
+void BM_AsnCountPrepends(benchmark::State& state) {
+  run_asn_kernel(state, [](bgp::asn_kernels::Asns asns) {
+    return bgp::asn_kernels::count_prepends(asns);
+  });
+}
+
+#define PARSEBGP_CPP_BENCH_ISAS Arg(Isa::SCALAR)->Arg(Isa::AVX2)->Arg(Isa::AVX512)
+
+BENCHMARK(BM_AsnContains)->PARSEBGP_CPP_BENCH_ISAS;
+BENCHMARK(BM_AsnFindNonPublic)->PARSEBGP_CPP_BENCH_ISAS;
+BENCHMARK(BM_AsnCountPrepends)->PARSEBGP_CPP_BENCH_ISAS;
+
+void BM_CommunityMatcher(benchmark::State& state) {
+  using Pattern = bgp::CommunityMatcher::Pattern;
+  bgp::CommunityMatcher matcher;
+  matcher.add(Pattern::exact(3356, 100));
+  matcher.add(Pattern::any_value(174));
+  matcher.add(Pattern::any_asn(666));
+  matcher.add(Pattern::value_range(2914, 400, 499));
+  matcher.add(Pattern::asn_range(64512, 65534));
+  if (!select_isa(state, &matcher)) return;
+  auto& communities = arrays().communities;
+  for (auto _ : state) {
+    bgp::CommunityMatcher::Matches matches = 0;
+    for (auto& values : communities) {
+      matches |= matcher.match(pbgp::utils::span<const uint32_t>(values.data(), values.size()));
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  bgp::asn_kernels::set_isa(pbgp::utils::supported_isa());
+  set_records_processed(state, communities.size());
+}
+BENCHMARK(BM_CommunityMatcher)->PARSEBGP_CPP_BENCH_ISAS;
+
+#undef PARSEBGP_CPP_BENCH_ISAS
+
+} // namespace
+
+/* Same as BENCHMARK_MAIN(), but writes JSON results to parsebgp_cpp_bench.json by default. */
+int main(int argc, char* argv[]) {
+  std::vector<char*> args(argv, argv + argc);
+  std::string out = "--benchmark_out=parsebgp_cpp_bench.json";
+  std::string out_format = "--benchmark_out_format=json";
+  bool has_out = std::any_of(args.begin() + 1, args.end(), [](const char* arg) {
+    return std::strncmp(arg, "--benchmark_out=", 16) == 0;
+  });
+  if (!has_out) {
+    args.push_back(out.data());
+    args.push_back(out_format.data());
+  }
+
+  int args_size = int(args.size());
+  benchmark::Initialize(&args_size, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_size, args.data())) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  std::error_code ignored;
+  if (!corpus_dir.empty()) fs::remove_all(corpus_dir, ignored);
+  return 0;
+}
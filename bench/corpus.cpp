@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <bzlib.h>
+#include <cstdio>
+#include <zlib.h>
+
+#include "corpus.hpp"
+
+namespace parsebgp {
+namespace bench {
+
+namespace {
+
+constexpr uint16_t MRT_TABLE_DUMP_V2 = 13;
+constexpr uint16_t MRT_BGP4MP = 16;
+constexpr uint16_t TABLE_DUMP_V2_PEER_INDEX_TABLE = 1;
+constexpr uint16_t TABLE_DUMP_V2_RIB_IPV4_UNICAST = 2;
+constexpr uint16_t BGP4MP_MESSAGE_AS4 = 4;
+constexpr uint16_t BGP4MP_STATE_CHANGE_AS4 = 5;
+
+constexpr uint8_t ATTR_OPTIONAL = 0x80;
+constexpr uint8_t ATTR_TRANSITIVE = 0x40;
+constexpr uint8_t ATTR_EXTENDED = 0x10;
+
+constexpr uint32_t LOCAL_ASN = 6447;
+constexpr uint32_t LOCAL_IP = 0x80dfd30f;
+
+class Writer {
+public:
+  explicit Writer(std::vector<uint8_t>& out) : out_(out) {}
+
+  void u8(uint8_t v) { out_.push_back(v); }
+  void u16(uint16_t v) {
+    u8(uint8_t(v >> 8));
+    u8(uint8_t(v));
+  }
+  void u32(uint32_t v) {
+    u16(uint16_t(v >> 16));
+    u16(uint16_t(v));
+  }
+
+  std::size_t size() const { return out_.size(); }
+  /* Reserve a length field to be filled by patch16/patch32. */
+  std::size_t hole16() {
+    u16(0);
+    return size() - 2;
+  }
+  std::size_t hole32() {
+    u32(0);
+    return size() - 4;
+  }
+  void patch16(std::size_t at, std::size_t value) {
+    out_[at] = uint8_t(value >> 8);
+    out_[at + 1] = uint8_t(value);
+  }
+  void patch32(std::size_t at, std::size_t value) {
+    patch16(at, value >> 16);
+    patch16(at + 2, value & 0xffff);
+  }
+
+private:
+  std::vector<uint8_t>& out_;
+};
+
+struct Peer {
+  uint32_t ip;
+  uint32_t asn;
+};
+
+struct Prefix {
+  uint32_t addr;
+  uint8_t len;
+};
+
+std::vector<Peer> make_peers(Random& rng, const CorpusOptions& options) {
+  std::vector<Peer> peers;
+  for (std::size_t i = 0; i < options.peers; i++) {
+    peers.push_back({ 0xc0000000 | rng.below(1 << 24), 1 + rng.below(64000) });
+  }
+  return peers;
+}
+
+uint8_t prefix_len(Random& rng) {
+  uint32_t r = rng.below(1000);
+  if (r < 550) return 24;
+  if (r < 750) return uint8_t(22 + rng.below(2));
+  if (r < 995) return uint8_t(16 + rng.below(6));
+  return uint8_t(8 + rng.below(8));
+}
+
+void write_prefix(Writer& w, const Prefix& prefix) {
+  w.u8(prefix.len);
+  for (int i = 0; i < (prefix.len + 7) / 8; i++) w.u8(uint8_t(prefix.addr >> (24 - 8 * i)));
+}
+
+void write_attr_header(Writer& w, uint8_t flags, uint8_t type, std::size_t len) {
+  if (len > 255) {
+    w.u8(flags | ATTR_EXTENDED);
+    w.u8(type);
+    w.u16(uint16_t(len));
+  } else {
+    w.u8(flags);
+    w.u8(type);
+    w.u8(uint8_t(len));
+  }
+}
+
+/* Path attributes of an IPv4 route learnt from peer, with 4-byte AS numbers. */
+void write_path_attributes(Writer& w, Random& rng, const Peer& peer) {
+  write_attr_header(w, ATTR_TRANSITIVE, 1, 1);
+  w.u8(rng.chance(900) ? 0 : uint8_t(1 + rng.below(2)));
+
+  std::vector<uint32_t> path{ peer.asn };
+  uint32_t hops = 1 + rng.geometric(700, 8);
+  for (uint32_t i = 0; i < hops; i++) {
+    uint32_t asn = rng.chance(50) ? 64512 + rng.below(1000) : 1 + rng.below(400000);
+    uint32_t repeat = rng.chance(100) ? 1 + rng.below(4) : 1;
+    path.insert(path.end(), repeat, asn);
+  }
+  std::vector<uint32_t> set;
+  if (rng.chance(10)) {
+    for (uint32_t i = 0, n = 2 + rng.below(3); i < n; i++) set.push_back(1 + rng.below(400000));
+  }
+  write_attr_header(
+    w, ATTR_TRANSITIVE, 2, 2 + 4 * path.size() + (set.empty() ? 0 : 2 + 4 * set.size()));
+  w.u8(2);
+  w.u8(uint8_t(path.size()));
+  for (auto asn : path) w.u32(asn);
+  if (!set.empty()) {
+    w.u8(1);
+    w.u8(uint8_t(set.size()));
+    for (auto asn : set) w.u32(asn);
+  }
+
+  write_attr_header(w, ATTR_TRANSITIVE, 3, 4);
+  w.u32(peer.ip);
+
+  if (rng.chance(300)) {
+    write_attr_header(w, ATTR_OPTIONAL, 4, 4);
+    w.u32(rng.below(1000));
+  }
+
+  if (rng.chance(600)) {
+    uint32_t count = rng.chance(200) ? 1 + rng.below(40) : rng.geometric(600, 10);
+    write_attr_header(w, ATTR_OPTIONAL | ATTR_TRANSITIVE, 8, 4 * count);
+    for (uint32_t i = 0; i < count; i++) {
+      w.u32((i ? rng.below(65536) : path[1 % path.size()] & 0xffff) << 16 | rng.below(1000));
+    }
+  }
+
+  if (rng.chance(100)) {
+    uint32_t count = rng.geometric(500, 6);
+    write_attr_header(w, ATTR_OPTIONAL | ATTR_TRANSITIVE, 32, 12 * count);
+    for (uint32_t i = 0; i < count; i++) {
+      w.u32(path[0]);
+      w.u32(rng.below(100));
+      w.u32(rng.below(100000));
+    }
+  }
+}
+
+std::size_t begin_record(Writer& w, uint32_t time, uint16_t type, uint16_t subtype) {
+  w.u32(time);
+  w.u16(type);
+  w.u16(subtype);
+  return w.hole32();
+}
+
+void end_record(Writer& w, std::size_t length_at) {
+  w.patch32(length_at, w.size() - length_at - 4);
+}
+
+Prefix random_prefix(Random& rng) {
+  uint8_t len = prefix_len(rng);
+  uint32_t addr = (0x01000000 + rng.below(0xdf000000 - 0x01000000)) & ~(0xffffffffU >> len);
+  return { addr, len };
+}
+
+} // namespace
+
+std::vector<uint8_t> make_table_dump_v2(const CorpusOptions& options) {
+  Random rng(options.seed);
+  auto peers = make_peers(rng, options);
+  std::vector<uint8_t> out;
+  Writer w(out);
+
+  auto length_at =
+    begin_record(w, options.start_time, MRT_TABLE_DUMP_V2, TABLE_DUMP_V2_PEER_INDEX_TABLE);
+  w.u32(LOCAL_IP);
+  w.u16(0);
+  w.u16(uint16_t(peers.size()));
+  for (auto& peer : peers) {
+    w.u8(0x02); // IPv4 address, 4-byte ASN.
+    w.u32(peer.ip);
+    w.u32(peer.ip);
+    w.u32(peer.asn);
+  }
+  end_record(w, length_at);
+
+  // Ascending, non-overlapping prefixes keep records in the order collectors dump them.
+  uint64_t next = 0x01000000;
+  for (uint32_t seq = 0; seq < options.prefixes; seq++) {
+    uint8_t len = prefix_len(rng);
+    uint64_t block = uint64_t(1) << (32 - len);
+    next = (next + block - 1) & ~(block - 1);
+    if (next + block > 0xdf000000) break;
+    Prefix prefix{ uint32_t(next), len };
+    next += len >= 22 ? block * (1 + rng.below(3)) : block;
+
+    length_at =
+      begin_record(w, options.start_time, MRT_TABLE_DUMP_V2, TABLE_DUMP_V2_RIB_IPV4_UNICAST);
+    w.u32(seq);
+    write_prefix(w, prefix);
+    auto count_at = w.hole16();
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < peers.size(); i++) {
+      if (!rng.chance(850)) continue;
+      count++;
+      w.u16(i);
+      w.u32(options.start_time - rng.below(30 * 86400));
+      auto attrs_at = w.hole16();
+      write_path_attributes(w, rng, peers[i]);
+      w.patch16(attrs_at, w.size() - attrs_at - 2);
+    }
+    w.patch16(count_at, count);
+    end_record(w, length_at);
+  }
+  return out;
+}
+
+std::vector<uint8_t> make_bgp4mp(const CorpusOptions& options) {
+  Random rng(options.seed + 1);
+  auto peers = make_peers(rng, options);
+  std::vector<uint8_t> out;
+  Writer w(out);
+
+  uint32_t time = options.start_time;
+  for (std::size_t i = 0; i < options.updates; i++) {
+    if (rng.chance(300)) time += 1 + rng.below(3);
+    auto& peer = peers[rng.below(uint32_t(peers.size()))];
+    bool state_change = rng.chance(1);
+
+    auto length_at = begin_record(
+      w, time, MRT_BGP4MP, state_change ? BGP4MP_STATE_CHANGE_AS4 : BGP4MP_MESSAGE_AS4);
+    w.u32(peer.asn);
+    w.u32(LOCAL_ASN);
+    w.u16(0);
+    w.u16(1);
+    w.u32(peer.ip);
+    w.u32(LOCAL_IP);
+    if (state_change) {
+      w.u16(6);
+      w.u16(1);
+      end_record(w, length_at);
+      continue;
+    }
+
+    for (int j = 0; j < 16; j++) w.u8(0xff);
+    auto bgp_length_at = w.hole16();
+    w.u8(2); // UPDATE
+    auto withdrawn_at = w.hole16();
+    bool withdrawal = rng.chance(200);
+    if (withdrawal) {
+      for (uint32_t j = 0, n = rng.geometric(600, 10); j < n; j++) {
+        write_prefix(w, random_prefix(rng));
+      }
+    }
+    w.patch16(withdrawn_at, w.size() - withdrawn_at - 2);
+    auto attrs_at = w.hole16();
+    if (!withdrawal) write_path_attributes(w, rng, peer);
+    w.patch16(attrs_at, w.size() - attrs_at - 2);
+    if (!withdrawal) {
+      for (uint32_t j = 0, n = rng.geometric(500, 5); j < n; j++) {
+        write_prefix(w, random_prefix(rng));
+      }
+    }
+    w.patch16(bgp_length_at, w.size() - (bgp_length_at - 16));
+    end_record(w, length_at);
+  }
+  return out;
+}
+
+bool write_raw(const std::string& path, const std::vector<uint8_t>& data) {
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+bool write_gzip(const std::string& path, const std::vector<uint8_t>& data) {
+  gzFile f = gzopen(path.c_str(), "wb6");
+  if (!f) return false;
+  bool ok = true;
+  constexpr std::size_t chunk = 1 << 20;
+  for (std::size_t i = 0; ok && i < data.size(); i += chunk) {
+    auto n = unsigned(std::min(chunk, data.size() - i));
+    ok = gzwrite(f, data.data() + i, n) == int(n);
+  }
+  return gzclose_w(f) == Z_OK && ok;
+}
+
+bool write_bzip2(const std::string& path, const std::vector<uint8_t>& data) {
+  BZFILE* f = BZ2_bzopen(path.c_str(), "wb9");
+  if (!f) return false;
+  bool ok = true;
+  constexpr std::size_t chunk = 1 << 20;
+  for (std::size_t i = 0; ok && i < data.size(); i += chunk) {
+    int n = int(std::min(chunk, data.size() - i));
+    ok = BZ2_bzwrite(f, const_cast<uint8_t*>(data.data() + i), n) == n;
+  }
+  BZ2_bzclose(f);
+  return ok;
+}
+
+} // namespace bench
+} // namespace parsebgp
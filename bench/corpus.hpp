@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace parsebgp {
+namespace bench {
+
+/*
+ * Deterministic synthetic MRT data, so benchmarks need neither network access nor checked-in
+ * dumps.
+ *
+ * Sizes loosely follow public RouteViews/RIS feeds: mostly /24 prefixes seen by most full-feed
+ * peers, AS paths of 2-8 hops with occasional prepending and AS_SETs, and skewed community counts.
+ */
+struct CorpusOptions {
+  uint64_t seed = 1;
+  std::size_t peers = 32;
+  std::size_t prefixes = 20000;
+  std::size_t updates = 100000;
+  uint32_t start_time = 1600000000;
+};
+
+/* PEER_INDEX_TABLE followed by up to options.prefixes RIB_IPV4_UNICAST records in prefix order. */
+std::vector<uint8_t> make_table_dump_v2(const CorpusOptions& options);
+/* BGP4MP MESSAGE_AS4 UPDATEs with occasional STATE_CHANGE_AS4 records. */
+std::vector<uint8_t> make_bgp4mp(const CorpusOptions& options);
+
+bool write_raw(const std::string& path, const std::vector<uint8_t>& data);
+bool write_gzip(const std::string& path, const std::vector<uint8_t>& data);
+bool write_bzip2(const std::string& path, const std::vector<uint8_t>& data);
+
+/* Only uses the raw engine output, whose sequence is fixed by the standard. */
+class Random {
+public:
+  explicit Random(uint64_t seed) : engine_(seed) {}
+
+  uint32_t below(uint32_t n) { return uint32_t(engine_() % n); }
+  bool chance(uint32_t per_mille) { return below(1000) < per_mille; }
+  /* 1 + number of consecutive successes of a per_mille trial, capped at max. */
+  uint32_t geometric(uint32_t per_mille, uint32_t max) {
+    uint32_t n = 1;
+    while (n < max && chance(per_mille)) n++;
+    return n;
+  }
+
+private:
+  std::mt19937_64 engine_;
+};
+
+} // namespace bench
+} // namespace parsebgp
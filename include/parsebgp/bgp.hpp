@@ -1,4 +1,9 @@
 #pragma once
 
+#include <parsebgp/bgp/asn_kernels.hpp>
 #include <parsebgp/bgp/common.hpp>
+#include <parsebgp/bgp/community_index.hpp>
+#include <parsebgp/bgp/community_matcher.hpp>
+#include <parsebgp/bgp/intern.hpp>
+#include <parsebgp/bgp/message.hpp>
 #include <parsebgp/bgp/update.hpp>
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <parsebgp/bgp/common.hpp>
+#include <parsebgp/bgp/update.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/cpu.hpp>
+
+namespace parsebgp {
+namespace bgp {
+namespace asn_kernels {
+
+/*
+ * Vectorized predicates over arrays of AS numbers, such as PathAttributes::AsPathSegment::asns().
+ *
+ * Each kernel has a scalar, an AVX2 and an AVX-512 implementation. The widest one supported by the
+ * running CPU is picked on first use; set_isa() can force a narrower one, e.g. to compare them.
+ */
+
+using Isa = utils::Isa;
+
+/* Instruction set used by the kernels below. */
+Isa isa();
+/* Select the kernels to use, capped at utils::supported_isa(). Not safe during concurrent calls. */
+Isa set_isa(Isa isa);
+
+using Asns = utils::span<const uint32_t>;
+
+bool contains(Asns asns, uint32_t asn);
+/* Whether any of asns is in set. Meant for small sets; cost is O(asns.size() * set.size()). */
+bool contains_any(Asns asns, Asns set);
+/* Index of the first AS number for which bgp::Asn::is_public() is false, or asns.size(). */
+std::size_t find_non_public(Asns asns);
+/* Number of AS numbers equal to their predecessor, i.e. hops added by prepending. */
+std::size_t count_prepends(Asns asns);
+
+/* The same kernels applied to all segments of a path. */
+bool contains(const PathAttributes::AsPath& path, uint32_t asn);
+bool contains_any(const PathAttributes::AsPath& path, Asns set);
+bool has_non_public(const PathAttributes::AsPath& path);
+/* Prepends are only counted within AS_SEQUENCE segments. */
+std::size_t count_prepends(const PathAttributes::AsPath& path);
+
+/* Last AS of the path if it ends in a non-empty AS_SEQUENCE; unset for AS_SET or empty paths. */
+std::optional<uint32_t> origin(const PathAttributes::AsPath& path);
+
+} // namespace asn_kernels
+} // namespace bgp
+} // namespace parsebgp
@@ -3,6 +3,7 @@
 #include <cstdint>
 
 #include <parsebgp/utils.hpp>
+#include <parsebgp/utils/ip.hpp>
 
 extern "C" struct parsebgp_bgp_prefix;
 
@@ -115,6 +116,8 @@ public:
   SafiType safi_type() const;
   uint8_t len() const;
   utils::ipv6_view addr() const;
+  /* addr() and len() as a value, IPv4 or IPv6 by afi_type(). */
+  utils::IpPrefix ip_prefix() const;
 };
 
 class Asn {
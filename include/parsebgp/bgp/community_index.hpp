@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <parsebgp/bgp/update.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/bitmap.hpp>
+#include <parsebgp/utils/hash.hpp>
+
+namespace parsebgp {
+namespace bgp {
+
+/*
+ * Inverted index from community and large community values to the entries carrying them.
+ *
+ * Entry ids are chosen by the caller, typically a running counter over RIB entries or updates,
+ * which it maps back to (prefix, peer) on its side. Ids should be added in increasing order for
+ * cheap bitmap appends. Queries combine the per-value bitmaps with AND/OR.
+ */
+class CommunityIndex {
+public:
+  using EntryId = uint32_t;
+
+  struct LargeCommunityKey {
+    uint32_t global_admin;
+    uint32_t local_1;
+    uint32_t local_2;
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Allow implicit conversion from decoded value.
+    LargeCommunityKey(PathAttributes::LargeCommunity c)
+      : global_admin(c.global_admin), local_1(c.local_1), local_2(c.local_2) {}
+    LargeCommunityKey(uint32_t global_admin_, uint32_t local_1_, uint32_t local_2_)
+      : global_admin(global_admin_), local_1(local_1_), local_2(local_2_) {}
+
+    bool operator==(const LargeCommunityKey& rhs) const {
+      return global_admin == rhs.global_admin && local_1 == rhs.local_1 && local_2 == rhs.local_2;
+    }
+  };
+
+  /* Pack a community as it appears on the wire, i.e. asn in the upper 16 bits. */
+  static constexpr uint32_t community(uint16_t asn, uint16_t value) {
+    return uint32_t(asn) << 16 | value;
+  }
+
+  CommunityIndex() = default;
+
+  /* Index all communities and large communities of an entry. */
+  void add(EntryId id, PathAttributes attrs);
+
+  void add_community(EntryId id, uint32_t community);
+  void add_large_community(EntryId id, const LargeCommunityKey& community);
+
+  /* Entries carrying the value, or nullptr if none. */
+  const utils::Bitmap* find(uint32_t community) const;
+  const utils::Bitmap* find(const LargeCommunityKey& community) const;
+
+  /* Entries carrying all of the values (AND). */
+  utils::Bitmap all_of(utils::span<const uint32_t> communities) const;
+  utils::Bitmap all_of(utils::span<const LargeCommunityKey> communities) const;
+
+  /* Entries carrying at least one of the values (OR). */
+  utils::Bitmap any_of(utils::span<const uint32_t> communities) const;
+  utils::Bitmap any_of(utils::span<const LargeCommunityKey> communities) const;
+
+  std::size_t communities_size() const { return communities_.size(); }
+  std::size_t large_communities_size() const { return large_communities_.size(); }
+  std::size_t memory_usage() const;
+
+  void shrink_to_fit();
+  void clear();
+
+private:
+  struct LargeCommunityHash {
+    std::size_t operator()(const LargeCommunityKey& key) const {
+      return utils::Hasher::hash(&key, sizeof(key));
+    }
+  };
+
+  std::unordered_map<uint32_t, utils::Bitmap> communities_;
+  std::unordered_map<LargeCommunityKey, utils::Bitmap, LargeCommunityHash> large_communities_;
+};
+
+} // namespace bgp
+} // namespace parsebgp
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <parsebgp/bgp/update.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/cpu.hpp>
+
+namespace parsebgp {
+namespace bgp {
+
+/*
+ * Set of community and large community patterns matched against path attributes with SIMD.
+ *
+ * Patterns are compiled once into (mask, base, span) form, where a value matches if
+ * (value & mask) - base <= span as unsigned, so exact values, wildcards and ranges all cost the
+ * same compare. Matching runs over the raw arrays behind Communities::values() and
+ * LargeCommunities::values(), 8 (AVX2) or 16 (AVX-512) communities at a time.
+ *
+ * Community and large community patterns are numbered separately, each up to MAX_PATTERNS.
+ */
+class CommunityMatcher {
+public:
+  static constexpr std::size_t MAX_PATTERNS = 64;
+
+  /* Bit i is set if pattern i matched. */
+  using Matches = uint64_t;
+
+  struct Pattern {
+    uint32_t mask;
+    uint32_t base;
+    uint32_t span;
+
+    static constexpr Pattern exact(uint16_t asn, uint16_t value) {
+      return { 0xffffffff, uint32_t(asn) << 16 | value, 0 };
+    }
+    /* asn:* */
+    static constexpr Pattern any_value(uint16_t asn) {
+      return { 0xffffffff, uint32_t(asn) << 16, 0xffff };
+    }
+    /* *:value */
+    static constexpr Pattern any_asn(uint16_t value) { return { 0xffff, value, 0 }; }
+    /* asn:first-last, first <= last. */
+    static constexpr Pattern value_range(uint16_t asn, uint16_t first, uint16_t last) {
+      assert(first <= last);
+      return { 0xffffffff, uint32_t(asn) << 16 | first, uint32_t(last - first) };
+    }
+    /* first-last:*, first <= last. */
+    static constexpr Pattern asn_range(uint16_t first, uint16_t last) {
+      assert(first <= last);
+      return { 0xffffffff, uint32_t(first) << 16, (uint32_t(last - first) << 16) | 0xffff };
+    }
+
+    constexpr bool matches(uint32_t community) const {
+      return uint32_t((community & mask) - base) <= span;
+    }
+  };
+
+  /* Inclusive ranges for global_admin, local_1 and local_2. */
+  struct LargePattern {
+    std::array<uint32_t, 3> first;
+    std::array<uint32_t, 3> last;
+
+    static constexpr LargePattern exact(uint32_t global_admin, uint32_t local_1, uint32_t local_2) {
+      return { { global_admin, local_1, local_2 }, { global_admin, local_1, local_2 } };
+    }
+    /* global_admin:*:* */
+    static constexpr LargePattern any_local(uint32_t global_admin) {
+      return { { global_admin, 0, 0 }, { global_admin, 0xffffffff, 0xffffffff } };
+    }
+    /* global_admin:local_1:* */
+    static constexpr LargePattern any_local_2(uint32_t global_admin, uint32_t local_1) {
+      return { { global_admin, local_1, 0 }, { global_admin, local_1, 0xffffffff } };
+    }
+
+    constexpr bool matches(uint32_t global_admin, uint32_t local_1, uint32_t local_2) const {
+      return first[0] <= global_admin && global_admin <= last[0] && first[1] <= local_1 &&
+             local_1 <= last[1] && first[2] <= local_2 && local_2 <= last[2];
+    }
+  };
+
+  CommunityMatcher();
+
+  /* Add a pattern and return its index, at most MAX_PATTERNS - 1. */
+  std::size_t add(const Pattern& pattern);
+  std::size_t add(const LargePattern& pattern);
+
+  std::size_t size() const { return masks_.size(); }
+  std::size_t large_size() const { return large_bases_.size(); }
+
+  Matches match(utils::span<const uint32_t> communities) const;
+  /* Values as consecutive (global_admin, local_1, local_2) triplets. */
+  Matches match_large(utils::span<const uint32_t> large_communities) const;
+
+  Matches match(const PathAttributes::Communities& communities) const {
+    return match(communities.values());
+  }
+  Matches match(const PathAttributes::LargeCommunities& large_communities) const {
+    return match_large(large_communities.values());
+  }
+
+  /* Whether any community or large community pattern matches the attributes. */
+  bool any(const PathAttributes& attrs) const;
+
+  utils::Isa isa() const { return isa_; }
+  /* Force an implementation, capped at utils::supported_isa(). Return the one selected. */
+  utils::Isa set_isa(utils::Isa isa);
+
+private:
+  // Structure of arrays, so kernels can broadcast one field of a pattern at a time.
+  std::vector<uint32_t> masks_;
+  std::vector<uint32_t> bases_;
+  std::vector<uint32_t> spans_;
+
+  // Padded to 4 lanes for 128-bit groups; the fourth lane always matches.
+  std::vector<std::array<uint32_t, 4>> large_bases_;
+  std::vector<std::array<uint32_t, 4>> large_spans_;
+
+  utils::Isa isa_;
+};
+
+} // namespace bgp
+} // namespace parsebgp
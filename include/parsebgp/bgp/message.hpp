@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include <parsebgp/bgp/update.hpp>
+#include <parsebgp/utils.hpp>
+
+extern "C" struct parsebgp_bgp_msg;
+
+namespace parsebgp {
+namespace bgp {
+
+class Message : public utils::CPtrView<Message, parsebgp_bgp_msg*> {
+public:
+  class Type : public utils::EnumClass<Type> {
+  public:
+    enum Value : uint8_t {
+      OPEN = 1,
+      UPDATE = 2,
+      NOTIFICATION = 3,
+      KEEPALIVE = 4,
+      ROUTE_REFRESH = 5,
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    Type(Value value) : value_(value) {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    operator Value() const { return value_; }
+
+    Value value() const { return value_; }
+    bool is_valid() const {
+      switch (value_) {
+        case OPEN:
+        case UPDATE:
+        case NOTIFICATION:
+        case KEEPALIVE:
+        case ROUTE_REFRESH:
+          return true;
+      }
+      return false;
+    }
+    bool is_open() const { return value_ == OPEN; }
+    bool is_update() const { return value_ == UPDATE; }
+    bool is_notification() const { return value_ == NOTIFICATION; }
+    bool is_keepalive() const { return value_ == KEEPALIVE; }
+    bool is_route_refresh() const { return value_ == ROUTE_REFRESH; }
+
+  private:
+    Value value_;
+  };
+
+  // NOLINTNEXTLINE(google-explicit-constructor): Allow propagation of C pointer.
+  Message(CPtr cptr) : BaseView(cptr) {}
+
+  Type type() const;
+  uint16_t length() const;
+
+  Update to_update() const;
+};
+
+} // namespace bgp
+} // namespace parsebgp
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include <parsebgp/bgp/common.hpp>
 #include <parsebgp/utils.hpp>
@@ -139,6 +140,9 @@ private:
     Flags flags() const;
     Type type() const;
 
+    /* Undecoded attribute payload. Empty unless raw decoding is enabled for this type. */
+    utils::bytes_view raw() const;
+
   protected:
     using BaseView::cptr;
   };
@@ -151,6 +155,7 @@ private:
     using Base::Base;                                                                              \
     using Base::flags;                                                                             \
     using Base::type;                                                                              \
+    using Base::raw;                                                                               \
     ValueType value() const;                                                                       \
     operator ValueType() const;                                                                    \
   }
@@ -207,6 +212,8 @@ public:
     AsPathSegment(CPtr cptr) : BaseView(cptr) {}
 
     Type type() const;
+    /* Raw AS numbers of the segment, for the kernels in bgp/asn_kernels.hpp. */
+    utils::span<const uint32_t> asns() const;
 
   private:
     friend BaseRange;
@@ -226,6 +233,7 @@ public:
     using Base::Base;
     using Base::flags;
     using Base::type;
+    using Base::raw;
 
     uint8_t asns_count() const;
     bool asn_4_byte() const;
@@ -244,6 +252,7 @@ public:
     using Base::Base;
     using Base::flags;
     using Base::type;
+    using Base::raw;
     uint32_t asn() const;
     utils::ipv4_view addr() const;
   };
@@ -266,6 +275,10 @@ public:
     using Base::Base;
     using Base::flags;
     using Base::type;
+    using Base::raw;
+
+    /* Raw community values, asn in the upper 16 bits. */
+    utils::span<const uint32_t> values() const;
 
   private:
     friend BaseRange;
@@ -285,6 +298,10 @@ public:
     using Base::Base;
     using Base::flags;
     using Base::type;
+    using Base::raw;
+
+    /* Raw cluster IDs. */
+    utils::span<const uint32_t> values() const;
 
   private:
     friend BaseRange;
@@ -304,6 +321,7 @@ public:
     using Base::Base;
     using Base::flags;
     using Base::type;
+    using Base::raw;
 
     AfiType afi_type() const;
     SafiType safi_type() const;
@@ -327,6 +345,7 @@ public:
     using Base::Base;
     using Base::flags;
     using Base::type;
+    using Base::raw;
 
     AfiType afi_type() const;
     SafiType safi_type() const;
@@ -357,6 +376,10 @@ public:
     using Base::Base;
     using Base::flags;
     using Base::type;
+    using Base::raw;
+
+    /* Raw values as consecutive (global_admin, local_1, local_2) triplets. */
+    utils::span<const uint32_t> values() const;
 
   private:
     friend BaseRange;
@@ -426,8 +449,54 @@ public:
   bool has_large_communities() const;
   LargeCommunities large_communities() const;
 
+  /*
+   * 64-bit fingerprint of the whole attribute set, computed in a single pass over the attributes.
+   *
+   * Attributes are visited in type order so the fingerprint doesn't depend on the order they
+   * appeared on the wire. Payloads of attributes decoded with path_attr_raw are hashed as raw bytes,
+   * others through their decoded fields. NLRI carried in MP_REACH/MP_UNREACH don't contribute, so
+   * routes sharing attributes share fingerprints. Equal sets have equal fingerprints given the same
+   * Options for raw decoding.
+   */
+  uint64_t fingerprint() const;
+
+  /*
+   * Append the canonical encoding of the set: the fields fingerprint() hashes, in the same order,
+   * with integers as their host order bytes. fingerprint() feeds integers to the hasher as whole
+   * words instead, so it is not a hash of these bytes, but equal encodings have equal fingerprints.
+   */
+  void append_canonical(std::vector<uint8_t>& out) const;
+
   // TODO: Rest of path attributes
 };
 
+class Nlris
+  : public utils::CPtrView<Nlris, parsebgp_bgp_update_nlris*>
+  , public utils::CPtrRange<Nlris, Prefix> {
+public:
+  // NOLINTNEXTLINE(google-explicit-constructor): Allow propagation of C pointer.
+  Nlris(CPtr cptr) : BaseView(cptr) {}
+
+private:
+  friend BaseRange;
+  ElementCPtr range_data() const;
+  std::size_t range_size() const;
+  static ElementCPtr range_add(const ElementCPtr ptr, std::ptrdiff_t n);
+  static ElementCPtr range_subtract(const ElementCPtr ptr, std::ptrdiff_t n);
+  static std::ptrdiff_t range_difference(const ElementCPtr lhs, const ElementCPtr rhs);
+};
+
+class Update : public utils::CPtrView<Update, parsebgp_bgp_update*> {
+public:
+  // NOLINTNEXTLINE(google-explicit-constructor): Allow propagation of C pointer.
+  Update(CPtr cptr) : BaseView(cptr) {}
+
+  /* IPv4 unicast withdrawals. Others are carried in the MP_UNREACH_NLRI attribute. */
+  Nlris withdrawn() const;
+  PathAttributes path_attributes() const;
+  /* IPv4 unicast announcements. Others are carried in the MP_REACH_NLRI attribute. */
+  Nlris announced() const;
+};
+
 } // namespace bgp
 } // namespace parsebgp
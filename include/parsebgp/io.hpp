@@ -2,19 +2,36 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 #include <parsebgp.hpp>
+#include <parsebgp/io/checkpoint.hpp>
+#include <parsebgp/io/stats.hpp>
 #include <parsebgp/utils.hpp>
-
-extern "C" typedef struct gzFile_s* gzFile; // NOLINT(modernize-use-using)
+#include <parsebgp/utils/probe.hpp>
 
 namespace parsebgp {
 namespace io {
 
-class GzipStream : public utils::CPtrView<GzipStream, gzFile> {
+/*
+ * Gzip file inflated with zlib, passing through files that aren't gzip like gzread() does.
+ *
+ * Every ACCESS_POINT_SPAN bytes of output it keeps an access point at the next deflate block
+ * boundary: the compressed bit offset and the 32 KiB window. Checkpoints resume from the latest one
+ * at or before their offset, so resuming inflates at most about a span plus the reader's buffer
+ * instead of the whole file up to the offset.
+ *
+ * Points are kept for the last ACCESS_POINT_WINDOW bytes of output, about 1 MiB of windows. A
+ * checkpoint lags the output by the bytes buffered in its reader, so one taken while the reader's
+ * buffer is larger finds no point and its restore() inflates from the start of the file.
+ */
+class GzipStream : public utils::CPtrView<GzipStream, FILE*> {
 public:
   class Status : public utils::EnumClass<Status> {
   public:
@@ -66,12 +83,17 @@ public:
     Value value_;
   };
 
+  static constexpr uint64_t ACCESS_POINT_SPAN = 1 << 20;
+  // Twice Reader::RESYNC_MAX_LENGTH, the largest buffer plausible records grow a reader to.
+  static constexpr uint64_t ACCESS_POINT_WINDOW = 1 << 25;
+  static constexpr std::size_t MAX_ACCESS_POINTS = ACCESS_POINT_WINDOW / ACCESS_POINT_SPAN + 1;
+
   GzipStream(utils::string_view path, size_t internal_buf_size);
   ~GzipStream();
   GzipStream(const GzipStream&) = delete;
-  GzipStream(GzipStream&&) = default;
+  GzipStream(GzipStream&&) noexcept;
   GzipStream& operator=(const GzipStream&) = delete;
-  GzipStream& operator=(GzipStream&&) = default;
+  GzipStream& operator=(GzipStream&&) noexcept;
 
   size_t read(void* buffer, size_t length);
   bool good();
@@ -80,7 +102,15 @@ public:
   Status status() const;
   void clear_status();
 
+  /* Restart state for uncompressed offset, which must not be past the bytes read so far. */
+  std::vector<uint8_t> access_point(uint64_t offset) const;
+  /* Continue a freshly opened stream from offset, using the state from access_point(). */
+  bool restore(uint64_t offset, utils::bytes_view access_point);
+
 private:
+  struct Inflate;
+
+  std::unique_ptr<Inflate> inflate_;
   Status status_;
 };
 
@@ -165,6 +195,71 @@ public:
   Status status() const;
   void clear_status();
 
+  /*
+   * libbz2 can't start decompressing mid-stream, so there is no restart state and restore()
+   * decompresses from the bytes read so far up to offset.
+   */
+  std::vector<uint8_t> access_point(uint64_t offset) const;
+  bool restore(uint64_t offset, utils::bytes_view access_point);
+
+private:
+  Status status_;
+  uint64_t offset_ = 0; // Uncompressed bytes read.
+};
+
+/* Uncompressed file read through stdio. */
+class FileStream : public utils::CPtrView<FileStream, FILE*> {
+public:
+  class Status : public utils::EnumClass<Status> {
+  public:
+    enum Value {
+      OK = 0,
+      STREAM_END = 1,
+      ERRNO = -1,
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    Status(Value value = OK) : value_(value) {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    operator Value() const { return value_; }
+
+    Value value() const { return value_; }
+    bool is_valid() const {
+      switch (value_) {
+        case OK:
+        case STREAM_END:
+        case ERRNO:
+          return true;
+      }
+      return false;
+    }
+    bool is_ok() const { return value_ == OK; }
+    bool is_stream_end() const { return value_ == STREAM_END; }
+    bool is_errno() const { return value_ == ERRNO; }
+
+  private:
+    Value value_;
+  };
+
+  explicit FileStream(utils::string_view path);
+  ~FileStream();
+  FileStream(const FileStream&) = delete;
+  FileStream(FileStream&&) = default;
+  FileStream& operator=(const FileStream&) = delete;
+  FileStream& operator=(FileStream&&) = default;
+
+  size_t read(void* buffer, size_t length);
+  bool good();
+  bool eof();
+  bool bad() const;
+  Status status() const;
+  void clear_status();
+
+  /* No restart state is needed, restore() seeks to offset. */
+  std::vector<uint8_t> access_point(uint64_t offset) const;
+  bool restore(uint64_t offset, utils::bytes_view access_point);
+
 private:
   Status status_;
 };
@@ -226,6 +321,7 @@ public:
       auto out = new_buf.prepare_write();
       assert(in.size() <= out.size());
       std::copy(in.data(), in.data() + in.size(), out.data());
+      new_buf.commit_write(in.size());
       *this = std::move(new_buf);
     }
     return true;
@@ -321,7 +417,7 @@ public:
 
   parsebgp::Error to_decoder_error() const {
     assert(is_decoder_error());
-    return inner_error_.stream_;
+    return inner_error_.decoder_;
   }
 
 private:
@@ -343,6 +439,62 @@ static ReaderTransformInput<Stream> identity_transform(ReaderTransformInput<Stre
   return msg;
 };
 
+/* What an MRT Reader does when a record fails to decode as INVALID_MSG or TRUNCATED_MSG. */
+class Resync : public utils::EnumClass<Resync> {
+public:
+  enum Value {
+    NONE,        // Stop with the decoder error.
+    SKIP_RECORD, // Skip the record by its header length if that looks sane, otherwise stop.
+    SCAN,        // Skip by header length, or scan forward to the next plausible MRT header.
+  };
+
+  // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+  Resync(Value value = NONE) : value_(value) {}
+
+  // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+  operator Value() const { return value_; }
+
+  Value value() const { return value_; }
+  bool is_none() const { return value_ == NONE; }
+  bool is_skip_record() const { return value_ == SKIP_RECORD; }
+  bool is_scan() const { return value_ == SCAN; }
+
+private:
+  Value value_;
+};
+
+/* Range [start, end) of the uncompressed stream read by one shard of a file, see Reader. */
+struct ByteRange {
+  uint64_t start = 0;
+  uint64_t end = std::numeric_limits<uint64_t>::max();
+
+  /* index-th of count adjacent ranges of about the same length covering size bytes. */
+  static ByteRange shard(uint64_t size, uint64_t index, uint64_t count) {
+    assert(index < count);
+    auto boundary = [&](uint64_t i) { return size / count * i + size % count * i / count; };
+    return { boundary(index), boundary(index + 1) };
+  }
+};
+
+/* Bytes dropped by resynchronization, at offsets of the uncompressed stream. */
+struct SkippedRange {
+  uint64_t offset;
+  uint64_t length;
+  /* Error which caused the skip; PARTIAL_MSG for a truncated end of stream. */
+  parsebgp::Error error;
+};
+
+/*
+ * USDT probes, see parsebgp/utils/probe.hpp:
+ * - fill_start(space), fill_end(bytes): around each Stream::read() into the buffer.
+ * - buffer_grow(old_capacity, new_capacity): buffer doubled for a message larger than it.
+ * - decode_start(available): before each decode attempt, with the bytes buffered.
+ * - decode_end(type, subtype, length): message decoded. MRT type and subtype for MRT readers;
+ *   the parsebgp message type and 0 for others.
+ * - decode_partial(available): attempt ran out of buffered bytes and will be retried.
+ * - decode_error(error, available): attempt failed with parsebgp::Error.
+ * - resync(offset, length): bytes skipped to recover from a decoder error, see set_resync().
+ */
 template<typename Stream, Message::Type::Value message_type, typename Transformer>
 class Reader {
 public:
@@ -388,32 +540,156 @@ public:
     , options_(std::move(options))
     , transformer_(std::forward<Transformer>(transformer)) {
     if (buffer_.is_null()) status_ = Status::MEMORY_FAILURE;
+    stats_.capacity(buffer_.capacity());
+  }
+
+  /*
+   * Resume from checkpoint, see checkpoint(). stream must be freshly opened on the same file and of
+   * the same type as the one the checkpoint was taken from.
+   */
+  Reader(Stream&& stream,
+         const Checkpoint& checkpoint,
+         Options options = {},
+         size_t buffer_size = 32678,
+         Transformer transformer = identity_transform<Stream>)
+    : Reader(std::forward<Stream>(stream),
+             std::move(options),
+             buffer_size,
+             std::forward<Transformer>(transformer)) {
+    if (!status_.is_ok()) return;
+    if (!stream_.restore(checkpoint.offset, checkpoint.stream)) {
+      status_ = stream_.status();
+      return;
+    }
+    offset_ = checkpoint.offset;
+    if (checkpoint.last_timestamp) {
+      last_timestamp_ = *checkpoint.last_timestamp;
+      has_timestamp_ = true;
+    }
+    if constexpr (message_type == Message::Type::MRT) {
+      if (!checkpoint.peer_index.empty()) {
+        auto& raw = checkpoint.peer_index;
+        message_.clear();
+        auto ret = message_.decode(options_, message_type, raw.data(), raw.size());
+        if (!ret) {
+          status_ = ret.error();
+          return;
+        }
+        raw_message_ = raw;
+        capture_peer_index();
+        message_.clear();
+        raw_message_ = {};
+      }
+    }
+  }
+
+  /*
+   * Read the MRT records starting in range, e.g. one of several processes sharing a large file.
+   * The reader skips to the first record at or after range.start, taken as the first offset where
+   * SYNC_CHAIN consecutive headers are plausible (see set_resync()), and stops after the last
+   * record starting before range.end, which may extend past it. Adjacent ranges thus decode every
+   * record exactly once.
+   *
+   * Streams which can't seek, like Bzip2Stream and gzip files, read and drop the bytes before
+   * range.start; see their restore(). A PEER_INDEX_TABLE starting the stream is loaded into
+   * peer_table() first, so the RIB entries of every range resolve their peers. A range starting
+   * past the end of the stream finishes without records.
+   */
+  Reader(Stream&& stream,
+         ByteRange range,
+         Options options = {},
+         size_t buffer_size = 32678,
+         Transformer transformer = identity_transform<Stream>)
+    : Reader(std::forward<Stream>(stream),
+             std::move(options),
+             buffer_size,
+             std::forward<Transformer>(transformer)) {
+    static_assert(message_type == Message::Type::MRT, "Byte ranges require MRT records.");
+    end_ = range.end;
+    if (!status_.is_ok() || range.start == 0) return;
+    load_leading_peer_index();
+    if (!status_.not_finished()) return;
+    sync_pending_ = true;
+    auto buffered = buffer_.available_read();
+    if (range.start <= buffered) {
+      consume(range.start);
+      return;
+    }
+    consume(buffered);
+    if (status_.is_stream_finished() || !stream_.restore(range.start, {})) {
+      if (stream_.bad()) {
+        status_ = stream_.status();
+      } else {
+        status_ = Status::FINISHED;
+      }
+      return;
+    }
+    offset_ = range.start;
   }
 
   void decode_one() {
+    if (status_.not_finished() && offset_ >= end_) status_ = Status::FINISHED;
     if (status_.not_finished()) {
       auto out = buffer_.prepare_read();
       bool already_got_partial = false;
       while (true) {
         message_.clear();
+        PARSEBGP_CPP_PROBE1(decode_start, out.size());
+        auto decode_start = stats_.now();
         auto ret = message_.decode(options_, message_type, out.data(), out.size());
+        stats_.decode(decode_start);
         if (ret) {
-          buffer_.commit_read(ret.value());
+          raw_message_ = { out.data(), ret.value() };
+          PARSEBGP_CPP_PROBE3(decode_end,
+                              probe_type(raw_message_),
+                              probe_subtype(raw_message_),
+                              raw_message_.size());
+          consume(ret.value());
+          stats_.record(ret.value());
+          if constexpr (message_type == Message::Type::MRT) {
+            stats_.record_mrt(message_);
+            capture_peer_index();
+            last_timestamp_ = load32(raw_message_.data());
+            has_timestamp_ = true;
+          }
           break;
+        } else if (ret.error().is_partial_msg() && implausible_partial(out)) {
+          // Don't buffer up to a corrupt length, possibly the rest of the stream.
+          if (!resync(Error::INVALID_MSG)) {
+            PARSEBGP_CPP_PROBE2(decode_error, int(Error::INVALID_MSG), out.size());
+            status_ = parsebgp::Error(Error::INVALID_MSG);
+            break;
+          }
+          if (!status_.not_finished()) break;
+          already_got_partial = false;
+          out = buffer_.prepare_read();
+          continue;
         } else if (ret.error().is_partial_msg() && !status_.is_stream_finished()) {
+          PARSEBGP_CPP_PROBE1(decode_partial, out.size());
+          stats_.partial();
           if (!already_got_partial) {
             already_got_partial = true;
           } else {
             constexpr size_t growth_factor = 2;
+            PARSEBGP_CPP_PROBE2(
+              buffer_grow, buffer_.capacity(), buffer_.capacity() * growth_factor);
             buffer_.reserve(buffer_.capacity() * growth_factor);
+            stats_.capacity(buffer_.capacity());
           }
           fill_buffer();
+          if (!status_.not_finished()) break;
           out = buffer_.prepare_read();
           continue;
         } else if (ret.error().is_partial_msg() && out.size() == 0) {
           status_ = Status::FINISHED;
           break;
+        } else if (resync(ret.error())) {
+          if (!status_.not_finished()) break;
+          already_got_partial = false;
+          out = buffer_.prepare_read();
+          continue;
         } else {
+          PARSEBGP_CPP_PROBE2(decode_error, int(ret.error().value()), out.size());
           status_ = ret.error();
           break;
         }
@@ -424,7 +700,8 @@ public:
   TransformOutput message() {
     if (!started_) {
       started_ = true;
-      fill_buffer();
+      if (status_.is_ok()) fill_buffer();
+      if (sync_pending_) sync();
       if (status_.not_finished()) decode_one();
     }
     if (status_.not_finished()) return transformer_(std::cref(message_));
@@ -437,17 +714,301 @@ public:
     return new_msg;
   }
 
+  /*
+   * Exchange the current message with msg, like release_message() but handing the reader a spent
+   * message whose allocations the next decode reuses. message() returns the spent message until
+   * decode_one().
+   */
+  void swap_message(Message& msg) { swap(msg, message_); }
+
+  /*
+   * Undecoded bytes of the current message, e.g. for io::MrtWriter::write(). They point into the
+   * reader's buffer and are only valid until the next decode_one().
+   */
+  utils::bytes_view raw_message() const { return raw_message_; }
+
   Status status() const { return status_; }
   // void clear_status() const { status_ = Status::OK; }
 
+  /* Offset in the uncompressed stream of the first byte not consumed by decoded messages. */
+  uint64_t offset() const { return offset_; }
+
+  /*
+   * State for resuming after the current message with the Checkpoint constructor, e.g. to restart
+   * a long job after a crash. Cheap enough to take every few thousand messages.
+   *
+   * For GzipStream the checkpoint holds a restart point only while the reader's buffer fits in
+   * GzipStream::ACCESS_POINT_WINDOW; past that, resuming inflates from the start of the file.
+   */
+  Checkpoint checkpoint() const {
+    Checkpoint checkpoint;
+    checkpoint.offset = offset_;
+    checkpoint.stream = stream_.access_point(offset_);
+    checkpoint.peer_index = peer_index_raw_;
+    if (has_timestamp_) checkpoint.last_timestamp = last_timestamp_;
+    return checkpoint;
+  }
+
+  /*
+   * Opt into recovering from corrupt records instead of stopping, for MRT readers only. Skipped
+   * bytes are reported by skipped(); adjacent skips are merged into one range.
+   *
+   * A header is plausible with a known MRT type and subtype, a length of at most
+   * RESYNC_MAX_LENGTH and a timestamp at most RESYNC_MAX_TIME_GAP seconds after the last decoded
+   * record. A truncated record at the end of the stream is skipped as well.
+   */
+  void set_resync(Resync resync) { resync_ = resync; }
+  Resync resync() const { return resync_; }
+  const std::vector<SkippedRange>& skipped() const { return skipped_; }
+
+  static constexpr uint32_t RESYNC_MAX_LENGTH = 1 << 24;
+  static constexpr uint32_t RESYNC_MAX_TIME_GAP = 86400;
+  static constexpr size_t SYNC_CHAIN = 4;
+
+#ifdef PARSEBGP_CPP_STATS_ENABLED
+  /* Per-stage counters since construction. Only available with PARSEBGP_CPP_STATS_ENABLED. */
+  const ReaderStats& stats() const { return stats_.stats(); }
+#endif
+
+  /*
+   * Latest PEER_INDEX_TABLE seen by an MRT reader, for resolving RibEntry::peer_index() of the
+   * following RIB records. Empty for other readers.
+   */
+  const mrt::table_dump_v2::PeerTable& peer_table() const { return peer_table_; }
+
   Iterator begin() { return Iterator(this); }
   Sentinel end() { return {}; }
 
 private:
+  void capture_peer_index() {
+    auto msg = message_.to_mrt();
+    if (!msg.type().is_table_dump_v2()) return;
+    auto table_dump_v2 = msg.to_table_dump_v2();
+    if (table_dump_v2.subtype().is_peer_index_table()) {
+      peer_table_.load(table_dump_v2.to_peer_index());
+      peer_index_raw_.assign(raw_message_.begin(), raw_message_.end());
+    }
+  }
+
+  /*
+   * Decode a PEER_INDEX_TABLE at the start of the stream into peer_table(), leaving the bytes
+   * buffered. Anything else there is left alone.
+   */
+  void load_leading_peer_index() {
+    constexpr size_t header_size = 12;
+    fill_buffer();
+    while (status_.not_finished()) {
+      auto out = buffer_.prepare_read();
+      if (out.size() >= header_size) {
+        auto type = mrt::Message::Type::Value(load16(out.data() + 4));
+        auto subtype = mrt::table_dump_v2::Message::Subtype::Value(load16(out.data() + 6));
+        if (type != mrt::Message::Type::TABLE_DUMP_V2 ||
+            subtype != mrt::table_dump_v2::Message::Subtype::PEER_INDEX_TABLE ||
+            load32(out.data() + 8) > RESYNC_MAX_LENGTH) {
+          break;
+        }
+      }
+      message_.clear();
+      auto ret = message_.decode(options_, message_type, out.data(), out.size());
+      if (ret) {
+        raw_message_ = { out.data(), ret.value() };
+        capture_peer_index();
+        break;
+      }
+      if (!ret.error().is_partial_msg() || !status_.is_ok()) break;
+      if (!buffer_.available_write()) {
+        constexpr size_t growth_factor = 2;
+        PARSEBGP_CPP_PROBE2(buffer_grow, buffer_.capacity(), buffer_.capacity() * growth_factor);
+        buffer_.reserve(buffer_.capacity() * growth_factor);
+        stats_.capacity(buffer_.capacity());
+      }
+      fill_buffer();
+    }
+    message_.clear();
+    raw_message_ = {};
+  }
+
+  void consume(size_t bytes) {
+    buffer_.commit_read(bytes);
+    offset_ += bytes;
+  }
+
+  static uint16_t load16(const uint8_t* p) { return uint16_t(p[0] << 8 | p[1]); }
+  static uint32_t load32(const uint8_t* p) { return uint32_t(load16(p)) << 16 | load16(p + 2); }
+
+  bool plausible_header(const uint8_t* header) const {
+    return plausible_header(header, has_timestamp_, last_timestamp_);
+  }
+
+  bool plausible_header(const uint8_t* header, bool has_previous, uint32_t previous) const {
+    auto type = mrt::Message::Type::Value(load16(header + 4));
+    auto subtype = load16(header + 6);
+    auto length = load32(header + 8);
+    auto timestamp = load32(header);
+    if (!mrt::Message::Type(type).is_valid()) return false;
+    switch (type) {
+      case mrt::Message::Type::TABLE_DUMP:
+        if (subtype < 1 || subtype > 2) return false; // AFI
+        break;
+      case mrt::Message::Type::TABLE_DUMP_V2:
+        if (subtype < 1 || subtype > 12) return false; // Up to RIB_GENERIC_ADDPATH (RFC 8050).
+        break;
+      case mrt::Message::Type::BGP4MP:
+      case mrt::Message::Type::BGP4MP_ET:
+        if (subtype > 11) return false;
+        break;
+      default:
+        break;
+    }
+    if (length == 0 || length > RESYNC_MAX_LENGTH) return false;
+    return !has_previous || (timestamp >= previous && timestamp - previous <= RESYNC_MAX_TIME_GAP);
+  }
+
+  /*
+   * Whether a partial message in out starts with a header resync would reject for its type,
+   * subtype or length. Its timestamp is not checked: where the buffer ends says nothing about the
+   * record, which may well be valid and only wait for the next refill.
+   */
+  bool implausible_partial(utils::bytes_view out) const {
+    if constexpr (message_type != Message::Type::MRT) return false;
+    constexpr size_t header_size = 12;
+    return !resync_.is_none() && out.size() >= header_size &&
+           !plausible_header(out.data(), false, 0);
+  }
+
+  /* Drop up to bytes, reading more as needed. */
+  void discard(uint64_t bytes) {
+    while (bytes) {
+      auto out = buffer_.prepare_read();
+      if (out.empty()) {
+        if (!status_.is_ok()) return;
+        fill_buffer();
+        continue;
+      }
+      auto n = size_t(std::min<uint64_t>(bytes, out.size()));
+      consume(n);
+      bytes -= n;
+    }
+  }
+
+  /* Drop bytes up to the next plausible header, or all but the last few bytes of the stream. */
+  void scan() {
+    constexpr size_t header_size = 12;
+    while (true) {
+      auto out = buffer_.prepare_read();
+      if (out.size() < header_size) {
+        if (!status_.is_ok()) return;
+        fill_buffer();
+        continue;
+      }
+      for (size_t i = 0; i + header_size <= out.size(); i++) {
+        if (plausible_header(out.data() + i)) {
+          consume(i);
+          return;
+        }
+      }
+      consume(out.size() - header_size + 1);
+    }
+  }
+
+  /*
+   * Whether out starts with SYNC_CHAIN plausible headers linked by their lengths, or fewer ending
+   * exactly at the end of the stream. Return -1 if more bytes are needed to tell.
+   */
+  int plausible_chain(utils::bytes_view out) const {
+    constexpr size_t header_size = 12;
+    bool has_previous = false;
+    uint32_t previous = 0;
+    uint64_t pos = 0;
+    for (size_t n = 0; n < SYNC_CHAIN; n++) {
+      bool finished = status_.is_stream_finished();
+      if (pos == out.size() && finished) return n > 0;
+      if (pos > out.size() || out.size() - pos < header_size) return finished ? 0 : -1;
+      auto header = out.data() + pos;
+      if (!plausible_header(header, has_previous, previous)) return 0;
+      has_previous = true;
+      previous = load32(header);
+      pos += header_size + uint64_t(load32(header + 8));
+    }
+    return 1;
+  }
+
+  /* Drop bytes up to the first record of a byte range, see the ByteRange constructor. */
+  void sync() {
+    sync_pending_ = false;
+    while (true) {
+      auto out = buffer_.prepare_read();
+      int chain = plausible_chain(out);
+      if (chain > 0) return;
+      if (chain == 0) {
+        if (out.empty()) return;
+        consume(1);
+        continue;
+      }
+      if (!status_.is_ok()) return;
+      if (!buffer_.available_write()) {
+        // The chain spans more than the buffer.
+        constexpr size_t growth_factor = 2;
+        PARSEBGP_CPP_PROBE2(buffer_grow, buffer_.capacity(), buffer_.capacity() * growth_factor);
+        buffer_.reserve(buffer_.capacity() * growth_factor);
+        stats_.capacity(buffer_.capacity());
+      }
+      fill_buffer();
+    }
+  }
+
+  /* Skip past a record which failed with error. Return false if it was left in place. */
+  bool resync(parsebgp::Error error) {
+    if constexpr (message_type != Message::Type::MRT) return false;
+    if (resync_.is_none()) return false;
+    if (!error.is_invalid_msg() && !error.is_truncated_msg() && !error.is_partial_msg()) {
+      return false;
+    }
+
+    constexpr size_t header_size = 12;
+    uint64_t start = offset_;
+    auto out = buffer_.prepare_read();
+    if (error.is_partial_msg()) {
+      // Only reached at the end of the stream.
+      discard(out.size());
+    } else if (out.size() >= header_size && plausible_header(out.data())) {
+      discard(header_size + uint64_t(load32(out.data() + 8)));
+      if (resync_.is_scan()) scan();
+    } else if (resync_.is_scan()) {
+      discard(1);
+      scan();
+    } else {
+      return false;
+    }
+
+    PARSEBGP_CPP_PROBE2(resync, start, offset_ - start);
+    if (!skipped_.empty() && skipped_.back().offset + skipped_.back().length == start) {
+      skipped_.back().length += offset_ - start;
+    } else {
+      skipped_.push_back({ start, offset_ - start, error });
+    }
+    return true;
+  }
+
+  /* Message type of a raw message for probes, without going through the decoded message. */
+  static uint16_t probe_type(utils::bytes_view raw) {
+    if constexpr (message_type == Message::Type::MRT) return uint16_t(raw[4] << 8 | raw[5]);
+    return uint16_t(message_type);
+  }
+
+  static uint16_t probe_subtype(utils::bytes_view raw) {
+    if constexpr (message_type == Message::Type::MRT) return uint16_t(raw[6] << 8 | raw[7]);
+    return 0;
+  }
+
   void fill_buffer() {
     assert(status_.is_ok());
     auto in = buffer_.prepare_write();
+    PARSEBGP_CPP_PROBE1(fill_start, in.size());
+    auto read_start = stats_.now();
     auto bytes_read = stream_.read(in.data(), in.size());
+    stats_.read(read_start, bytes_read);
+    PARSEBGP_CPP_PROBE1(fill_end, bytes_read);
     if (stream_.good()) {
       buffer_.commit_write(bytes_read);
     } else if (stream_.eof()) {
@@ -464,7 +1025,18 @@ private:
   Buffer buffer_;
   Options options_;
   Message message_;
+  utils::bytes_view raw_message_;
+  uint64_t offset_ = 0;
+  uint64_t end_ = std::numeric_limits<uint64_t>::max();
+  bool sync_pending_ = false;
   Status status_;
+  Resync resync_;
+  std::vector<SkippedRange> skipped_;
+  uint32_t last_timestamp_ = 0;
+  bool has_timestamp_ = false;
+  mrt::table_dump_v2::PeerTable peer_table_;
+  std::vector<uint8_t> peer_index_raw_;
+  ReaderStatsRecorder stats_;
   std::reference_wrapper<std::remove_reference_t<Transformer>> transformer_;
 };
 
@@ -484,5 +1056,26 @@ MrtReader<Stream> mrt_reader(Stream&& stream, Options options = {}, size_t buffe
     std::forward<Stream>(stream), std::move(options), buffer_size, mrt_transform<Stream>);
 }
 
+template<typename Stream>
+MrtReader<Stream> mrt_reader(Stream&& stream,
+                             ByteRange range,
+                             Options options = {},
+                             size_t buffer_size = 32678) {
+  return MrtReader<Stream>(
+    std::forward<Stream>(stream), range, std::move(options), buffer_size, mrt_transform<Stream>);
+}
+
+template<typename Stream>
+MrtReader<Stream> mrt_reader(Stream&& stream,
+                             const Checkpoint& checkpoint,
+                             Options options = {},
+                             size_t buffer_size = 32678) {
+  return MrtReader<Stream>(std::forward<Stream>(stream),
+                           checkpoint,
+                           std::move(options),
+                           buffer_size,
+                           mrt_transform<Stream>);
+}
+
 } // namespace io
 } // namespace parsebgp
@@ -0,0 +1,374 @@
+#pragma once
+
+/*
+ * Coroutine based readers multiplexed on an epoll loop. Requires C++20 in the including translation
+ * unit; the library itself stays C++17 since everything here is header only.
+ *
+ * Each EventLoop is single threaded. To use a few threads, run one loop per thread and spread the
+ * sources over them.
+ *
+ *   io::EventLoop loop;
+ *   auto tail = [&](int fd) -> io::Task<void> {
+ *     io::AsyncReader<parsebgp::Message::Type::BMP> reader(loop, fd);
+ *     while (auto msg = co_await reader.next_message()) {
+ *       ... msg->get() ...
+ *     }
+ *   };
+ *   for (int fd : sockets) loop.spawn(tail(fd));
+ *   loop.run();
+ */
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "parsebgp/io/async.hpp requires C++20 coroutines."
+#endif
+
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <fcntl.h>
+#include <functional>
+#include <list>
+#include <optional>
+#include <sys/epoll.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+#include <parsebgp.hpp>
+#include <parsebgp/io.hpp>
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace io {
+
+template<typename T>
+class Task;
+
+//==============================================================================
+// io::Task
+//==============================================================================
+
+class TaskPromiseBase {
+public:
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  /* Resume the awaiting coroutine if any, otherwise stay suspended for the owner to destroy. */
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      auto continuation = handle.promise().continuation_;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  // Errors are reported through return values, like the rest of the library.
+  void unhandled_exception() noexcept { std::terminate(); }
+
+private:
+  template<typename T>
+  friend class Task;
+  std::coroutine_handle<> continuation_;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+  Task<T> get_return_object();
+  void return_value(T value) { value_.emplace(std::move(value)); }
+
+private:
+  friend class Task<T>;
+  std::optional<T> value_;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+  Task<void> get_return_object();
+  void return_void() {}
+};
+
+/*
+ * Lazily started coroutine returning T. Awaiting it runs it to completion within the awaiting
+ * coroutine; top level tasks are started by EventLoop::spawn().
+ */
+template<typename T>
+class Task {
+public:
+  using promise_type = TaskPromise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+  Task(const Task&) = delete;
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(const Task&) = delete;
+  Task& operator=(Task&& other) noexcept {
+    if (handle_) handle_.destroy();
+    handle_ = std::exchange(other.handle_, {});
+    return *this;
+  }
+
+  bool done() const { return !handle_ || handle_.done(); }
+
+  bool await_ready() const { return done(); }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+    handle_.promise().continuation_ = awaiting;
+    return handle_;
+  }
+  T await_resume() {
+    if constexpr (!std::is_void_v<T>) return std::move(*handle_.promise().value_);
+  }
+
+private:
+  friend class TaskPromise<T>;
+  friend class EventLoop;
+  explicit Task(Handle handle) : handle_(handle) {}
+
+  Handle handle_;
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+  return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+//==============================================================================
+// io::EventLoop
+//==============================================================================
+
+/* Single threaded epoll loop resuming coroutines waiting for readable file descriptors. */
+class EventLoop {
+public:
+  EventLoop() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {}
+
+  ~EventLoop() {
+    tasks_.clear();
+    if (epoll_fd_ != -1) ::close(epoll_fd_);
+  }
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  bool is_null() const { return epoll_fd_ == -1; }
+
+  /* Start task, which runs until its first suspension, and keep it until it finishes. */
+  void spawn(Task<void> task) {
+    tasks_.push_back(std::move(task));
+    tasks_.back().handle_.resume();
+  }
+
+  struct Readable {
+    EventLoop& loop;
+    int fd;
+
+    bool await_ready() const { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) { return loop.watch(fd, handle); }
+    void await_resume() const {}
+  };
+
+  /*
+   * Suspend until fd is readable, closed or failed. Returns at once for descriptors epoll does not
+   * support, such as regular files, which never block anyway.
+   */
+  Readable readable(int fd) { return { *this, fd }; }
+
+  /* Dispatch events until all spawned tasks finish or stop() is called. False on epoll failure. */
+  bool run() {
+    constexpr int max_events = 64;
+    epoll_event events[max_events];
+    stopped_ = false;
+    while (!stopped_) {
+      tasks_.remove_if([](const Task<void>& task) { return task.done(); });
+      if (tasks_.empty() || !waiting_) break;
+      int n = epoll_wait(epoll_fd_, events, max_events, -1);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      for (int i = 0; i < n; i++) {
+        waiting_--;
+        std::coroutine_handle<>::from_address(events[i].data.ptr).resume();
+      }
+    }
+    return true;
+  }
+
+  /* Make run() return after the current batch of events. */
+  void stop() { stopped_ = true; }
+
+private:
+  bool watch(int fd, std::coroutine_handle<> handle) {
+    // One shot, so a descriptor is only ever owned by the coroutine that last waited on it.
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = handle.address();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0 ||
+        (errno == ENOENT && epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0)) {
+      waiting_++;
+      return true;
+    }
+    return false;
+  }
+
+  int epoll_fd_;
+  std::list<Task<void>> tasks_;
+  std::size_t waiting_ = 0;
+  bool stopped_ = false;
+};
+
+//==============================================================================
+// io::AsyncReader
+//==============================================================================
+
+/*
+ * Push based counterpart of Reader over a raw file descriptor, such as a socket or pipe. Instead of
+ * blocking in read(), next_message() suspends on the loop until more bytes arrive.
+ *
+ * Stream errors are reported as FileStream::Status::ERRNO, with errno left as set by read().
+ */
+template<Message::Type::Value message_type>
+class AsyncReader {
+public:
+  using Buffer = MirroredRingBuffer;
+  using Status = ReaderStatus<FileStream>;
+  using Result = utils::expected<std::reference_wrapper<const Message>, Status>;
+
+  /* Takes ownership of fd and switches it to non-blocking mode. */
+  AsyncReader(EventLoop& loop, int fd, Options options = {}, size_t buffer_size = 32678)
+    : loop_(loop), fd_(fd), buffer_(buffer_size), options_(std::move(options)) {
+    if (buffer_.is_null()) status_ = Status::MEMORY_FAILURE;
+    int flags = fcntl(fd_, F_GETFL);
+    if (flags == -1 || fcntl(fd_, F_SETFL, flags | O_NONBLOCK) == -1) {
+      status_ = FileStream::Status(FileStream::Status::ERRNO);
+    }
+  }
+
+  ~AsyncReader() {
+    if (fd_ != -1) ::close(fd_);
+  }
+
+  // Suspended coroutines refer to the reader, so it stays in place.
+  AsyncReader(const AsyncReader&) = delete;
+  AsyncReader& operator=(const AsyncReader&) = delete;
+
+  class NextMessage;
+
+  /*
+   * Next message, or the final status once finished, to co_await. The message is valid until the
+   * next call. Messages already buffered, or read without blocking, complete without suspending
+   * or allocating; a coroutine is only started to wait for the descriptor.
+   */
+  NextMessage next_message() { return NextMessage(*this); }
+
+  /* See Reader::raw_message(). */
+  utils::bytes_view raw_message() const { return raw_message_; }
+
+  Message release_message() {
+    Message new_msg;
+    swap(new_msg, message_);
+    return new_msg;
+  }
+
+  Status status() const { return status_; }
+  int fd() const { return fd_; }
+
+private:
+  /* Decode the next message, reading while fd has bytes. Unset if reading would block. */
+  std::optional<Result> poll() {
+    while (status_.not_finished()) {
+      auto out = buffer_.prepare_read();
+      message_.clear();
+      auto ret = message_.decode(options_, message_type, out.data(), out.size());
+      if (ret) {
+        raw_message_ = { out.data(), ret.value() };
+        buffer_.commit_read(ret.value());
+        return Result(std::cref(message_));
+      }
+      if (!ret.error().is_partial_msg()) {
+        status_ = ret.error();
+        break;
+      }
+      if (status_.is_stream_finished()) {
+        // A partial message left at the end of the stream is truncated.
+        if (out.size() == 0) {
+          status_ = Status::FINISHED;
+        } else {
+          status_ = ret.error();
+        }
+        break;
+      }
+
+      if (!buffer_.available_write()) {
+        constexpr size_t growth_factor = 2;
+        if (!buffer_.reserve(buffer_.capacity() * growth_factor)) {
+          status_ = Status::MEMORY_FAILURE;
+          break;
+        }
+      }
+      auto in = buffer_.prepare_write();
+      auto bytes_read = ::read(fd_, in.data(), in.size());
+      if (bytes_read > 0) {
+        buffer_.commit_write(size_t(bytes_read));
+      } else if (bytes_read == 0) {
+        status_ = Status::STREAM_FINISHED;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return std::nullopt;
+      } else if (errno != EINTR) {
+        status_ = FileStream::Status(FileStream::Status::ERRNO);
+      }
+    }
+    return Result(utils::make_unexpected(status_));
+  }
+
+  /* poll() whenever fd becomes readable, until it yields a result. */
+  Task<Result> wait_message() {
+    while (true) {
+      co_await loop_.readable(fd_);
+      if (auto result = poll()) co_return std::move(*result);
+    }
+  }
+
+  EventLoop& loop_;
+  int fd_;
+  Buffer buffer_;
+  Options options_;
+  Message message_;
+  utils::bytes_view raw_message_;
+  Status status_;
+};
+
+template<Message::Type::Value message_type>
+class AsyncReader<message_type>::NextMessage {
+public:
+  bool await_ready() {
+    result_ = reader_.poll();
+    return result_.has_value();
+  }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+    wait_.emplace(reader_.wait_message());
+    return wait_->await_suspend(awaiting);
+  }
+  Result await_resume() { return result_ ? std::move(*result_) : wait_->await_resume(); }
+
+private:
+  friend class AsyncReader;
+  explicit NextMessage(AsyncReader& reader) : reader_(reader) {}
+
+  AsyncReader& reader_;
+  std::optional<Result> result_;
+  std::optional<Task<Result>> wait_;
+};
+
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <vector>
+
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/ip.hpp>
+
+namespace parsebgp {
+namespace io {
+
+/*
+ * Text formatter for MRT records in the pipe separated format of `bgpdump -m`: one line per RIB
+ * entry, announced or withdrawn prefix and state change.
+ *
+ *   TABLE_DUMP2|time|B|peer_ip|peer_as|prefix|as_path|origin|next_hop|local_pref|med|communities|
+ *     atomic_aggregate|aggregator|
+ *   BGP4MP|time|A|peer_ip|peer_as|prefix|as_path|origin|next_hop|local_pref|med|communities|
+ *     atomic_aggregate|aggregator|
+ *   BGP4MP|time|W|peer_ip|peer_as|prefix
+ *   BGP4MP|time|STATE|peer_ip|peer_as|old_state|new_state
+ *
+ * Extended timestamp records are printed as BGP4MP_ET with time as seconds.microseconds. The
+ * well-known communities are named no-export, no-advertise and local-AS, as bgpdump names them.
+ * Large communities follow the standard ones in the communities field.
+ *
+ * Numbers and addresses are formatted with std::to_chars and lookup tables, independent of the
+ * locale, into a buffer reused across records. The caller hands it to its output in large chunks:
+ *
+ *   io::BgpdumpFormatter text;
+ *   for (auto msg : reader) {
+ *     text.append(*msg, reader.peer_table());
+ *     if (text.size() >= 1 << 20) text.flush(stdout);
+ *   }
+ *   text.flush(stdout);
+ */
+class BgpdumpFormatter {
+public:
+  /* Line kinds, as in the third field. */
+  enum Kind : uint8_t {
+    RIB = 1 << 0,      // B
+    ANNOUNCE = 1 << 1, // A
+    WITHDRAW = 1 << 2, // W
+    STATE = 1 << 3,    // STATE
+    ALL_KINDS = RIB | ANNOUNCE | WITHDRAW | STATE,
+  };
+
+  /* Lines to leave out, checked before formatting them. */
+  struct Filter {
+    /* Bitmask of the Kind of lines to keep. */
+    uint8_t kinds = ALL_KINDS;
+    /* If set, keep only prefix lines for prefix or more specifics of it, and no state changes. */
+    std::optional<utils::IpPrefix> prefix;
+
+    bool keeps(Kind kind) const { return kinds & kind; }
+    bool keeps(const utils::IpPrefix& line_prefix) const {
+      return !prefix || prefix->contains(line_prefix);
+    }
+  };
+
+  explicit BgpdumpFormatter(size_t capacity = 1 << 20) : buffer_(capacity) {}
+  BgpdumpFormatter(size_t capacity, const Filter& filter) : buffer_(capacity), filter_(filter) {}
+
+  /*
+   * Append the lines of msg. peers resolves the peers of TABLE_DUMP_V2 RIB entries, e.g.
+   * Reader::peer_table(); entries of unknown peers are left out. Other record types are ignored.
+   */
+  void append(const mrt::Message& msg, const mrt::table_dump_v2::PeerTable& peers);
+
+  /* Lines of a TABLE_DUMP_V2 RIB record, with msg its header. */
+  void append_rib(const mrt::Message& msg,
+                  const mrt::table_dump_v2::Rib& rib,
+                  const mrt::table_dump_v2::PeerTable& peers);
+
+  /* Lines of a BGP4MP state change or UPDATE message; other BGP messages have none. */
+  void append_bgp4mp(const mrt::bgp4mp::Message& msg);
+
+  const char* data() const { return buffer_.data(); }
+  size_t size() const { return size_; }
+  utils::string_view text() const { return { buffer_.data(), size_ }; }
+  void clear() { size_ = 0; }
+
+  /* Write the buffered text to file and clear it. False on a short write. */
+  bool flush(FILE* file);
+
+  /* Lines appended so far, including those already flushed. */
+  uint64_t lines() const { return lines_; }
+
+private:
+  /* Make room for n more bytes and return where they go. */
+  char* reserve(size_t n) {
+    if (buffer_.size() - size_ < n) buffer_.resize(std::max(buffer_.size() * 2, size_ + n));
+    return buffer_.data() + size_;
+  }
+
+  void put(char c) { *reserve(1) = c, size_++; }
+  void put(utils::string_view s);
+  void put_u32(uint32_t value);
+  void put_ipv4(const uint8_t* addr);
+  void put_ipv6(const uint8_t* addr);
+  void put_ip(utils::ip_view addr);
+  void put_prefix(bool ipv6, const uint8_t* addr, uint8_t len);
+
+  /* Record type and timestamp, up to the separator before the line kind. */
+  void put_line_start(mrt::Message::Type type, uint32_t sec, uint32_t usec);
+  /* Fields from as_path to aggregator, for IPv6 prefixes if ipv6, and the end of line. */
+  void put_attributes(const bgp::PathAttributes& attrs, bool ipv6);
+  /* Append a copy of the size bytes already in the buffer at offset. */
+  void put_copy(size_t offset, size_t size);
+
+  std::vector<char> buffer_;
+  size_t size_ = 0;
+  uint64_t lines_ = 0;
+  Filter filter_{};
+};
+
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace io {
+
+/*
+ * State needed to resume a Reader after its last consumed message, see Reader::checkpoint().
+ *
+ * The stream part is opaque and specific to the stream type: an access point for GzipStream,
+ * nothing for streams which can seek or have to skip from the start.
+ */
+struct Checkpoint {
+  /* Offset in the uncompressed stream of the first message to decode on resume. */
+  uint64_t offset = 0;
+  std::vector<uint8_t> stream;
+  /* Last PEER_INDEX_TABLE record before offset, needed to resolve the following RIB entries. */
+  std::vector<uint8_t> peer_index;
+  std::optional<uint32_t> last_timestamp;
+
+  /* Portable encoding, e.g. for writing next to the job's output. */
+  std::vector<uint8_t> serialize() const;
+  static std::optional<Checkpoint> deserialize(utils::bytes_view data);
+};
+
+} // namespace io
+} // namespace parsebgp
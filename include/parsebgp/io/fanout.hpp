@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/hash.hpp>
+#include <parsebgp/utils/ip.hpp>
+#include <parsebgp/utils/spsc.hpp>
+
+namespace parsebgp {
+namespace io {
+
+/*
+ * Fan-out of owned records from one decoding thread to one consumer thread per shard.
+ *
+ * Records are routed by a 64-bit key, e.g. prefix_key() or peer_key(), so all records of a key
+ * reach the same consumer and consumers can own their partition of the state without locking. Each
+ * shard is a utils::SpscRing. The producer batches batch_size records per shard before publishing
+ * them; a full ring blocks push() until the consumer catches up, bounding memory.
+ *
+ * Record must be default constructible and movable, and should not refer into Reader buffers:
+ * decoded views are invalidated by the next decode.
+ */
+template<typename Record>
+class FanOut {
+public:
+  FanOut(std::size_t shards, std::size_t ring_capacity = 1 << 14, std::size_t batch_size = 256)
+    : batch_size_(batch_size) {
+    assert(shards > 0 && batch_size > 0);
+    for (std::size_t i = 0; i < shards; i++) shards_.emplace_back(new Shard(ring_capacity));
+  }
+
+  FanOut(const FanOut&) = delete;
+  FanOut& operator=(const FanOut&) = delete;
+
+  std::size_t shards() const { return shards_.size(); }
+
+  std::size_t shard_of(uint64_t key) const {
+    return std::size_t(utils::Hasher::hash_u64(key) % shards_.size());
+  }
+
+  /* Producer: queue record for the shard of key. */
+  void push(uint64_t key, Record record) {
+    auto& shard = *shards_[shard_of(key)];
+    shard.pending.push_back(std::move(record));
+    if (shard.pending.size() >= batch_size_) publish(shard);
+  }
+
+  /* Producer: publish partial batches, e.g. at the end of a file. */
+  void flush() {
+    for (auto& shard : shards_) publish(*shard);
+  }
+
+  /* Producer: flush and let consumers return once they have drained their shard. */
+  void close() {
+    flush();
+    closed_.store(true, std::memory_order_release);
+  }
+
+  /* Producer: number of times push() or flush() waited for a full ring. */
+  uint64_t stalls() const { return stalls_; }
+
+  /*
+   * Consumer: call f(Record&) for each record of shard until close() and the shard is drained.
+   * Must be called from a single thread per shard. Return the number of records consumed.
+   */
+  template<typename F>
+  std::size_t consume(std::size_t shard_index, F&& f) {
+    auto& shard = *shards_[shard_index];
+    std::vector<Record> batch(batch_size_);
+    std::size_t consumed = 0;
+    while (true) {
+      // Read the flag first: once it is set, everything published is visible to the pop below.
+      bool closed = closed_.load(std::memory_order_acquire);
+      std::size_t n = shard.ring.pop(batch.data(), batch.size());
+      for (std::size_t i = 0; i < n; i++) f(batch[i]);
+      consumed += n;
+      if (n == 0) {
+        if (closed) break;
+        std::this_thread::yield();
+      }
+    }
+    return consumed;
+  }
+
+  /* Keys for the usual partitions of RIB entries and updates. */
+  static uint64_t prefix_key(const utils::IpPrefix& prefix) { return prefix.hash(); }
+  static uint64_t peer_key(uint16_t peer_index) { return peer_index; }
+
+private:
+  struct Shard {
+    explicit Shard(std::size_t ring_capacity) : ring(ring_capacity) {}
+
+    utils::SpscRing<Record> ring;
+    std::vector<Record> pending;
+  };
+
+  void publish(Shard& shard) {
+    std::size_t done = 0;
+    while (done < shard.pending.size()) {
+      std::size_t n = shard.ring.push(shard.pending.data() + done, shard.pending.size() - done);
+      done += n;
+      if (!n) {
+        stalls_++;
+        std::this_thread::yield();
+      }
+    }
+    shard.pending.clear();
+  }
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::size_t batch_size_;
+  std::atomic<bool> closed_{ false };
+  uint64_t stalls_ = 0;
+};
+
+} // namespace io
+} // namespace parsebgp
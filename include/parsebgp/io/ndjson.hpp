@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace io {
+
+/*
+ * Newline delimited JSON formatter for MRT records: one object per PEER_INDEX_TABLE, RIB record,
+ * BGP4MP UPDATE and state change, with a "type" member telling them apart.
+ *
+ *   {"type":"peer_index","timestamp":T,"collector_bgp_id":"…","view_name":"…",
+ *    "peers":[{"bgp_id":"…","ip":"…","asn":N},…]}
+ *   {"type":"rib","timestamp":T,"sequence":N,"prefix":"…/len",
+ *    "entries":[{"peer_index":I,"peer_ip":"…","peer_asn":N,"originated_time":T,
+ *                "attributes":{…}},…]}
+ *   {"type":"update","timestamp":T,"peer_ip":"…","peer_asn":N,"withdrawn":["…/len",…],
+ *    "announced":["…/len",…],"attributes":{…}}
+ *   {"type":"state","timestamp":T,"peer_ip":"…","peer_asn":N,"old_state":S,"new_state":S}
+ *
+ * Extended timestamp records add "timestamp_usec". RIB entries of peers missing from the peer table
+ * have no peer_ip and peer_asn. Attributes are only present if set in the record:
+ *
+ *   "origin":"IGP"|"EGP"|"INCOMPLETE", "as_path":[{"type":"AS_SEQUENCE","asns":[N,…]},…],
+ *   "next_hop":"…", "mp_next_hop":"…", "local_pref":N, "med":N, "atomic_aggregate":true,
+ *   "aggregator":{"asn":N,"ip":"…"}, "communities":["asn:value",…],
+ *   "large_communities":["global:local1:local2",…]
+ *
+ * Like BgpdumpFormatter, records are written into a buffer reused across records, which the caller
+ * hands to its output in large chunks; nothing is allocated per record once the buffer has grown to
+ * its working size. view_name is the only free-form string: quotes, backslashes and control
+ * characters are escaped 16 bytes at a time, other bytes are copied as they are.
+ */
+class NdjsonFormatter {
+public:
+  explicit NdjsonFormatter(size_t capacity = 1 << 20) : buffer_(capacity) {}
+
+  /*
+   * Append the object of msg. peers resolves the peers of TABLE_DUMP_V2 RIB entries, e.g.
+   * Reader::peer_table(). Other record types are ignored.
+   */
+  void append(const mrt::Message& msg, const mrt::table_dump_v2::PeerTable& peers);
+
+  /* Objects of TABLE_DUMP_V2 records, with msg their header. */
+  void append_peer_index(const mrt::Message& msg, const mrt::table_dump_v2::PeerIndex& peer_index);
+  void append_rib(const mrt::Message& msg,
+                  const mrt::table_dump_v2::Rib& rib,
+                  const mrt::table_dump_v2::PeerTable& peers);
+
+  /* Object of a BGP4MP state change or UPDATE message; other BGP messages have none. */
+  void append_bgp4mp(const mrt::bgp4mp::Message& msg);
+
+  const char* data() const { return buffer_.data(); }
+  size_t size() const { return size_; }
+  utils::string_view text() const { return { buffer_.data(), size_ }; }
+  void clear() { size_ = 0; }
+
+  /* Write the buffered text to file and clear it. False on a short write. */
+  bool flush(FILE* file);
+
+  /* Objects appended so far, including those already flushed. */
+  uint64_t lines() const { return lines_; }
+
+private:
+  /* Make room for n more bytes and return where they go. */
+  char* reserve(size_t n) {
+    if (buffer_.size() - size_ < n) buffer_.resize(std::max(buffer_.size() * 2, size_ + n));
+    return buffer_.data() + size_;
+  }
+
+  void put(char c) { *reserve(1) = c, size_++; }
+  void put(utils::string_view s);
+  void put_u32(uint32_t value);
+  /* JSON string of the bytes of s. */
+  void put_string(utils::string_view s);
+  /* Quoted text of an address or prefix. */
+  void put_ip(utils::ip_view addr);
+  void put_prefix(bool ipv6, const uint8_t* addr, uint8_t len);
+
+  /* "type", the timestamp members and the comma after them. */
+  void put_object_start(utils::string_view type,
+                        mrt::Message::Type record_type,
+                        uint32_t sec,
+                        uint32_t usec);
+  /* The "attributes" member. */
+  void put_attributes(const bgp::PathAttributes& attrs);
+  void put_line_end() {
+    put("}\n");
+    lines_++;
+  }
+
+  std::vector<char> buffer_;
+  size_t size_ = 0;
+  uint64_t lines_ = 0;
+};
+
+} // namespace io
+} // namespace parsebgp
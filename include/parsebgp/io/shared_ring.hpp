@@ -0,0 +1,287 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace io {
+
+/*
+ * Shared memory ring for handing routes decoded by one publisher process to any number of
+ * subscriber processes on the same host, so a live stream is decoded once per host.
+ *
+ * The ring lives in a memfd: a header page with the positions, followed by the data pages mapped
+ * twice back to back, as in MirroredRingBuffer, so a record is always contiguous. Subscribers map
+ * the same memfd, e.g. inherited across fork() or opened as /proc/<publisher pid>/fd/<fd()>.
+ *
+ * Records are position independent: a fixed size SharedRecord::Header followed by the path
+ * attributes inline, all in host byte order except addresses. Positions are byte offsets which only
+ * grow, so a position p is at p % capacity in the data.
+ *
+ * The publisher never waits for subscribers. Each subscriber keeps its own position and copies
+ * records out before using them; a subscriber which falls more than the capacity behind notices
+ * from the publisher's reserved position that its copy may have been overwritten, skips to the
+ * oldest record start the publisher marked which is safe from being overwritten soon, and counts
+ * the records it lost.
+ */
+
+/* Decoded view of one record, valid until the subscriber's next poll. */
+class SharedRecord {
+public:
+  enum Kind : uint8_t {
+    RIB = 1,      // TABLE_DUMP_V2 RIB entry.
+    ANNOUNCE = 2, // BGP4MP UPDATE announcement.
+    WITHDRAW = 3, // BGP4MP UPDATE withdrawal; no attributes.
+  };
+
+  /* Layout of a record in the ring, 8 byte aligned, followed by the attributes. */
+  struct Header {
+    // Header and attributes, padded to a multiple of 8.
+    uint32_t size;
+    uint8_t kind;
+    // PREFIX_IPV6 and PEER_IPV6.
+    uint8_t flags;
+    uint8_t prefix_len;
+    uint8_t padding;
+    // Number of the record since the ring was created.
+    uint64_t sequence;
+    uint32_t timestamp;
+    uint32_t peer_asn;
+    // Network byte order; IPv4 addresses use the first 4 bytes.
+    uint8_t prefix[16];
+    uint8_t peer_ip[16];
+  };
+
+  static constexpr uint8_t PREFIX_IPV6 = 1 << 0;
+  static constexpr uint8_t PEER_IPV6 = 1 << 1;
+
+  /*
+   * Path attribute, 4 byte aligned: type, flags without EXTENDED and the payload size, then the
+   * payload padded to a multiple of 4. Payloads are in host byte order:
+   *
+   *   ORIGIN, MED, LOCAL_PREF, ORIGINATOR_ID: one u32
+   *   AS_PATH: for each segment its type, its number of AS numbers and those AS numbers, as u32
+   *   NEXT_HOP: the 4 address bytes
+   *   ATOMIC_AGGREGATE: empty
+   *   AGGREGATOR: the AS number as u32, then the 4 address bytes
+   *   COMMUNITIES, CLUSTER_LIST: the values as u32, communities with the ASN in the upper 16 bits
+   *   LARGE_COMMUNITIES: (global_admin, local_1, local_2) u32 triplets
+   *   MP_REACH_NLRI: the next hop bytes; the prefixes are records of their own
+   *
+   * Other attributes are left out.
+   */
+  class Attribute {
+  public:
+    static constexpr size_t HEADER_SIZE = 4;
+
+    bgp::PathAttributes::Type type() const { return bgp::PathAttributes::Type::Value(data_[0]); }
+    uint8_t flags() const { return data_[1]; }
+    utils::bytes_view payload() const { return { data_ + HEADER_SIZE, payload_size() }; }
+    /* Payload as u32 values, for the types with a u32 encoding. */
+    utils::span<const uint32_t> u32s() const {
+      return { reinterpret_cast<const uint32_t*>(data_ + HEADER_SIZE), payload_size() / 4 };
+    }
+
+  private:
+    friend class SharedRecord;
+
+    explicit Attribute(const uint8_t* data) : data_(data) {}
+    size_t payload_size() const {
+      uint16_t size;
+      std::memcpy(&size, data_ + 2, sizeof(size));
+      return size;
+    }
+    size_t padded_size() const { return HEADER_SIZE + (payload_size() + 3) / 4 * 4; }
+
+    const uint8_t* data_;
+  };
+
+  class Attributes {
+  public:
+    class Iterator {
+    public:
+      Attribute operator*() const { return Attribute(p_); }
+      Iterator& operator++() {
+        p_ += Attribute(p_).padded_size();
+        return *this;
+      }
+      bool operator==(const Iterator& rhs) const { return p_ == rhs.p_; }
+      bool operator!=(const Iterator& rhs) const { return p_ != rhs.p_; }
+
+    private:
+      friend class Attributes;
+      explicit Iterator(const uint8_t* p) : p_(p) {}
+      const uint8_t* p_;
+    };
+
+    Iterator begin() const { return Iterator(begin_); }
+    Iterator end() const { return Iterator(end_); }
+
+  private:
+    friend class SharedRecord;
+    Attributes(const uint8_t* begin, const uint8_t* end) : begin_(begin), end_(end) {}
+    const uint8_t* begin_;
+    const uint8_t* end_;
+  };
+
+  /* data must be 8 byte aligned and hold a whole record. */
+  explicit SharedRecord(const uint8_t* data) : header_(reinterpret_cast<const Header*>(data)) {}
+
+  Kind kind() const { return Kind(header_->kind); }
+  uint64_t sequence() const { return header_->sequence; }
+  uint32_t timestamp() const { return header_->timestamp; }
+  uint32_t peer_asn() const { return header_->peer_asn; }
+  utils::ip_view peer_ip() const {
+    return { header_->peer_ip, header_->flags & PEER_IPV6 ? 16U : 4U };
+  }
+  utils::ip_view prefix() const {
+    return { header_->prefix, header_->flags & PREFIX_IPV6 ? 16U : 4U };
+  }
+  uint8_t prefix_len() const { return header_->prefix_len; }
+  Attributes attributes() const {
+    auto* data = reinterpret_cast<const uint8_t*>(header_);
+    return { data + sizeof(Header), data + header_->size };
+  }
+  /* The first attribute of type. */
+  std::optional<Attribute> find(bgp::PathAttributes::Type::Value type) const;
+
+  /* Bytes the record takes in the ring. */
+  size_t size() const { return header_->size; }
+
+private:
+  const Header* header_;
+};
+
+/* Positions shared by the publisher and subscribers, in the first page of the memfd. */
+struct SharedRingControl {
+  static constexpr size_t MARKS = 16;
+
+  uint64_t magic;
+  uint64_t capacity;
+  // End of the bytes the publisher may be writing, moved before writing them.
+  std::atomic<uint64_t> reserved;
+  // End of the complete records.
+  std::atomic<uint64_t> tail;
+  std::atomic<uint32_t> closed;
+  // Start of the first record in each capacity / MARKS bytes, where lapped subscribers resume.
+  std::atomic<uint64_t> marks[MARKS];
+};
+
+class SharedRingPublisher {
+public:
+  /* Create a ring of at least capacity bytes, ceiled to a multiple of the page size. */
+  explicit SharedRingPublisher(size_t capacity);
+  ~SharedRingPublisher();
+
+  SharedRingPublisher(const SharedRingPublisher&) = delete;
+  SharedRingPublisher& operator=(const SharedRingPublisher&) = delete;
+  SharedRingPublisher(SharedRingPublisher&& other) noexcept;
+  SharedRingPublisher& operator=(SharedRingPublisher&& other) noexcept;
+
+  bool is_null() const { return !control_; }
+  /* The memfd, for subscribers to map. */
+  int fd() const { return fd_; }
+  size_t capacity() const { return capacity_; }
+
+  /*
+   * Publish the routes of msg: one RIB record per entry of a TABLE_DUMP_V2 RIB record whose peer
+   * is in peers, one ANNOUNCE or WITHDRAW record per prefix of a BGP4MP UPDATE. Other records are
+   * ignored. Subscribers see all records of msg at once. Return the number of records published.
+   */
+  size_t publish(const mrt::Message& msg, const mrt::table_dump_v2::PeerTable& peers);
+
+  /* Let subscribers finish once they have read everything published. */
+  void close();
+
+  /* Records too large for the ring, which were left out. */
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  void release();
+  /* Encode the attributes into attrs_. */
+  void encode_attributes(const bgp::PathAttributes& attrs);
+  /* Write a record, with the attributes in attrs_ if with_attributes, after the pending ones. */
+  bool write(SharedRecord::Header header, bool with_attributes);
+  /* Make the pending records visible. */
+  void commit();
+
+  int fd_ = -1;
+  size_t capacity_ = 0;
+  SharedRingControl* control_ = nullptr;
+  uint8_t* data_ = nullptr;
+  // Publisher side copies of the shared positions.
+  uint64_t tail_ = 0;
+  uint64_t sequence_ = 0;
+  // Mark index of the last marked record, or -1.
+  uint64_t marked_ = uint64_t(-1);
+  uint64_t dropped_ = 0;
+  std::vector<uint8_t> attrs_;
+};
+
+class SharedRingSubscriber {
+public:
+  /*
+   * Map the ring of fd, created by SharedRingPublisher. fd may be closed afterwards. Reading starts
+   * at the records published from now on.
+   */
+  explicit SharedRingSubscriber(int fd);
+  ~SharedRingSubscriber();
+
+  SharedRingSubscriber(const SharedRingSubscriber&) = delete;
+  SharedRingSubscriber& operator=(const SharedRingSubscriber&) = delete;
+  SharedRingSubscriber(SharedRingSubscriber&& other) noexcept;
+  SharedRingSubscriber& operator=(SharedRingSubscriber&& other) noexcept;
+
+  bool is_null() const { return !control_; }
+
+  /*
+   * Call f(const SharedRecord&) for records published since the last poll, up to about max_bytes
+   * of them. Never blocks. Return the number of records passed to f.
+   */
+  template<typename F>
+  size_t poll(F&& f, size_t max_bytes = 1 << 20) {
+    size_t size = copy(max_bytes);
+    size_t count = 0;
+    auto* data = reinterpret_cast<const uint8_t*>(batch_.data());
+    for (size_t offset = 0; offset < size; count++) {
+      SharedRecord record(data + offset);
+      f(static_cast<const SharedRecord&>(record));
+      offset += record.size();
+    }
+    return count;
+  }
+
+  /* Whether the publisher closed the ring and every record was read. */
+  bool finished() const;
+
+  /* Records overwritten before they were read, counted once a later record is read. */
+  uint64_t lost() const { return lost_; }
+
+private:
+  void release();
+  /* Copy whole records into batch_ and advance past them, returning their size. */
+  size_t copy(size_t max_bytes);
+  /* Resume at a marked record start after falling behind a publisher now at tail. */
+  void skip(uint64_t tail);
+
+  size_t capacity_ = 0;
+  const SharedRingControl* control_ = nullptr;
+  const uint8_t* data_ = nullptr;
+  uint64_t position_ = 0;
+  // Sequence of the next record, once one was read.
+  bool started_ = false;
+  uint64_t sequence_ = 0;
+  uint64_t lost_ = 0;
+  // Copy of the records being handed out, 8 byte aligned.
+  std::vector<uint64_t> batch_;
+};
+
+} // namespace io
+} // namespace parsebgp
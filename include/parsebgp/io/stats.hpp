@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <parsebgp.hpp>
+#include <parsebgp/mrt.hpp>
+
+namespace parsebgp {
+namespace io {
+
+#ifdef PARSEBGP_CPP_STATS_ENABLED
+
+/* Counters aggregated by a Reader over its lifetime, see Reader::stats(). */
+struct ReaderStats {
+  /* MRT types and subtypes counted individually; others go to other_mrt_records. */
+  static constexpr std::size_t MAX_MRT_TYPES = 64;
+  static constexpr std::size_t MAX_MRT_SUBTYPES = 16;
+
+  uint64_t stream_reads = 0;
+  uint64_t bytes_read = 0;
+  /* Time spent in Stream::read(), including inflating compressed streams. */
+  std::chrono::nanoseconds read_time{};
+
+  uint64_t records = 0;
+  uint64_t bytes_decoded = 0;
+  /* Time spent in Message::decode(), including attempts on partial messages. */
+  std::chrono::nanoseconds decode_time{};
+
+  /* Decode attempts that hit the end of buffered data and needed another read. */
+  uint64_t partial_retries = 0;
+  /* Successful MirroredRingBuffer::reserve() calls growing the buffer. */
+  uint64_t buffer_growths = 0;
+  std::size_t peak_capacity = 0;
+
+  std::array<std::array<uint64_t, MAX_MRT_SUBTYPES>, MAX_MRT_TYPES> mrt_records{};
+  uint64_t other_mrt_records = 0;
+
+  uint64_t mrt_records_of(uint16_t type, uint16_t subtype) const {
+    return type < MAX_MRT_TYPES && subtype < MAX_MRT_SUBTYPES ? mrt_records[type][subtype] : 0;
+  }
+};
+
+/* Hooks called by Reader at each stage. */
+class ReaderStatsRecorder {
+public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  TimePoint now() const { return Clock::now(); }
+
+  void read(TimePoint start, size_t bytes) {
+    stats_.read_time += Clock::now() - start;
+    stats_.stream_reads++;
+    stats_.bytes_read += bytes;
+  }
+
+  void decode(TimePoint start) { stats_.decode_time += Clock::now() - start; }
+
+  void record(size_t bytes) {
+    stats_.records++;
+    stats_.bytes_decoded += bytes;
+  }
+
+  void record_mrt(const Message& message) {
+    auto mrt = message.to_mrt();
+    auto type = mrt.type().value();
+    auto subtype = mrt.subtype();
+    if (type < ReaderStats::MAX_MRT_TYPES && subtype < ReaderStats::MAX_MRT_SUBTYPES) {
+      stats_.mrt_records[type][subtype]++;
+    } else {
+      stats_.other_mrt_records++;
+    }
+  }
+
+  void partial() { stats_.partial_retries++; }
+
+  void capacity(size_t capacity) {
+    if (capacity > stats_.peak_capacity) {
+      if (stats_.peak_capacity) stats_.buffer_growths++;
+      stats_.peak_capacity = capacity;
+    }
+  }
+
+  const ReaderStats& stats() const { return stats_; }
+
+private:
+  ReaderStats stats_;
+};
+
+#else
+
+/* Same hooks as above doing nothing, like utils::logger without PARSEBGP_CPP_LOG_ENABLED. */
+class ReaderStatsRecorder {
+public:
+  struct TimePoint {};
+
+  TimePoint now() const { return {}; }
+  void read(TimePoint, size_t) {}
+  void decode(TimePoint) {}
+  void record(size_t) {}
+  void record_mrt(const Message&) {}
+  void partial() {}
+  void capacity(size_t) {}
+};
+
+#endif
+
+} // namespace io
+} // namespace parsebgp
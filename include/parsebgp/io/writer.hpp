@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace io {
+
+/*
+ * Uncompressed MRT file writer for splitting and filtering dumps.
+ *
+ * Records kept whole are copied verbatim from Reader::raw_message(), never re-serialized. RIB
+ * records of a TABLE_DUMP_V2 dump can be written with a subset of their entries, which copies the
+ * raw bytes of the selected entries and only rewrites the MRT length and entry count.
+ *
+ * Output is batched into a buffer of buffer_size bytes and handed to stdio unbuffered, one write per
+ * full buffer. Records larger than the buffer bypass it.
+ */
+class MrtWriter : public utils::CPtrView<MrtWriter, FILE*> {
+public:
+  class Status : public utils::EnumClass<Status> {
+  public:
+    enum Value {
+      OK = 0,
+      ERRNO = -1,
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    Status(Value value = OK) : value_(value) {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    operator Value() const { return value_; }
+
+    Value value() const { return value_; }
+    bool is_valid() const {
+      switch (value_) {
+        case OK:
+        case ERRNO:
+          return true;
+      }
+      return false;
+    }
+    bool is_ok() const { return value_ == OK; }
+    bool is_errno() const { return value_ == ERRNO; }
+
+  private:
+    Value value_;
+  };
+
+  explicit MrtWriter(utils::string_view path, size_t buffer_size = 1 << 20);
+  /* Flushes the buffer. Call flush() first to find out whether that succeeded. */
+  ~MrtWriter();
+  MrtWriter(const MrtWriter&) = delete;
+  MrtWriter(MrtWriter&&) = default;
+  MrtWriter& operator=(const MrtWriter&) = delete;
+  /* Flushes and closes the current file before taking over other's. */
+  MrtWriter& operator=(MrtWriter&& other) noexcept;
+
+  /* Append a whole record, such as Reader::raw_message(), as is. */
+  bool write(utils::bytes_view record);
+
+  /*
+   * Append a TABLE_DUMP_V2 RIB_IPV4/IPV6 record with only the entries at the given ascending
+   * indices. Return false without writing anything if record is not such a record or an index is
+   * out of range.
+   */
+  bool write_rib(utils::bytes_view record, utils::span<const uint16_t> entries);
+
+  /*
+   * Append record, the raw bytes of rib, with the entries for which keep(RibEntry) is true. Falls
+   * back to write() when all entries are kept; records left without entries are dropped.
+   */
+  template<typename Predicate>
+  bool write_rib(utils::bytes_view record, const mrt::table_dump_v2::Rib& rib, Predicate&& keep) {
+    kept_.clear();
+    uint16_t index = 0;
+    for (auto entry : rib) {
+      if (keep(entry)) kept_.push_back(index);
+      index++;
+    }
+    if (kept_.empty()) return true;
+    if (kept_.size() == rib.size()) return write(record);
+    return write_rib(record, kept_);
+  }
+
+  /* Hand buffered records to the file. */
+  bool flush();
+
+  bool good() const;
+  Status status() const;
+  /* Bytes handed to the file so far; buffered records count once flushed. */
+  uint64_t bytes_written() const { return bytes_written_; }
+
+private:
+  /* Make room for size bytes in the buffer, flushing it or growing it past buffer_size. */
+  bool reserve(size_t size);
+  bool write_file(const uint8_t* data, size_t size);
+
+  std::vector<uint8_t> buffer_;
+  size_t buffer_size_;
+  std::vector<uint16_t> kept_;
+  uint64_t bytes_written_ = 0;
+  Status status_;
+};
+
+} // namespace io
+} // namespace parsebgp
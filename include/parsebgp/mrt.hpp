@@ -1,11 +1,16 @@
 #pragma once
 
+#include <array>
 #include <cassert>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #include <parsebgp/bgp/common.hpp>
+#include <parsebgp/bgp/message.hpp>
 #include <parsebgp/bgp/update.hpp>
 #include <parsebgp/utils.hpp>
+#include <parsebgp/utils/ip.hpp>
 
 extern "C" {
 struct parsebgp_mrt_table_dump;
@@ -30,11 +35,19 @@ namespace table_dump_v2 {
 
 class PeerEntry;
 class PeerIndex;
+class PeerTable;
 class RibEntry;
 class Rib;
 class Message;
 
 } // namespace table_dump_v2
+
+namespace bgp4mp {
+
+class StateChange;
+class Message;
+
+} // namespace bgp4mp
 } // namespace mrt
 } // namespace parsebgp
 
@@ -104,8 +117,12 @@ public:
   Type type() const;
   uint16_t subtype() const;
   uint32_t length() const;
+  uint32_t timestamp_sec() const;
+  /* Microseconds, only set for extended timestamp (_ET) types. */
+  uint32_t timestamp_usec() const;
 
   table_dump_v2::Message to_table_dump_v2() const;
+  bgp4mp::Message to_bgp4mp() const;
 };
 
 class AsnType : public utils::EnumClass<AsnType> {
@@ -141,6 +158,8 @@ public:
   utils::ip_view ip() const;
   utils::ipv4_view ipv4() const;
   utils::ipv6_view ipv6() const;
+  /* ip() as a value. */
+  utils::IpAddr ip_addr() const;
   uint32_t asn() const;
 };
 
@@ -163,12 +182,84 @@ private:
   static std::ptrdiff_t range_difference(const ElementCPtr lhs, const ElementCPtr rhs);
 };
 
+/*
+ * Owned copy of a PEER_INDEX_TABLE which outlives the message it was loaded from.
+ *
+ * Peers are stored in a flat array indexed by RibEntry::peer_index(), 16 bytes each, with IPv4
+ * addresses inline as integers and IPv6 addresses in a side array.
+ */
+class PeerTable {
+public:
+  class Peer {
+  public:
+    AfiType afi() const { return AfiType::Value(afi_); }
+    bool is_ipv4() const { return afi_ == AfiType::IPV4; }
+    bool is_ipv6() const { return afi_ == AfiType::IPV6; }
+    /* Host byte order. */
+    uint32_t ipv4() const {
+      assert(is_ipv4());
+      return addr_;
+    }
+    uint32_t asn() const { return asn_; }
+    /* Host byte order. */
+    uint32_t bgp_id() const { return bgp_id_; }
+
+  private:
+    friend class PeerTable;
+    uint32_t addr_; // IPv4 address, or index into PeerTable::ipv6_ for IPv6 peers.
+    uint32_t asn_;
+    uint32_t bgp_id_;
+    AfiType::Value afi_;
+  };
+
+  PeerTable() = default;
+  explicit PeerTable(const PeerIndex& peer_index) { load(peer_index); }
+
+  /* Replace the contents with peer_index. */
+  void load(const PeerIndex& peer_index);
+  void clear();
+
+  bool empty() const { return peers_.empty(); }
+  std::size_t size() const { return peers_.size(); }
+  const Peer& operator[](uint16_t index) const {
+    assert(index < peers_.size());
+    return peers_[index];
+  }
+  const Peer* find(uint16_t index) const {
+    return index < peers_.size() ? &peers_[index] : nullptr;
+  }
+
+  utils::ipv6_view ipv6(const Peer& peer) const {
+    assert(peer.is_ipv6());
+    return ipv6_[peer.addr_];
+  }
+  utils::IpAddr ip(const Peer& peer) const {
+    if (peer.is_ipv4()) return utils::Ipv4Addr(peer.ipv4());
+    return utils::Ipv6Addr(ipv6(peer));
+  }
+
+  /* Host byte order. */
+  uint32_t collector_bgp_id() const { return collector_bgp_id_; }
+  utils::string_view view_name() const { return view_name_; }
+
+private:
+  std::vector<Peer> peers_;
+  std::vector<std::array<uint8_t, 16>> ipv6_;
+  uint32_t collector_bgp_id_ = 0;
+  std::string view_name_;
+};
+
 class RibEntry : public utils::CPtrView<RibEntry, parsebgp_mrt_table_dump_v2_rib_entry*> {
 public:
   // NOLINTNEXTLINE(google-explicit-constructor): Allow propagation of C pointer.
   RibEntry(CPtr cptr) : BaseView(cptr) {}
 
   uint16_t peer_index() const;
+  /*
+   * Peer resolved against the table of the dump, e.g. Reader::peer_table(). Null if the index is
+   * past the table, as in corrupt dumps or without one.
+   */
+  const PeerTable::Peer* peer(const PeerTable& peers) const { return peers.find(peer_index()); }
   uint32_t originated_time() const;
   bgp::PathAttributes path_attributes() const;
 };
@@ -183,11 +274,15 @@ public:
   uint32_t sequence_no() const;
   uint8_t prefix_len() const;
   utils::ipv6_view prefix() const;
+  /* prefix() and prefix_len() as a value, afi given by the RIB subtype of the record. */
+  utils::IpPrefix ip_prefix(AfiType afi) const;
 
 private:
   friend BaseRange;
   ElementCPtr range_data() const;
   std::size_t range_size() const;
+  /* Used by prefetched(): the entry and the path attributes read by most consumers. */
+  static void range_prefetch(ElementCPtr ptr);
   static ElementCPtr range_add(const ElementCPtr ptr, std::ptrdiff_t n);
   static ElementCPtr range_subtract(const ElementCPtr ptr, std::ptrdiff_t n);
   static std::ptrdiff_t range_difference(const ElementCPtr lhs, const ElementCPtr rhs);
@@ -256,5 +351,108 @@ public:
 };
 
 } // namespace table_dump_v2
+
+namespace bgp4mp {
+
+class StateChange : public utils::CPtrView<StateChange, parsebgp_mrt_bgp4mp_state_change*> {
+public:
+  class State : public utils::EnumClass<State> {
+  public:
+    enum Value : uint16_t {
+      IDLE = 1,
+      CONNECT = 2,
+      ACTIVE = 3,
+      OPENSENT = 4,
+      OPENCONFIRM = 5,
+      ESTABLISHED = 6,
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    State(Value value) : value_(value) {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    operator Value() const { return value_; }
+
+    Value value() const { return value_; }
+    bool is_valid() const { return value_ >= IDLE && value_ <= ESTABLISHED; }
+    bool is_idle() const { return value_ == IDLE; }
+    bool is_connect() const { return value_ == CONNECT; }
+    bool is_active() const { return value_ == ACTIVE; }
+    bool is_opensent() const { return value_ == OPENSENT; }
+    bool is_openconfirm() const { return value_ == OPENCONFIRM; }
+    bool is_established() const { return value_ == ESTABLISHED; }
+
+  private:
+    Value value_;
+  };
+
+  // NOLINTNEXTLINE(google-explicit-constructor): Allow propagation of C pointer.
+  StateChange(CPtr cptr) : BaseView(cptr) {}
+
+  State old_state() const;
+  State new_state() const;
+};
+
+class Message : public utils::CPtrView<Message, parsebgp_mrt_msg*> {
+public:
+  class Subtype : public utils::EnumClass<Subtype> {
+  public:
+    enum Value : uint16_t {
+      STATE_CHANGE = 0,
+      MESSAGE = 1,
+      MESSAGE_AS4 = 4,
+      STATE_CHANGE_AS4 = 5,
+      MESSAGE_LOCAL = 6,
+      MESSAGE_AS4_LOCAL = 7,
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    Subtype(Value value) : value_(value) {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    operator Value() const { return value_; }
+
+    Value value() const { return value_; }
+    bool is_valid() const {
+      switch (value_) {
+        case STATE_CHANGE:
+        case MESSAGE:
+        case MESSAGE_AS4:
+        case STATE_CHANGE_AS4:
+        case MESSAGE_LOCAL:
+        case MESSAGE_AS4_LOCAL:
+          return true;
+      }
+      return false;
+    }
+    bool is_state_change() const { return value_ == STATE_CHANGE || value_ == STATE_CHANGE_AS4; }
+    bool is_message() const { return is_valid() && !is_state_change(); }
+    bool is_local() const { return value_ == MESSAGE_LOCAL || value_ == MESSAGE_AS4_LOCAL; }
+
+  private:
+    Value value_;
+  };
+
+  // NOLINTNEXTLINE(google-explicit-constructor): Allow propagation of C pointer.
+  Message(CPtr cptr) : BaseView(cptr) {}
+
+  mrt::Message::Type type() const;
+  Subtype subtype() const;
+  uint32_t length() const;
+  uint32_t timestamp_sec() const;
+  uint32_t timestamp_usec() const;
+
+  uint32_t peer_asn() const;
+  uint32_t local_asn() const;
+  uint16_t interface_index() const;
+  AfiType afi() const;
+  utils::ip_view peer_ip() const;
+  utils::ip_view local_ip() const;
+
+  StateChange to_state_change() const;
+  bgp::Message to_bgp() const;
+};
+
+} // namespace bgp4mp
 } // namespace mrt
 } // namespace parsebgp
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <parsebgp/rib/diff.hpp>
+#include <parsebgp/rib/lpm.hpp>
+#include <parsebgp/rib/origin.hpp>
+#include <parsebgp/rib/replay.hpp>
+#include <parsebgp/rib/store.hpp>
+#include <parsebgp/rib/topology.hpp>
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <parsebgp.hpp>
+#include <parsebgp/bgp/common.hpp>
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/ip.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+/*
+ * Streaming diff of two TABLE_DUMP_V2 dumps.
+ *
+ * Both readers are advanced in lockstep as a sort-merge over unicast RIB records, relying on dumps
+ * listing IPv4 before IPv6 and prefixes in increasing (address, length) order. Only the records of
+ * the current prefix of each side are held, usually one, so memory stays bounded by the number of
+ * peers of a single prefix. A prefix split across consecutive records is compared as a whole.
+ *
+ * Routes are matched across dumps by peer (address, ASN) since PEER_INDEX_TABLE positions are not
+ * stable between dumps, and compared through bgp::PathAttributes::fingerprint().
+ */
+class RibDiff {
+public:
+  class Kind : public utils::EnumClass<Kind> {
+  public:
+    enum Value {
+      ADDED,
+      REMOVED,
+      CHANGED,
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    Kind(Value value) : value_(value) {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    operator Value() const { return value_; }
+
+    Value value() const { return value_; }
+    bool is_added() const { return value_ == ADDED; }
+    bool is_removed() const { return value_ == REMOVED; }
+    bool is_changed() const { return value_ == CHANGED; }
+
+  private:
+    Value value_;
+  };
+
+  struct Peer {
+    utils::IpAddr ip;
+    uint32_t asn;
+
+    bool operator==(const Peer& rhs) const { return ip == rhs.ip && asn == rhs.asn; }
+    bool operator<(const Peer& rhs) const {
+      return ip < rhs.ip || (ip == rhs.ip && asn < rhs.asn);
+    }
+  };
+
+  struct Change {
+    Kind kind;
+    utils::IpPrefix prefix;
+    Peer peer;
+    std::optional<mrt::table_dump_v2::RibEntry> old_entry; // Unset for ADDED.
+    std::optional<mrt::table_dump_v2::RibEntry> new_entry; // Unset for REMOVED.
+  };
+
+  RibDiff() = default;
+
+  /*
+   * Call f(const Change&) for every differing (prefix, peer) route, in prefix order. Entries passed
+   * to f are only valid during the call.
+   *
+   * Return true if both readers reached the end of their dumps. Otherwise reading stopped on an
+   * error which can be inspected through the readers' status().
+   */
+  template<typename OldReader, typename NewReader, typename F>
+  bool run(OldReader& old_reader, NewReader& new_reader, F&& f);
+
+  /* Number of RIB records which went back in prefix order, breaking the merge. */
+  uint64_t out_of_order() const { return out_of_order_; }
+  uint64_t prefixes_compared() const { return prefixes_compared_; }
+
+private:
+  struct Entry {
+    Peer peer;
+    mrt::table_dump_v2::RibEntry entry;
+  };
+
+  struct Side {
+    std::vector<Peer> peers; // PEER_INDEX_TABLE position -> peer.
+    std::vector<Entry> entries;
+    // Records of prefix, taken from the reader so that they outlive decoding the next record, and
+    // spent ones handed back to it.
+    std::vector<Message> parts;
+    std::vector<Message> spare;
+    std::optional<utils::IpPrefix> prefix; // Unset when the dump is exhausted.
+    std::optional<utils::IpPrefix> last;
+  };
+
+  /* Three-way comparison of prefixes in dump order. */
+  static int compare(const utils::IpPrefix& lhs, const utils::IpPrefix& rhs) {
+    return lhs < rhs ? -1 : rhs < lhs ? 1 : 0;
+  }
+
+  /* Load a PEER_INDEX_TABLE into side, or return the prefix of a unicast RIB record. */
+  static std::optional<utils::IpPrefix> load(Side& side, const mrt::table_dump_v2::Message& msg);
+  /* Add the entries of a RIB record of the current prefix. */
+  static void add_entries(Side& side, mrt::table_dump_v2::Rib rib);
+
+  /*
+   * Gather the entries of the next prefix of reader, from the unicast RIB records listing it, and
+   * leave reader on the record after them. Return false at end of dump or on error.
+   */
+  template<typename Reader>
+  bool next(Reader& reader, Side& side);
+
+  template<typename F>
+  void emit_all(Kind kind, const Side& side, F&& f) const;
+  template<typename F>
+  void merge(F&& f);
+
+  Side old_;
+  Side new_;
+  uint64_t out_of_order_ = 0;
+  uint64_t prefixes_compared_ = 0;
+};
+
+template<typename Reader>
+bool RibDiff::next(Reader& reader, Side& side) {
+  for (auto& part : side.parts) side.spare.push_back(std::move(part));
+  side.parts.clear();
+  side.entries.clear();
+  side.prefix.reset();
+  while (true) {
+    auto msg = reader.message();
+    if (!msg) break;
+    std::optional<utils::IpPrefix> prefix;
+    if (msg->type().is_table_dump_v2()) prefix = load(side, msg->to_table_dump_v2());
+    if (prefix) {
+      if (side.prefix && *prefix != *side.prefix) break;
+      if (!side.prefix) {
+        if (side.last && compare(*side.last, *prefix) >= 0) out_of_order_++;
+        side.prefix = side.last = prefix;
+      }
+      if (side.spare.empty()) side.spare.emplace_back();
+      side.parts.push_back(std::move(side.spare.back()));
+      side.spare.pop_back();
+      reader.swap_message(side.parts.back());
+      add_entries(side, side.parts.back().to_mrt().to_table_dump_v2().to_rib());
+    }
+    reader.decode_one();
+  }
+  if (!side.prefix) return false;
+  std::sort(side.entries.begin(), side.entries.end(), [](const Entry& lhs, const Entry& rhs) {
+    return lhs.peer < rhs.peer;
+  });
+  return true;
+}
+
+template<typename F>
+void RibDiff::emit_all(Kind kind, const Side& side, F&& f) const {
+  for (auto& e : side.entries) {
+    Change change{ kind, *side.prefix, e.peer, std::nullopt, std::nullopt };
+    (kind.is_added() ? change.new_entry : change.old_entry).emplace(e.entry);
+    f(static_cast<const Change&>(change));
+  }
+}
+
+template<typename F>
+void RibDiff::merge(F&& f) {
+  auto o = old_.entries.begin();
+  auto n = new_.entries.begin();
+  while (o != old_.entries.end() || n != new_.entries.end()) {
+    Change change{ Kind::CHANGED, *new_.prefix, {}, std::nullopt, std::nullopt };
+    if (n == new_.entries.end() || (o != old_.entries.end() && o->peer < n->peer)) {
+      change.kind = Kind::REMOVED;
+      change.peer = o->peer;
+      change.old_entry.emplace((o++)->entry);
+    } else if (o == old_.entries.end() || n->peer < o->peer) {
+      change.kind = Kind::ADDED;
+      change.peer = n->peer;
+      change.new_entry.emplace((n++)->entry);
+    } else {
+      if (o->entry.path_attributes().fingerprint() == n->entry.path_attributes().fingerprint()) {
+        o++;
+        n++;
+        continue;
+      }
+      change.peer = n->peer;
+      change.old_entry.emplace((o++)->entry);
+      change.new_entry.emplace((n++)->entry);
+    }
+    f(static_cast<const Change&>(change));
+  }
+}
+
+template<typename OldReader, typename NewReader, typename F>
+bool RibDiff::run(OldReader& old_reader, NewReader& new_reader, F&& f) {
+  bool has_old = next(old_reader, old_);
+  bool has_new = next(new_reader, new_);
+  while (has_old || has_new) {
+    int cmp = !has_old ? 1 : !has_new ? -1 : compare(*old_.prefix, *new_.prefix);
+    if (cmp < 0) {
+      emit_all(Kind::REMOVED, old_, f);
+    } else if (cmp > 0) {
+      emit_all(Kind::ADDED, new_, f);
+    } else {
+      merge(f);
+      prefixes_compared_++;
+    }
+    if (cmp <= 0) has_old = next(old_reader, old_);
+    if (cmp >= 0) has_new = next(new_reader, new_);
+  }
+  return old_reader.status().is_finished() && new_reader.status().is_finished();
+}
+
+} // namespace rib
+} // namespace parsebgp
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+/* Addresses as host order integers, most significant bit first. */
+using Ipv4Key = uint32_t;
+using Ipv6Key = unsigned __int128;
+
+Ipv4Key ipv4_key(utils::bytes_view addr);
+Ipv6Key ipv6_key(utils::bytes_view addr);
+void ipv4_key_to_bytes(Ipv4Key key, uint8_t* out);
+void ipv6_key_to_bytes(Ipv6Key key, uint8_t* out);
+
+/*
+ * Path-compressed binary trie (PATRICIA) mapping prefixes to 32-bit values.
+ *
+ * Nodes live in a single vector and refer to each other by index, so the trie is compact and
+ * cheap to copy. Every node either holds a value or has two children; chains of single-child
+ * nodes are compressed away. Depth is bounded by the key width.
+ */
+template<typename Key>
+class PrefixTrie {
+public:
+  using Value = uint32_t;
+
+  static constexpr Value NONE = ~Value(0);
+  static constexpr unsigned WIDTH = sizeof(Key) * 8;
+
+  static Key mask(unsigned len) { return len ? ~Key(0) << (WIDTH - len) : Key(0); }
+
+  /* Insert or replace the value of key/len. Return previous value or NONE. */
+  Value insert(Key key, uint8_t len, Value value);
+  /* Remove key/len. Return removed value or NONE. */
+  Value erase(Key key, uint8_t len);
+  /* Exact match. */
+  Value find(Key key, uint8_t len) const;
+  /* Longest prefix match. */
+  Value lookup(Key addr) const;
+
+  /* Call f(Key, uint8_t len, Value) for prefixes covering key/len, shortest first, inclusive. */
+  template<typename F>
+  void covering(Key key, uint8_t len, F&& f) const;
+  /* Call f(Key, uint8_t len, Value) for prefixes covered by key/len in prefix order, inclusive. */
+  template<typename F>
+  void covered(Key key, uint8_t len, F&& f) const;
+
+  std::size_t size() const { return size_; }
+  std::size_t memory_usage() const {
+    return nodes_.capacity() * sizeof(Node) + free_.capacity() * sizeof(uint32_t);
+  }
+  void clear() {
+    nodes_.clear();
+    free_.clear();
+    root_ = NIL;
+    size_ = 0;
+  }
+
+private:
+  static constexpr uint32_t NIL = ~uint32_t(0);
+
+  struct Node {
+    Key key;
+    uint32_t child[2];
+    Value value;
+    uint8_t len;
+  };
+
+  static unsigned bit(Key key, unsigned i) { return unsigned(key >> (WIDTH - 1 - i)) & 1; }
+  static unsigned common_prefix(Key a, Key b, unsigned max_len);
+
+  uint32_t alloc(Key key, uint8_t len, Value value);
+  void release(uint32_t node) { free_.push_back(node); }
+  uint32_t& link(uint32_t parent, unsigned side) {
+    return parent == NIL ? root_ : nodes_[parent].child[side];
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_;
+  uint32_t root_ = NIL;
+  std::size_t size_ = 0;
+};
+
+/*
+ * DIR-24-8 longest prefix match table for IPv4.
+ *
+ * The first level is indexed directly by the upper 24 bits of the address. Entries for prefixes
+ * longer than /24 point to 256-entry second level groups indexed by the last octet. A lookup is
+ * one or two dependent memory reads. Each entry packs the value with the length of the prefix it
+ * came from, so more specific prefixes are never overwritten by less specific ones. The 64 MiB
+ * first level is only allocated by the first insert.
+ */
+class Dir24Table {
+public:
+  using Value = uint32_t;
+
+  static constexpr Value NONE = ~Value(0);
+  static constexpr Value MAX_VALUE = (1U << 24) - 2;
+
+  Dir24Table() = default;
+
+  /* Map addresses of addr/len to value unless covered by a more specific prefix. */
+  void insert(Ipv4Key addr, uint8_t len, Value value);
+  /* Replace addresses mapped by addr/len with the covering prefix, or unmap them if NONE. */
+  void erase(Ipv4Key addr, uint8_t len, Value covering_value, uint8_t covering_len);
+
+  Value lookup(Ipv4Key addr) const {
+    if (tbl24_.empty()) return NONE;
+    uint32_t e = tbl24_[addr >> 8];
+    if (e & GROUP) e = tbl8_[(e & PAYLOAD) * 256 + (addr & 0xff)];
+    return (e & PAYLOAD) ? (e & PAYLOAD) - 1 : NONE;
+  }
+
+  std::size_t memory_usage() const {
+    return (tbl24_.capacity() + tbl8_.capacity()) * sizeof(uint32_t);
+  }
+  void clear();
+
+private:
+  static constexpr uint32_t GROUP = 1U << 31;
+  static constexpr uint32_t PAYLOAD = (1U << 24) - 1;
+  static constexpr unsigned DEPTH_SHIFT = 24;
+
+  static uint32_t make_entry(Value value, uint8_t len) {
+    return value == NONE ? 0 : (uint32_t(len) << DEPTH_SHIFT) | (value + 1);
+  }
+  static uint8_t depth(uint32_t e) { return (e >> DEPTH_SHIFT) & 0x3f; }
+  static bool is_set(uint32_t e) { return e & PAYLOAD; }
+
+  template<typename Pred>
+  void assign(Ipv4Key addr, uint8_t len, uint32_t entry, Pred should_replace);
+
+  std::vector<uint32_t> tbl24_;
+  std::vector<uint32_t> tbl8_;
+};
+
+/* IPv4 prefix table: DIR-24-8 for lookups backed by a trie for exact and range queries. */
+class Ipv4PrefixTable {
+public:
+  using Key = Ipv4Key;
+  using Value = uint32_t;
+
+  static constexpr Value NONE = PrefixTrie<Key>::NONE;
+  static constexpr Value MAX_VALUE = Dir24Table::MAX_VALUE;
+
+  Value insert(Key key, uint8_t len, Value value);
+  Value erase(Key key, uint8_t len);
+  Value find(Key key, uint8_t len) const { return trie_.find(key, len); }
+  Value lookup(Key addr) const { return dir_.lookup(addr); }
+
+  template<typename F>
+  void covering(Key key, uint8_t len, F&& f) const {
+    trie_.covering(key, len, std::forward<F>(f));
+  }
+  template<typename F>
+  void covered(Key key, uint8_t len, F&& f) const {
+    trie_.covered(key, len, std::forward<F>(f));
+  }
+
+  std::size_t size() const { return trie_.size(); }
+  std::size_t memory_usage() const { return trie_.memory_usage() + dir_.memory_usage(); }
+  void clear() {
+    trie_.clear();
+    dir_.clear();
+  }
+
+private:
+  PrefixTrie<Key> trie_;
+  Dir24Table dir_;
+};
+
+/* IPv6 prefix table: the compressed trie alone, as a direct table is impractical at 128 bits. */
+using Ipv6PrefixTable = PrefixTrie<Ipv6Key>;
+
+//==============================================================================
+// rib::PrefixTrie
+//==============================================================================
+
+template<typename Key>
+unsigned PrefixTrie<Key>::common_prefix(Key a, Key b, unsigned max_len) {
+  Key x = a ^ b;
+  if (!x) return max_len;
+  unsigned clz;
+  if constexpr (WIDTH == 128) {
+    auto hi = uint64_t(x >> 64);
+    clz = hi ? __builtin_clzll(hi) : 64 + __builtin_clzll(uint64_t(x));
+  } else {
+    static_assert(WIDTH == 32);
+    clz = __builtin_clz(x);
+  }
+  return std::min(clz, max_len);
+}
+
+template<typename Key>
+uint32_t PrefixTrie<Key>::alloc(Key key, uint8_t len, Value value) {
+  Node node{ key, { NIL, NIL }, value, len };
+  if (!free_.empty()) {
+    uint32_t i = free_.back();
+    free_.pop_back();
+    nodes_[i] = node;
+    return i;
+  }
+  nodes_.push_back(node);
+  return uint32_t(nodes_.size() - 1);
+}
+
+template<typename Key>
+auto PrefixTrie<Key>::insert(Key key, uint8_t len, Value value) -> Value {
+  key &= mask(len);
+  uint32_t parent = NIL;
+  unsigned side = 0;
+  uint32_t cur = root_;
+  while (cur != NIL) {
+    auto& n = nodes_[cur];
+    unsigned common = common_prefix(key, n.key, std::min(len, n.len));
+    if (common == n.len) {
+      if (len == n.len) {
+        Value old = n.value;
+        n.value = value;
+        if (old == NONE) size_++;
+        return old;
+      }
+      parent = cur;
+      side = bit(key, n.len);
+      cur = n.child[side];
+      continue;
+    }
+    // Node references are invalidated by alloc() below.
+    Key cur_key = n.key;
+    if (common == len) {
+      uint32_t node = alloc(key, len, value);
+      nodes_[node].child[bit(cur_key, len)] = cur;
+      link(parent, side) = node;
+    } else {
+      uint32_t glue = alloc(key & mask(common), uint8_t(common), NONE);
+      uint32_t leaf = alloc(key, len, value);
+      nodes_[glue].child[bit(key, common)] = leaf;
+      nodes_[glue].child[bit(cur_key, common)] = cur;
+      link(parent, side) = glue;
+    }
+    size_++;
+    return NONE;
+  }
+  uint32_t leaf = alloc(key, len, value);
+  link(parent, side) = leaf;
+  size_++;
+  return NONE;
+}
+
+template<typename Key>
+auto PrefixTrie<Key>::erase(Key key, uint8_t len) -> Value {
+  key &= mask(len);
+  uint32_t grandparent = NIL, parent = NIL;
+  unsigned parent_side = 0, side = 0;
+  uint32_t cur = root_;
+  while (cur != NIL) {
+    auto& n = nodes_[cur];
+    if (n.len > len || (key & mask(n.len)) != n.key) return NONE;
+    if (n.len == len) break;
+    grandparent = parent;
+    parent_side = side;
+    parent = cur;
+    side = bit(key, n.len);
+    cur = n.child[side];
+  }
+  if (cur == NIL || nodes_[cur].value == NONE) return NONE;
+
+  auto& n = nodes_[cur];
+  Value old = n.value;
+  n.value = NONE;
+  size_--;
+  if (n.child[0] != NIL && n.child[1] != NIL) return old;
+
+  // Splice out the node, then its parent if that was left as a valueless single-child node.
+  uint32_t only_child = n.child[0] != NIL ? n.child[0] : n.child[1];
+  link(parent, side) = only_child;
+  release(cur);
+  if (only_child == NIL && parent != NIL && nodes_[parent].value == NONE) {
+    link(grandparent, parent_side) = nodes_[parent].child[side ^ 1];
+    release(parent);
+  }
+  return old;
+}
+
+template<typename Key>
+auto PrefixTrie<Key>::find(Key key, uint8_t len) const -> Value {
+  key &= mask(len);
+  uint32_t cur = root_;
+  while (cur != NIL) {
+    auto& n = nodes_[cur];
+    if (n.len > len || (key & mask(n.len)) != n.key) return NONE;
+    if (n.len == len) return n.value;
+    cur = n.child[bit(key, n.len)];
+  }
+  return NONE;
+}
+
+template<typename Key>
+auto PrefixTrie<Key>::lookup(Key addr) const -> Value {
+  Value best = NONE;
+  uint32_t cur = root_;
+  while (cur != NIL) {
+    auto& n = nodes_[cur];
+    if ((addr & mask(n.len)) != n.key) break;
+    if (n.value != NONE) best = n.value;
+    if (n.len == WIDTH) break;
+    cur = n.child[bit(addr, n.len)];
+  }
+  return best;
+}
+
+template<typename Key>
+template<typename F>
+void PrefixTrie<Key>::covering(Key key, uint8_t len, F&& f) const {
+  key &= mask(len);
+  uint32_t cur = root_;
+  while (cur != NIL) {
+    auto& n = nodes_[cur];
+    if (n.len > len || (key & mask(n.len)) != n.key) break;
+    if (n.value != NONE) f(n.key, n.len, n.value);
+    if (n.len == len) break;
+    cur = n.child[bit(key, n.len)];
+  }
+}
+
+template<typename Key>
+template<typename F>
+void PrefixTrie<Key>::covered(Key key, uint8_t len, F&& f) const {
+  key &= mask(len);
+  uint32_t cur = root_;
+  while (cur != NIL) {
+    auto& n = nodes_[cur];
+    if (n.len >= len) {
+      if ((n.key & mask(len)) != key) return;
+      break;
+    }
+    if ((key & mask(n.len)) != n.key) return;
+    cur = n.child[bit(key, n.len)];
+  }
+  if (cur == NIL) return;
+
+  // Pre-order traversal visits prefixes sorted by (address, length).
+  uint32_t stack[WIDTH + 2];
+  std::size_t top = 0;
+  stack[top++] = cur;
+  while (top) {
+    auto& n = nodes_[stack[--top]];
+    if (n.value != NONE) f(n.key, n.len, n.value);
+    if (n.child[1] != NIL) stack[top++] = n.child[1];
+    if (n.child[0] != NIL) stack[top++] = n.child[0];
+  }
+}
+
+} // namespace rib
+} // namespace parsebgp
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include <parsebgp/bgp/common.hpp>
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/ip.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+/*
+ * Prefix to origin AS table built from TABLE_DUMP_V2 unicast RIB records in one pass.
+ *
+ * The origin of a route is the end of its AS path, skipping confederation segments: the last AS of
+ * an AS_SEQUENCE, or the whole of an AS_SET. Each prefix keeps its distinct origins with the number
+ * of RIB entries (peers) announcing each. Prefixes with more than one origin are multi-origin
+ * (MOAS); an AS_SET counts as a single origin.
+ *
+ * Prefixes are kept in one flat array in prefix order, which is the order of the dump, so loading
+ * a dump only appends and memory is proportional to the number of distinct prefixes: about 28
+ * bytes per prefix and 8 per origin. Tables built from separate chunks of a dump, e.g. on several
+ * threads, are combined with merge().
+ */
+class OriginTable {
+public:
+  class Origin {
+  public:
+    bool is_as_set() const { return bits_ & AS_SET_BIT; }
+    /* The origin AS, unless is_as_set(); see OriginTable::as_set() for those. */
+    uint32_t asn() const {
+      assert(!is_as_set());
+      return value_;
+    }
+    /* RIB entries with this origin, saturating. */
+    uint32_t peers() const { return bits_ & ~AS_SET_BIT; }
+
+  private:
+    friend class OriginTable;
+
+    static constexpr uint32_t AS_SET_BIT = uint32_t(1) << 31;
+
+    Origin(uint32_t value, bool as_set, uint32_t peers)
+      : value_(value), bits_((as_set ? AS_SET_BIT : 0) | peers) {}
+
+    /* Order within a prefix, AS numbers before AS_SETs. */
+    uint64_t key() const { return uint64_t(bits_ & AS_SET_BIT) << 1 | value_; }
+    void add_peers(uint32_t peers) {
+      uint64_t sum = uint64_t(this->peers()) + peers;
+      bits_ = (bits_ & AS_SET_BIT) | uint32_t(std::min<uint64_t>(sum, ~AS_SET_BIT));
+    }
+
+    uint32_t value_; // AS number, or AS_SET id.
+    uint32_t bits_;  // AS_SET_BIT and the number of peers.
+  };
+
+  using Origins = utils::span<const Origin>;
+
+  struct Entry {
+    utils::IpPrefix prefix;
+    Origins origins;
+
+    bool is_moas() const { return origins.size() > 1; }
+  };
+
+  OriginTable() = default;
+
+  /* Load a RIB_IPV4_UNICAST or RIB_IPV6_UNICAST record. Return false for other records. */
+  bool load(const mrt::table_dump_v2::Message& msg);
+  /* Add the origins of all entries of a RIB record to those of its prefix. */
+  void insert(bgp::AfiType afi, mrt::table_dump_v2::Rib rib);
+
+  /*
+   * Sort and combine prefixes inserted out of prefix order. Needed before the lookups below if the
+   * records were not in dump order; merge() does it for both tables.
+   */
+  void finish();
+  /* Add the origins of other, e.g. a table built from another chunk of the dump. */
+  void merge(OriginTable other);
+
+  std::size_t size() const { return prefixes_.size(); }
+  Entry operator[](std::size_t i) const {
+    assert(i < size());
+    return { prefixes_[i], { &origins_[offsets_[i]], offsets_[i + 1] - offsets_[i] } };
+  }
+  /* Exact match. */
+  std::optional<Origins> find(const utils::IpPrefix& prefix) const;
+  /* The AS numbers of an AS_SET origin, sorted. */
+  utils::span<const uint32_t> as_set(const Origin& origin) const {
+    assert(origin.is_as_set());
+    return { &set_asns_[set_offsets_[origin.value_]],
+             set_offsets_[origin.value_ + 1] - set_offsets_[origin.value_] };
+  }
+
+  /* Call f(const Entry&) for each prefix, in prefix order. */
+  template<typename F>
+  void for_each(F&& f) const;
+  /* Call f(const Entry&) for each MOAS prefix, in prefix order. */
+  template<typename F>
+  void for_each_moas(F&& f) const;
+  std::size_t moas_size() const;
+
+  /* RIB entries loaded, and those without an origin: no AS path, or no AS in its last segment. */
+  uint64_t entries() const { return entries_; }
+  uint64_t no_origin() const { return no_origin_; }
+
+  std::size_t memory_usage() const;
+  void clear();
+
+private:
+  /* Add the origins in scratch_, sorted and combined, for prefix. */
+  void append(const utils::IpPrefix& prefix);
+  /* Sort scratch_ and combine equal origins. */
+  void combine_scratch();
+  uint32_t intern_set(const std::vector<uint32_t>& asns);
+
+  std::vector<utils::IpPrefix> prefixes_;
+  // Origins of prefixes_[i] are origins_[offsets_[i]] up to origins_[offsets_[i + 1]].
+  std::vector<uint32_t> offsets_ = { 0 };
+  std::vector<Origin> origins_;
+  bool sorted_ = true;
+
+  std::vector<uint32_t> set_asns_;
+  std::vector<uint32_t> set_offsets_ = { 0 };
+  std::map<std::vector<uint32_t>, uint32_t> set_ids_;
+
+  uint64_t entries_ = 0;
+  uint64_t no_origin_ = 0;
+
+  std::vector<Origin> scratch_;
+  std::vector<uint32_t> set_scratch_;
+};
+
+template<typename F>
+void OriginTable::for_each(F&& f) const {
+  assert(sorted_);
+  for (std::size_t i = 0; i < size(); i++) f(static_cast<const Entry&>((*this)[i]));
+}
+
+template<typename F>
+void OriginTable::for_each_moas(F&& f) const {
+  assert(sorted_);
+  for (std::size_t i = 0; i < size(); i++) {
+    if (offsets_[i + 1] - offsets_[i] > 1) f(static_cast<const Entry&>((*this)[i]));
+  }
+}
+
+} // namespace rib
+} // namespace parsebgp
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <parsebgp/bgp/common.hpp>
+#include <parsebgp/bgp/intern.hpp>
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/rib/lpm.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/hash.hpp>
+#include <parsebgp/utils/ip.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+/*
+ * Reconstructs RIB state between dumps by replaying BGP4MP messages onto a TABLE_DUMP_V2 snapshot.
+ *
+ * Routes are kept per peer in hash tables keyed by prefix, so an announcement or withdrawal only
+ * touches its (peer, prefix) entry and a session going down out of ESTABLISHED drops that peer's
+ * routes. Peers are identified by (address, ASN), which is what both PEER_INDEX_TABLE and BGP4MP
+ * headers carry.
+ *
+ * Checkpoints share the route table of each peer with the replayer and each other, and a table is
+ * copied on its first change after a checkpoint, so a checkpoint costs a copy of the tables of the
+ * peers updated until the next one: with max_count automatic checkpoints, at most max_count + 1
+ * copies of the whole RIB. All share one attribute interner. After restoring one, apply() skips
+ * messages the checkpoint already includes, so replay can resume from the start of the update file
+ * containing the checkpoint time.
+ */
+class RibReplayer {
+public:
+  using PeerId = uint32_t;
+
+  struct Peer {
+    utils::IpAddr ip;
+    uint32_t asn;
+
+    bool operator==(const Peer& rhs) const { return ip == rhs.ip && asn == rhs.asn; }
+  };
+
+  struct Route {
+    bgp::AttributeSetInterner::Id attrs;
+    /* Originated time for routes from the snapshot, message time for replayed ones. */
+    uint32_t time;
+  };
+
+  class Result : public utils::EnumClass<Result> {
+  public:
+    enum Value {
+      APPLIED,
+      SKIPPED, // Already included in the restored checkpoint.
+      IGNORED, // Not a BGP4MP state change or UPDATE.
+    };
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    Result(Value value) : value_(value) {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+    operator Value() const { return value_; }
+
+    Value value() const { return value_; }
+    bool is_applied() const { return value_ == APPLIED; }
+    bool is_skipped() const { return value_ == SKIPPED; }
+    bool is_ignored() const { return value_ == IGNORED; }
+
+  private:
+    Value value_;
+  };
+
+  class Checkpoint;
+
+  RibReplayer();
+
+  /* Load a TABLE_DUMP_V2 record. Return false if it isn't a peer index or unicast RIB. */
+  bool load(const mrt::table_dump_v2::Message& msg);
+  void load_peer_index(mrt::table_dump_v2::PeerIndex peer_index);
+  void load_rib(bgp::AfiType afi, mrt::table_dump_v2::Rib rib);
+
+  /* Apply a BGP4MP record. Records are expected in timestamp order. */
+  Result apply(const mrt::Message& msg);
+
+  /* Time of the latest applied record. */
+  uint32_t time_sec() const { return position_.sec; }
+  uint32_t time_usec() const { return position_.usec; }
+  /* Records applied with a timestamp older than time of the previous record. */
+  uint64_t out_of_order() const { return out_of_order_; }
+
+  Checkpoint checkpoint() const;
+  void restore(const Checkpoint& checkpoint);
+
+  /*
+   * Take a checkpoint automatically whenever replay crosses a multiple of interval seconds,
+   * keeping at most max_count of them. Zero interval disables automatic checkpoints.
+   */
+  void set_checkpoint_interval(uint32_t interval, std::size_t max_count);
+  /* Restore the latest automatic checkpoint at or before target_sec. Return false if none. */
+  bool rewind(uint32_t target_sec);
+
+  std::optional<Route> find(PeerId peer, const utils::IpPrefix& prefix) const;
+
+  /* Call f(PeerId, const utils::IpPrefix&, const Route&) for every route. */
+  template<typename F>
+  void for_each(F&& f) const;
+
+  std::size_t peers_size() const { return peers_.size(); }
+  const Peer& peer(PeerId id) const { return peers_[id]; }
+  std::optional<PeerId> find_peer(const Peer& peer) const;
+
+  std::size_t size() const;
+  const bgp::AttributeSetInterner& attributes() const { return *attributes_; }
+
+private:
+  struct Ipv6Prefix {
+    Ipv6Key key;
+    uint8_t len;
+
+    bool operator==(const Ipv6Prefix& rhs) const { return key == rhs.key && len == rhs.len; }
+  };
+
+  struct PrefixHash {
+    std::size_t operator()(uint64_t key) const { return utils::Hasher::hash_u64(key); }
+    std::size_t operator()(const Ipv6Prefix& prefix) const {
+      return utils::Hasher::hash(&prefix, sizeof(prefix.key) + sizeof(prefix.len));
+    }
+  };
+
+  struct PeerHash {
+    std::size_t operator()(const Peer& peer) const {
+      return utils::Hasher::hash_u64(peer.ip.hash() ^ peer.asn);
+    }
+  };
+
+  struct PeerRib {
+    std::unordered_map<uint64_t, Route, PrefixHash> ipv4;
+    std::unordered_map<Ipv6Prefix, Route, PrefixHash> ipv6;
+  };
+
+  struct Position {
+    uint32_t sec;
+    uint32_t usec;
+    /* Records applied with exactly this timestamp. */
+    uint64_t count;
+  };
+
+  static uint64_t ipv4_prefix(const utils::IpPrefix& prefix) {
+    return uint64_t(prefix.addr().ipv4().value()) << 8 | prefix.len();
+  }
+  static Ipv6Prefix ipv6_prefix(const utils::IpPrefix& prefix) {
+    auto addr = prefix.addr().ipv6();
+    return { Ipv6Key(addr.hi()) << 64 | addr.lo(), prefix.len() };
+  }
+
+  PeerId intern_peer(const utils::IpAddr& ip, uint32_t asn);
+  /* The table of peer, copied first if a checkpoint shares it. */
+  PeerRib& mutable_rib(PeerId peer);
+  void announce(PeerId peer, bgp::Prefix prefix, Route route);
+  void withdraw(PeerId peer, bgp::Prefix prefix);
+  bool advance(uint32_t sec, uint32_t usec);
+
+  std::vector<Peer> peers_;
+  std::unordered_map<Peer, PeerId, PeerHash> peer_ids_;
+  std::vector<PeerId> peer_index_; // Latest PEER_INDEX_TABLE position -> peer id.
+  std::vector<std::shared_ptr<PeerRib>> ribs_;
+  std::shared_ptr<bgp::AttributeSetInterner> attributes_;
+
+  Position position_;
+  std::optional<Position> resume_;
+  uint64_t out_of_order_;
+
+  uint32_t checkpoint_interval_;
+  std::size_t checkpoint_max_count_;
+  std::deque<std::unique_ptr<Checkpoint>> checkpoints_;
+};
+
+class RibReplayer::Checkpoint {
+public:
+  uint32_t time_sec() const { return position_.sec; }
+  uint32_t time_usec() const { return position_.usec; }
+
+private:
+  friend class RibReplayer;
+
+  std::vector<Peer> peers_;
+  std::vector<PeerId> peer_index_;
+  std::vector<std::shared_ptr<PeerRib>> ribs_; // Shared; RibReplayer copies them to write.
+  Position position_;
+};
+
+template<typename F>
+void RibReplayer::for_each(F&& f) const {
+  for (PeerId peer = 0; peer < ribs_.size(); peer++) {
+    for (auto& kv : ribs_[peer]->ipv4) {
+      const utils::IpPrefix prefix(utils::Ipv4Addr(uint32_t(kv.first >> 8)), uint8_t(kv.first));
+      f(peer, prefix, kv.second);
+    }
+    for (auto& kv : ribs_[peer]->ipv6) {
+      utils::Ipv6Addr addr(uint64_t(kv.first.key >> 64), uint64_t(kv.first.key));
+      const utils::IpPrefix prefix(addr, kv.first.len);
+      f(peer, prefix, kv.second);
+    }
+  }
+}
+
+} // namespace rib
+} // namespace parsebgp
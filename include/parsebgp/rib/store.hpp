@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <parsebgp/bgp/common.hpp>
+#include <parsebgp/bgp/intern.hpp>
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/rib/lpm.hpp>
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/ip.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+/*
+ * In-memory RIB loaded from TABLE_DUMP_V2 unicast RIB records.
+ *
+ * IPv4 prefixes are indexed with DIR-24-8 and IPv6 prefixes with a compressed trie. Routes of a
+ * prefix are stored contiguously and refer to interned attribute sets, so a full table costs
+ * roughly 12 bytes per route plus one copy of each distinct attribute set.
+ *
+ * Lookups take utils::IpAddr and utils::IpPrefix values, whose family selects the table.
+ */
+class RibStore {
+public:
+  struct Route {
+    uint16_t peer_index;
+    uint32_t originated_time;
+    bgp::AttributeSetInterner::Id attrs;
+  };
+
+  using Routes = utils::span<const Route>;
+
+  struct Match {
+    utils::IpPrefix prefix;
+    Routes routes;
+  };
+
+  RibStore() = default;
+
+  /* Load a RIB_IPV4_UNICAST or RIB_IPV6_UNICAST record. Return false for other records. */
+  bool load(const mrt::table_dump_v2::Message& msg);
+  /*
+   * Insert all entries of a RIB record. Dumps split prefixes with many entries across consecutive
+   * records, so a record for the prefix of the previous one adds to its routes; otherwise the
+   * routes replace those loaded earlier for the same prefix.
+   */
+  void insert(bgp::AfiType afi, mrt::table_dump_v2::Rib rib);
+
+  /* Longest prefix match. */
+  std::optional<Match> lookup(const utils::IpAddr& addr) const;
+  /* Exact match. */
+  std::optional<Match> find(const utils::IpPrefix& prefix) const;
+  /* Call f(const Match&) for each stored prefix covering prefix, shortest first. */
+  template<typename F>
+  void covering(const utils::IpPrefix& prefix, F&& f) const;
+  /* Call f(const Match&) for each stored prefix covered by prefix, in prefix order. */
+  template<typename F>
+  void covered(const utils::IpPrefix& prefix, F&& f) const;
+
+  const bgp::AttributeSetInterner& attributes() const { return attributes_; }
+
+  std::size_t ipv4_size() const { return v4_.size(); }
+  std::size_t ipv6_size() const { return v6_.size(); }
+  std::size_t routes_size() const { return routes_.size(); }
+  std::size_t memory_usage() const;
+
+  void clear();
+
+private:
+  template<typename Key>
+  struct Slot {
+    Key key;
+    uint32_t routes_offset;
+    uint32_t routes_count;
+    uint8_t len;
+  };
+
+  static constexpr uint32_t NO_SLOT = ~uint32_t(0);
+
+  template<typename Table, typename Key>
+  void insert_routes(Table& table,
+                     std::vector<Slot<Key>>& slots,
+                     Key key,
+                     uint8_t len,
+                     mrt::table_dump_v2::Rib rib);
+
+  static Ipv4Key key(utils::Ipv4Addr addr) { return addr.value(); }
+  static Ipv6Key key(utils::Ipv6Addr addr) { return Ipv6Key(addr.hi()) << 64 | addr.lo(); }
+
+  Match match(const Slot<Ipv4Key>& slot) const;
+  Match match(const Slot<Ipv6Key>& slot) const;
+
+  Ipv4PrefixTable v4_;
+  Ipv6PrefixTable v6_;
+  std::vector<Slot<Ipv4Key>> v4_slots_;
+  std::vector<Slot<Ipv6Key>> v6_slots_;
+  std::vector<Route> routes_;
+  bgp::AttributeSetInterner attributes_;
+  // Slot of the previous record, whose routes are at the end of routes_.
+  uint32_t last_id_ = NO_SLOT;
+  bool last_ipv6_ = false;
+};
+
+template<typename F>
+void RibStore::covering(const utils::IpPrefix& prefix, F&& f) const {
+  if (prefix.is_ipv4()) {
+    v4_.covering(key(prefix.addr().ipv4()), prefix.len(), [&](Ipv4Key, uint8_t, uint32_t id) {
+      f(match(v4_slots_[id]));
+    });
+  } else {
+    v6_.covering(key(prefix.addr().ipv6()), prefix.len(), [&](Ipv6Key, uint8_t, uint32_t id) {
+      f(match(v6_slots_[id]));
+    });
+  }
+}
+
+template<typename F>
+void RibStore::covered(const utils::IpPrefix& prefix, F&& f) const {
+  if (prefix.is_ipv4()) {
+    v4_.covered(key(prefix.addr().ipv4()), prefix.len(), [&](Ipv4Key, uint8_t, uint32_t id) {
+      f(match(v4_slots_[id]));
+    });
+  } else {
+    v6_.covered(key(prefix.addr().ipv6()), prefix.len(), [&](Ipv6Key, uint8_t, uint32_t id) {
+      f(match(v6_slots_[id]));
+    });
+  }
+}
+
+} // namespace rib
+} // namespace parsebgp
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <parsebgp/bgp/update.hpp>
+#include <parsebgp/mrt.hpp>
+#include <parsebgp/utils/concurrent_counter.hpp>
+#include <parsebgp/utils/hash.hpp>
+#include <parsebgp/utils/ip.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+/*
+ * AS level topology: the pairs of adjacent ASes in the AS paths of RIB entries and announcements,
+ * each with its visibility: the number of routes (peer and prefix) whose path contains it, and the
+ * number of distinct peers, by address and AS, that sent such a route.
+ *
+ * Edges are kept in utils::ConcurrentCounter tables keyed by the packed AS pair, and the peers of
+ * each edge in one keyed by a hash of the edge and the peer, so any number of threads extract into
+ * one topology at once, each through its own Extractor. Prepending is collapsed, and paths are cut
+ * at segments the options leave out and at AS 0, so no edge crosses them. The tables do not grow;
+ * size them for the expected number of edges and peers per edge, and check overflowed() and
+ * peers_overflowed().
+ */
+class AsTopology {
+public:
+  struct Options {
+    // Keep (a, b) apart from (b, a), a being nearer the collector. Otherwise edges are unordered.
+    bool directed = false;
+    // Link the AS before an AS_SET to each AS of the set. Otherwise paths are cut at AS_SETs.
+    bool as_sets = false;
+    // Read confederation segments as AS_SEQUENCE and AS_SET. Otherwise paths are cut at them.
+    bool confederations = false;
+    // Room for this many distinct peers per edge on average, 16 bytes each, for peers(). 0 leaves
+    // peers out.
+    std::size_t peers_per_edge = 8;
+  };
+
+  /*
+   * Compressed sparse row adjacency: the neighbors of asns[i] are neighbors[offsets[i]] up to
+   * neighbors[offsets[i + 1]], as indexes into asns, with the visibility of each edge in routes and
+   * peers.
+   * Undirected edges are listed from both ends, directed edges from their first AS.
+   */
+  struct Csr {
+    std::vector<uint32_t> asns; // Sorted.
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> neighbors; // Sorted within each AS.
+    std::vector<uint64_t> routes;
+    std::vector<uint64_t> peers;
+  };
+
+  class Extractor;
+
+  /* Room for at least capacity edges. */
+  explicit AsTopology(std::size_t capacity) : AsTopology(capacity, Options()) {}
+  AsTopology(std::size_t capacity, Options options)
+    : edges_(capacity), edge_peers_(options.peers_per_edge ? capacity : 0),
+      peer_pairs_(capacity * options.peers_per_edge), options_(options) {}
+
+  const Options& options() const { return options_; }
+
+  /* Number of edges. Approximate while extractors are running. */
+  std::size_t size() const { return edges_.size(); }
+  /* Routes whose path contains edge (a, b), in either order unless directed. */
+  uint64_t routes(uint32_t a, uint32_t b) const { return edges_.find(key(a, b)); }
+  /* Distinct peers with a route whose path contains edge (a, b); 0 if options leave them out. */
+  uint64_t peers(uint32_t a, uint32_t b) const {
+    return options_.peers_per_edge ? edge_peers_.find(key(a, b)) : 0;
+  }
+  /* Route sightings lost because the edge table was full. */
+  uint64_t overflowed() const { return overflowed_.load(std::memory_order_relaxed); }
+  /* Peer sightings lost because the (edge, peer) or peer count table was full. */
+  uint64_t peers_overflowed() const { return peers_overflowed_.load(std::memory_order_relaxed); }
+
+  /* Call f(uint32_t a, uint32_t b, uint64_t routes, uint64_t peers) for every edge, in no order. */
+  template<typename F>
+  void for_each(F&& f) const {
+    edges_.for_each([&](uint64_t key, uint64_t routes) {
+      uint64_t peers = options_.peers_per_edge ? edge_peers_.find(key) : 0;
+      f(uint32_t(key >> 32), uint32_t(key), routes, peers);
+    });
+  }
+
+  /* The adjacency of all edges, once every extractor was flushed. */
+  Csr csr() const;
+
+  std::size_t memory_usage() const {
+    return edges_.memory_usage() + edge_peers_.memory_usage() + peer_pairs_.memory_usage();
+  }
+
+private:
+  uint64_t key(uint32_t a, uint32_t b) const {
+    if (!options_.directed && b < a) std::swap(a, b);
+    return uint64_t(a) << 32 | b;
+  }
+
+  /* Non-zero key of the pair of an edge and a peer id, for peer_pairs_. */
+  static uint64_t peer_pair(uint64_t edge, uint64_t peer) {
+    uint64_t pair = utils::Hasher::hash_u64(edge ^ peer);
+    return pair ? pair : 1;
+  }
+
+  utils::ConcurrentCounter edges_;      // Edge -> routes.
+  utils::ConcurrentCounter edge_peers_; // Edge -> distinct peers.
+  utils::ConcurrentCounter peer_pairs_; // peer_pair(edge, peer), to tell new peers of an edge.
+  Options options_;
+  std::atomic<uint64_t> overflowed_{ 0 };
+  std::atomic<uint64_t> peers_overflowed_{ 0 };
+};
+
+/*
+ * Adds the edges of AS paths to an AsTopology, from one thread. The counts of recently seen edges
+ * are summed in a small direct mapped cache first, so edges near the collectors, which most paths
+ * share, don't make threads contend on the same slots. They reach the topology when evicted, on
+ * flush() and on destruction. (Edge, peer) pairs recently inserted are remembered the same way, so
+ * the routes of one peer through a common edge don't probe the topology's pair table each time.
+ */
+class AsTopology::Extractor {
+public:
+  explicit Extractor(AsTopology& topology)
+    : topology_(topology), cache_(CACHE_SIZE), pair_cache_(CACHE_SIZE) {}
+  ~Extractor() { flush(); }
+
+  Extractor(const Extractor&) = delete;
+  Extractor& operator=(const Extractor&) = delete;
+
+  /*
+   * Add the paths of the entries of a TABLE_DUMP_V2 RIB record, or the path of a BGP4MP UPDATE once
+   * per prefix it announces. Other records are ignored. peers resolves the peers of RIB entries,
+   * e.g. Reader::peer_table(); entries it has no peer for count as routes but not as peers.
+   */
+  void add(const mrt::Message& msg, const mrt::table_dump_v2::PeerTable& peers);
+  /* Add the edges of path, count times, as seen by peer; see peer_id(). No peer if 0. */
+  void add(const bgp::PathAttributes::AsPath& path, uint32_t count = 1, uint64_t peer = 0);
+
+  /* Non-zero id of the peer with address ip and AS asn. */
+  static uint64_t peer_id(const utils::IpAddr& ip, uint32_t asn) {
+    uint64_t id = utils::Hasher::hash_u64(uint64_t(ip.hash()) ^ uint64_t(asn) << 32);
+    return id ? id : 1;
+  }
+
+  /* Hand the cached counts to the topology. */
+  void flush();
+
+  /* Paths added, with their counts. */
+  uint64_t paths() const { return paths_; }
+
+private:
+  static constexpr std::size_t CACHE_SIZE = 4096;
+
+  struct CacheSlot {
+    uint64_t key = 0;
+    uint64_t routes = 0;
+    uint64_t peers = 0;
+  };
+
+  void add_edge(uint32_t a, uint32_t b, uint32_t count, uint64_t peer);
+  void flush(CacheSlot& slot);
+
+  AsTopology& topology_;
+  std::vector<CacheSlot> cache_;
+  std::vector<uint64_t> pair_cache_; // Pairs known to be in the topology.
+  uint64_t paths_ = 0;
+};
+
+} // namespace rib
+} // namespace parsebgp
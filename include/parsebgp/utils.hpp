@@ -46,7 +46,7 @@ using nonstd::span;
 using nonstd::string_view;
 
 using bytes_view = span<const uint8_t>;
-using ip_view = span<const uint8_t>; // TODO: Make this something lijke variant.
+using ip_view = span<const uint8_t>; // 4 or 16 bytes; IpAddr in utils/ip.hpp owns a copy.
 using ipv4_view = span<const uint8_t, 4>;
 using ipv6_view = span<const uint8_t, 16>;
 
@@ -126,6 +126,12 @@ private:
   LIBPARSEBGP_CPP_CRTP_SELF_ONLY_ACCESS(EnumClass, SelfT)
 };
 
+#if defined(__GNUC__) || defined(__clang__)
+#define PARSEBGP_CPP_PREFETCH(addr_) __builtin_prefetch(addr_)
+#else
+#define PARSEBGP_CPP_PREFETCH(addr_) static_cast<void>(addr_)
+#endif
+
 template<typename SelfT, typename ElementT, typename ElementCPtrT = typename ElementT::CPtr>
 class CPtrRange {
 public:
@@ -140,13 +146,24 @@ public:
     using pointer = Element*;     // dunno why this is necessary
     using reference = value_type; // no lvalue ref since it is a view already
 
+    /* Singular iterator, as required for forward iterators and parallel algorithms. */
+    Iterator() : BaseView(nullptr) {}
+    Iterator(const Iterator&) = default;
+    Iterator& operator=(const Iterator&) = default;
+    // Moving must not null the source like other views do, since algorithms reuse moved-from
+    // iterators.
+    Iterator(Iterator&& other) noexcept : BaseView(other.cptr()) {}
+    Iterator& operator=(Iterator&& other) noexcept { return (*this = other); }
+
     reference operator*() const { return { cptr() }; }
+    reference operator[](difference_type n) const { return *(*this + n); }
 
     Iterator operator+(difference_type n) const { return { SelfT::range_add(cptr(), n) }; }
     Iterator operator-(difference_type n) const { return { SelfT::range_subtract(cptr(), n) }; }
+    friend Iterator operator+(difference_type n, const Iterator& it) { return it + n; }
 
-    Iterator& operator+=(difference_type n) { return (*this = *this + 1); }
-    Iterator& operator-=(difference_type n) { return (*this = *this - 1); }
+    Iterator& operator+=(difference_type n) { return (*this = *this + n); }
+    Iterator& operator-=(difference_type n) { return (*this = *this - n); }
 
     Iterator& operator++() { return (*this += 1); }
     Iterator& operator--() { return (*this -= 1); }
@@ -162,19 +179,17 @@ public:
       return it;
     }
 
-    difference_type operator-(Iterator rhs) const {
+    difference_type operator-(const Iterator& rhs) const {
       return SelfT::range_difference(cptr(), rhs.cptr());
     }
 
-    reference operator[](difference_type n) { return *(*this + n); }
+    bool operator==(const Iterator& rhs) const { return cptr() == rhs.cptr(); }
+    bool operator!=(const Iterator& rhs) const { return cptr() != rhs.cptr(); }
 
-    bool operator==(Iterator rhs) const { return cptr() == rhs.cptr(); }
-    bool operator!=(Iterator rhs) const { return cptr() != rhs.cptr(); }
-
-    bool operator<(Iterator rhs) const { return cptr() < rhs.cptr(); }
-    bool operator>(Iterator rhs) const { return cptr() > rhs.cptr(); }
-    bool operator<=(Iterator rhs) const { return cptr() <= rhs.cptr(); }
-    bool operator>=(Iterator rhs) const { return cptr() >= rhs.cptr(); }
+    bool operator<(const Iterator& rhs) const { return *this - rhs < 0; }
+    bool operator>(const Iterator& rhs) const { return *this - rhs > 0; }
+    bool operator<=(const Iterator& rhs) const { return *this - rhs <= 0; }
+    bool operator>=(const Iterator& rhs) const { return *this - rhs >= 0; }
 
   private:
     friend class CPtrRange;
@@ -186,16 +201,91 @@ public:
     Iterator(CPtr cptr) : BaseView(cptr) {}
   };
 
+  /*
+   * Forward view of the range which prefetches the element distance positions ahead of the
+   * current one. SelfT may define a static range_prefetch(ElementCPtr) to prefetch more than the
+   * element itself, e.g. data it points to.
+   */
+  class Prefetched {
+  public:
+    class Iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Element;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Element*;
+      using reference = value_type;
+
+      Iterator() = default;
+
+      reference operator*() const { return *it_; }
+
+      Iterator& operator++() {
+        ++it_;
+        if (ahead_ != end_) {
+          SelfT::range_prefetch(ahead_.cptr());
+          ++ahead_;
+        }
+        return *this;
+      }
+      Iterator operator++(int) {
+        Iterator it = *this;
+        static_cast<void>(++*this);
+        return it;
+      }
+
+      bool operator==(const Iterator& rhs) const { return it_ == rhs.it_; }
+      bool operator!=(const Iterator& rhs) const { return it_ != rhs.it_; }
+
+    private:
+      friend class Prefetched;
+      Iterator(typename CPtrRange::Iterator it,
+               typename CPtrRange::Iterator ahead,
+               typename CPtrRange::Iterator end)
+        : it_(it), ahead_(ahead), end_(end) {}
+
+      typename CPtrRange::Iterator it_;
+      typename CPtrRange::Iterator ahead_;
+      typename CPtrRange::Iterator end_;
+    };
+
+    Iterator begin() const {
+      auto ahead = begin_;
+      for (std::ptrdiff_t i = 0; i < distance_ && ahead != end_; i++, ++ahead) {
+        SelfT::range_prefetch(ahead.cptr());
+      }
+      return { begin_, ahead, end_ };
+    }
+    Iterator end() const { return { end_, end_, end_ }; }
+
+  private:
+    friend class CPtrRange;
+    Prefetched(typename CPtrRange::Iterator begin,
+               typename CPtrRange::Iterator end,
+               std::ptrdiff_t distance)
+      : begin_(begin), end_(end), distance_(distance) {}
+
+    typename CPtrRange::Iterator begin_;
+    typename CPtrRange::Iterator end_;
+    std::ptrdiff_t distance_;
+  };
+
 public:
   Iterator begin() const { return static_cast<const SelfT&>(*this).range_data(); }
   Iterator end() const { return begin() + size(); }
   std::size_t size() const { return static_cast<const SelfT&>(*this).range_size(); }
 
-  Element operator[](int i) const { return begin()[i]; }
+  Element operator[](std::size_t i) const { return begin()[std::ptrdiff_t(i)]; }
+
+  /* Iterate while prefetching elements distance positions ahead. */
+  Prefetched prefetched(std::ptrdiff_t distance = 4) const { return { begin(), end(), distance }; }
 
 private:
   using BaseRange = CPtrRange;
   LIBPARSEBGP_CPP_CRTP_SELF_ONLY_ACCESS(CPtrRange, SelfT)
+
+  /* Default prefetch hook: the element itself. */
+  static void range_prefetch(ElementCPtr ptr) { PARSEBGP_CPP_PREFETCH(ptr); }
 };
 
 #undef LIBPARSEBGP_CPP_CRTP_SELF_ONLY_ACCESS
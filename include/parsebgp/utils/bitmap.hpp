@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace parsebgp {
+namespace utils {
+
+/*
+ * Compressed bitmap of 32-bit integers in the spirit of Roaring bitmaps.
+ *
+ * Values are partitioned by their upper 16 bits into containers. A container holds its lower 16
+ * bits either as a sorted array (sparse, up to ARRAY_MAX_SIZE values) or as a 65536-bit bitset
+ * (dense). Appending values in increasing order, which is how entry ids are assigned while
+ * streaming, is amortized O(1).
+ */
+class Bitmap {
+public:
+  static constexpr std::size_t ARRAY_MAX_SIZE = 4096;
+
+  Bitmap() = default;
+
+  void add(uint32_t value);
+  bool contains(uint32_t value) const;
+
+  uint64_t cardinality() const;
+  bool empty() const { return containers_.empty(); }
+  void clear() { containers_.clear(); }
+
+  Bitmap& operator&=(const Bitmap& rhs);
+  Bitmap& operator|=(const Bitmap& rhs);
+
+  friend Bitmap operator&(const Bitmap& lhs, const Bitmap& rhs);
+  friend Bitmap operator|(const Bitmap& lhs, const Bitmap& rhs);
+
+  bool operator==(const Bitmap& rhs) const;
+  bool operator!=(const Bitmap& rhs) const { return !(*this == rhs); }
+
+  /* Call f(uint32_t) for every value in increasing order. */
+  template<typename F>
+  void for_each(F&& f) const;
+
+  std::vector<uint32_t> to_vector() const;
+
+  std::size_t memory_usage() const;
+  void shrink_to_fit();
+
+private:
+  static constexpr std::size_t BITSET_WORDS = 65536 / 64;
+
+  struct Container {
+    uint16_t key;
+    uint32_t cardinality;
+    std::vector<uint16_t> array; // Used if bits is empty.
+    std::vector<uint64_t> bits;
+
+    bool is_bitset() const { return !bits.empty(); }
+    void add(uint16_t low);
+    bool contains(uint16_t low) const;
+    void to_bitset();
+    void to_array();
+  };
+
+  static Container intersect(const Container& lhs, const Container& rhs);
+  static Container unite(const Container& lhs, const Container& rhs);
+
+  Container* find_or_insert(uint16_t key);
+  const Container* find(uint16_t key) const;
+
+  std::vector<Container> containers_; // Sorted by key.
+};
+
+template<typename F>
+void Bitmap::for_each(F&& f) const {
+  for (auto& c : containers_) {
+    uint32_t high = uint32_t(c.key) << 16;
+    if (!c.is_bitset()) {
+      for (auto low : c.array) f(high | low);
+      continue;
+    }
+    for (std::size_t i = 0; i < BITSET_WORDS; i++) {
+      for (uint64_t word = c.bits[i]; word; word &= word - 1) {
+        f(high | uint32_t(i * 64 + __builtin_ctzll(word)));
+      }
+    }
+  }
+}
+
+} // namespace utils
+} // namespace parsebgp
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <parsebgp/utils/hash.hpp>
+
+namespace parsebgp {
+namespace utils {
+
+/*
+ * Fixed capacity map from non-zero 64-bit keys, such as packed pairs of 32-bit ids, to counts,
+ * which any number of threads add to concurrently.
+ *
+ * Open addressing with linear probing over one array of slots: a key is claimed with a single
+ * compare-and-swap on an empty slot and never moves or leaves, so lookups and additions are
+ * lock-free and need no coordination beyond the slot they touch. The table does not grow; add()
+ * fails once it holds max_size() keys, which keeps probe sequences short.
+ */
+class ConcurrentCounter {
+public:
+  /* Room for at least capacity keys; the slots are rounded up to a power of two. */
+  explicit ConcurrentCounter(std::size_t capacity)
+    : slots_(ceil_pow2(capacity + capacity / 4 + 1)), mask_(slots_.size() - 1) {}
+
+  ConcurrentCounter(const ConcurrentCounter&) = delete;
+  ConcurrentCounter& operator=(const ConcurrentCounter&) = delete;
+
+  enum class Insert { INSERTED, PRESENT, FULL };
+
+  /* Add count to key, inserting it if needed. Return false if key is new and the table is full. */
+  bool add(uint64_t key, uint64_t count) {
+    Insert result;
+    Slot* slot = claim(key, result);
+    if (!slot) return false;
+    slot->count.fetch_add(count, std::memory_order_relaxed);
+    return true;
+  }
+
+  /*
+   * Insert key with count 0 if absent, e.g. to count distinct keys by what the result reports.
+   * Keys already present are only read, so repeated inserts don't contend.
+   */
+  Insert insert(uint64_t key) {
+    Insert result;
+    claim(key, result);
+    return result;
+  }
+
+  /* Count of key, 0 if absent. */
+  uint64_t find(uint64_t key) const {
+    assert(key != EMPTY);
+    for (std::size_t i = std::size_t(Hasher::hash_u64(key)) & mask_;; i = (i + 1) & mask_) {
+      uint64_t current = slots_[i].key.load(std::memory_order_relaxed);
+      if (current == key) return slots_[i].count.load(std::memory_order_relaxed);
+      if (current == EMPTY) return 0;
+    }
+  }
+
+  /*
+   * Call f(uint64_t key, uint64_t count) for every key, in no particular order. Counts added
+   * concurrently may or may not be seen; join the adding threads first for exact counts.
+   */
+  template<typename F>
+  void for_each(F&& f) const {
+    for (auto& slot : slots_) {
+      uint64_t key = slot.key.load(std::memory_order_relaxed);
+      if (key != EMPTY) f(key, slot.count.load(std::memory_order_relaxed));
+    }
+  }
+
+  /* Number of keys. Approximate while keys are being added. */
+  std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+  /* At least one slot stays empty, which ends every probe sequence. */
+  std::size_t max_size() const {
+    return slots_.size() - std::max<std::size_t>(1, slots_.size() / 5);
+  }
+  std::size_t memory_usage() const { return slots_.size() * sizeof(Slot); }
+
+  /* Not safe during concurrent calls. */
+  void clear() {
+    for (auto& slot : slots_) {
+      slot.key.store(EMPTY, std::memory_order_relaxed);
+      slot.count.store(0, std::memory_order_relaxed);
+    }
+    size_.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr uint64_t EMPTY = 0;
+
+  struct Slot {
+    std::atomic<uint64_t> key{ EMPTY };
+    std::atomic<uint64_t> count{ 0 };
+  };
+
+  /* The slot of key, claimed if absent; null if key is new and the table is full. */
+  Slot* claim(uint64_t key, Insert& result) {
+    assert(key != EMPTY);
+    for (std::size_t i = std::size_t(Hasher::hash_u64(key)) & mask_;; i = (i + 1) & mask_) {
+      auto& slot = slots_[i];
+      uint64_t current = slot.key.load(std::memory_order_relaxed);
+      if (current == EMPTY) {
+        // Reserve the room first, so racing insertions can't claim more than max_size() slots.
+        if (size_.fetch_add(1, std::memory_order_relaxed) >= max_size()) {
+          size_.fetch_sub(1, std::memory_order_relaxed);
+          result = Insert::FULL;
+          return nullptr;
+        }
+        if (slot.key.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+          result = Insert::INSERTED;
+          return &slot;
+        }
+        size_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      if (current == key) {
+        result = Insert::PRESENT;
+        return &slot;
+      }
+    }
+  }
+
+  static std::size_t ceil_pow2(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  std::vector<Slot> slots_;
+  std::size_t mask_;
+  std::atomic<std::size_t> size_{ 0 };
+};
+
+} // namespace utils
+} // namespace parsebgp
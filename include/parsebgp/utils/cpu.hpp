@@ -0,0 +1,36 @@
+#pragma once
+
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace utils {
+
+/* x86 vector extensions used by the kernels with runtime dispatch, narrowest first. */
+class Isa : public EnumClass<Isa> {
+public:
+  enum Value {
+    SCALAR,
+    AVX2,
+    AVX512,
+  };
+
+  // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+  Isa(Value value) : value_(value) {}
+
+  // NOLINTNEXTLINE(google-explicit-constructor): Enum class.
+  operator Value() const { return value_; }
+
+  Value value() const { return value_; }
+  bool is_scalar() const { return value_ == SCALAR; }
+  bool is_avx2() const { return value_ == AVX2; }
+  bool is_avx512() const { return value_ == AVX512; }
+
+private:
+  Value value_;
+};
+
+/* Widest instruction set supported by both the build and the running CPU. */
+Isa supported_isa();
+
+} // namespace utils
+} // namespace parsebgp
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace parsebgp {
+namespace utils {
+
+/*
+ * Streaming 64-bit non-cryptographic hash used for fingerprinting decoded structures.
+ *
+ * Input is consumed in 8-byte words and folded with a 64x64->128 bit multiply, so the cost is a
+ * couple of cycles per word. It is *not* resistant to adversarial inputs; it is meant to detect
+ * equality of data coming out of the decoder, not to key untrusted hash tables.
+ */
+class Hasher {
+public:
+  static constexpr uint64_t DEFAULT_SEED = 0x9e3779b97f4a7c15ULL;
+
+  explicit Hasher(uint64_t seed = DEFAULT_SEED) : state_(seed) {}
+
+  void update(const void* data, std::size_t len) {
+    auto p = static_cast<const uint8_t*>(data);
+    total_ += len;
+    for (; len >= 8; p += 8, len -= 8) state_ = mix(state_ ^ load64(p), PRIME_1);
+    if (len) {
+      uint64_t tail = 0;
+      std::memcpy(&tail, p, len);
+      state_ = mix(state_ ^ tail, PRIME_2);
+    }
+  }
+
+  void update_u8(uint8_t value) { update_u64(value); }
+  void update_u32(uint32_t value) { update_u64(value); }
+  void update_u64(uint64_t value) {
+    total_ += sizeof(value);
+    state_ = mix(state_ ^ value, PRIME_1);
+  }
+
+  uint64_t digest() const { return mix(state_ ^ total_, PRIME_3); }
+
+  static uint64_t hash(const void* data, std::size_t len, uint64_t seed = DEFAULT_SEED) {
+    Hasher h(seed);
+    h.update(data, len);
+    return h.digest();
+  }
+
+  /* Finalizer for 64-bit integer keys (e.g. packed pairs) of open addressing tables. */
+  static uint64_t hash_u64(uint64_t value) { return mix(value ^ DEFAULT_SEED, PRIME_1); }
+
+private:
+  static constexpr uint64_t PRIME_1 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t PRIME_2 = 0xe7037ed1a0b428dbULL;
+  static constexpr uint64_t PRIME_3 = 0x8ebc6af09c88c6e3ULL;
+
+  static uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static uint64_t mix(uint64_t a, uint64_t b) {
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return uint64_t(r) ^ uint64_t(r >> 64);
+  }
+
+  uint64_t state_;
+  uint64_t total_ = 0;
+};
+
+/* Hash functor for keys which are already well-distributed fingerprints. */
+struct IdentityHash {
+  std::size_t operator()(uint64_t value) const { return std::size_t(value); }
+};
+
+} // namespace utils
+} // namespace parsebgp
@@ -0,0 +1,517 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include <parsebgp/utils.hpp>
+#include <parsebgp/utils/hash.hpp>
+
+namespace parsebgp {
+namespace utils {
+
+/*
+ * Owned IP address and prefix values, for keys of maps and sets and for anything which outlives the
+ * message its addresses were decoded from. Unlike ip_view they are small trivially copyable values:
+ * addresses are host order integers, so ordering is numeric and matches the order of the network
+ * order bytes, and prefixes keep the bits past their length zero, so equal prefixes are equal
+ * values.
+ *
+ * Parsing accepts the text inet_pton() accepts, formatting writes what inet_ntop() writes (RFC
+ * 5952 for IPv6); both are constexpr. format() writes to out, which must have room for MAX_SIZE
+ * bytes, and returns the end of the text.
+ */
+
+namespace ip_detail {
+
+constexpr char* write_decimal(char* out, unsigned value) {
+  if (value >= 100) *out++ = char('0' + value / 100);
+  if (value >= 10) *out++ = char('0' + value / 10 % 10);
+  *out++ = char('0' + value % 10);
+  return out;
+}
+
+constexpr char* write_hex(char* out, unsigned value) {
+  constexpr const char* DIGITS = "0123456789abcdef";
+  bool started = false;
+  for (int shift = 12; shift >= 0; shift -= 4) {
+    unsigned digit = value >> shift & 0xf;
+    if (!digit && !started && shift) continue;
+    started = true;
+    *out++ = DIGITS[digit];
+  }
+  return out;
+}
+
+constexpr int hex_digit(char c) {
+  if ('0' <= c && c <= '9') return c - '0';
+  if ('a' <= c && c <= 'f') return c - 'a' + 10;
+  if ('A' <= c && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* Decimal number of at most max, without leading zeros, from the start of text. */
+constexpr std::optional<unsigned> parse_decimal(string_view& text, unsigned max) {
+  if (text.empty() || text[0] < '0' || text[0] > '9') return std::nullopt;
+  if (text[0] == '0' && text.size() > 1 && '0' <= text[1] && text[1] <= '9') return std::nullopt;
+  unsigned value = 0;
+  std::size_t i = 0;
+  for (; i < text.size() && '0' <= text[i] && text[i] <= '9'; i++) {
+    value = value * 10 + unsigned(text[i] - '0');
+    if (value > max) return std::nullopt;
+  }
+  text.remove_prefix(i);
+  return value;
+}
+
+/* Dotted quad at the start of text. */
+constexpr std::optional<uint32_t> parse_ipv4(string_view& text) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    if (i) {
+      if (text.empty() || text[0] != '.') return std::nullopt;
+      text.remove_prefix(1);
+    }
+    auto octet = parse_decimal(text, 255);
+    if (!octet) return std::nullopt;
+    value = value << 8 | *octet;
+  }
+  return value;
+}
+
+} // namespace ip_detail
+
+class Ipv4Addr {
+public:
+  static constexpr unsigned BITS = 32;
+  // "255.255.255.255".
+  static constexpr std::size_t MAX_SIZE = 15;
+
+  constexpr Ipv4Addr() = default;
+  /* Host byte order. */
+  constexpr explicit Ipv4Addr(uint32_t value) : value_(value) {}
+  // NOLINTNEXTLINE(google-explicit-constructor): Allow conversion of decoded addresses.
+  constexpr Ipv4Addr(ipv4_view bytes) : Ipv4Addr(from_bytes(bytes.data())) {}
+
+  /* 4 bytes in network byte order. */
+  static constexpr Ipv4Addr from_bytes(const uint8_t* bytes) {
+    return Ipv4Addr(uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 |
+                    uint32_t(bytes[3]));
+  }
+  /* Unset unless the whole of text is an address. */
+  static constexpr std::optional<Ipv4Addr> parse(string_view text) {
+    auto value = ip_detail::parse_ipv4(text);
+    if (!value || !text.empty()) return std::nullopt;
+    return Ipv4Addr(*value);
+  }
+
+  /* Host byte order. */
+  constexpr uint32_t value() const { return value_; }
+  constexpr void to_bytes(uint8_t* out) const {
+    for (int i = 0; i < 4; i++) out[i] = uint8_t(value_ >> (24 - 8 * i));
+  }
+
+  /* Bit i, counting from the most significant. */
+  constexpr bool bit(unsigned i) const { return value_ >> (BITS - 1 - i) & 1; }
+  /* The first len bits, the others cleared. */
+  constexpr Ipv4Addr masked(unsigned len) const {
+    return Ipv4Addr(len ? value_ & ~uint32_t(0) << (BITS - len) : 0);
+  }
+
+  constexpr char* format(char* out) const {
+    for (int i = 0; i < 4; i++) {
+      if (i) *out++ = '.';
+      out = ip_detail::write_decimal(out, value_ >> (24 - 8 * i) & 0xff);
+    }
+    return out;
+  }
+  std::string to_string() const {
+    char text[MAX_SIZE];
+    return { text, format(text) };
+  }
+
+  std::size_t hash() const { return std::size_t(Hasher::hash_u64(value_)); }
+
+  friend constexpr bool operator==(Ipv4Addr lhs, Ipv4Addr rhs) { return lhs.value_ == rhs.value_; }
+  friend constexpr bool operator!=(Ipv4Addr lhs, Ipv4Addr rhs) { return lhs.value_ != rhs.value_; }
+  friend constexpr bool operator<(Ipv4Addr lhs, Ipv4Addr rhs) { return lhs.value_ < rhs.value_; }
+  friend constexpr bool operator>(Ipv4Addr lhs, Ipv4Addr rhs) { return rhs < lhs; }
+  friend constexpr bool operator<=(Ipv4Addr lhs, Ipv4Addr rhs) { return !(rhs < lhs); }
+  friend constexpr bool operator>=(Ipv4Addr lhs, Ipv4Addr rhs) { return !(lhs < rhs); }
+
+private:
+  uint32_t value_ = 0;
+};
+
+class Ipv6Addr {
+public:
+  static constexpr unsigned BITS = 128;
+  // "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff".
+  static constexpr std::size_t MAX_SIZE = 39;
+
+  constexpr Ipv6Addr() = default;
+  /* The upper and lower 64 bits. */
+  constexpr Ipv6Addr(uint64_t hi, uint64_t lo) : hi_(hi), lo_(lo) {}
+  // NOLINTNEXTLINE(google-explicit-constructor): Allow conversion of decoded addresses.
+  constexpr Ipv6Addr(ipv6_view bytes) : Ipv6Addr(from_bytes(bytes.data())) {}
+
+  /* 16 bytes in network byte order. */
+  static constexpr Ipv6Addr from_bytes(const uint8_t* bytes) {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+    for (int i = 0; i < 8; i++) {
+      hi = hi << 8 | bytes[i];
+      lo = lo << 8 | bytes[8 + i];
+    }
+    return { hi, lo };
+  }
+  /* Unset unless the whole of text is an address. */
+  static constexpr std::optional<Ipv6Addr> parse(string_view text);
+
+  constexpr uint64_t hi() const { return hi_; }
+  constexpr uint64_t lo() const { return lo_; }
+  constexpr void to_bytes(uint8_t* out) const {
+    for (int i = 0; i < 8; i++) {
+      out[i] = uint8_t(hi_ >> (56 - 8 * i));
+      out[8 + i] = uint8_t(lo_ >> (56 - 8 * i));
+    }
+  }
+
+  /* Group i of the 8 16-bit groups of the text form. */
+  constexpr uint16_t group(unsigned i) const {
+    return uint16_t((i < 4 ? hi_ : lo_) >> (48 - 16 * (i % 4)));
+  }
+  /* Bit i, counting from the most significant. */
+  constexpr bool bit(unsigned i) const { return (i < 64 ? hi_ : lo_) >> (63 - i % 64) & 1; }
+  /* The first len bits, the others cleared. */
+  constexpr Ipv6Addr masked(unsigned len) const {
+    if (len <= 64) return { len ? hi_ & ~uint64_t(0) << (64 - len) : 0, 0 };
+    return { hi_, lo_ & ~uint64_t(0) << (BITS - len) };
+  }
+
+  /* ::ffff:0:0/96, written with the IPv4 address at the end. */
+  constexpr bool is_ipv4_mapped() const { return !hi_ && lo_ >> 32 == 0xffff; }
+
+  constexpr char* format(char* out) const;
+  std::string to_string() const {
+    char text[MAX_SIZE];
+    return { text, format(text) };
+  }
+
+  std::size_t hash() const { return std::size_t(Hasher::hash_u64(hi_ ^ Hasher::hash_u64(lo_))); }
+
+  friend constexpr bool operator==(Ipv6Addr lhs, Ipv6Addr rhs) {
+    return lhs.hi_ == rhs.hi_ && lhs.lo_ == rhs.lo_;
+  }
+  friend constexpr bool operator!=(Ipv6Addr lhs, Ipv6Addr rhs) { return !(lhs == rhs); }
+  friend constexpr bool operator<(Ipv6Addr lhs, Ipv6Addr rhs) {
+    return lhs.hi_ < rhs.hi_ || (lhs.hi_ == rhs.hi_ && lhs.lo_ < rhs.lo_);
+  }
+  friend constexpr bool operator>(Ipv6Addr lhs, Ipv6Addr rhs) { return rhs < lhs; }
+  friend constexpr bool operator<=(Ipv6Addr lhs, Ipv6Addr rhs) { return !(rhs < lhs); }
+  friend constexpr bool operator>=(Ipv6Addr lhs, Ipv6Addr rhs) { return !(lhs < rhs); }
+
+private:
+  uint64_t hi_ = 0;
+  uint64_t lo_ = 0;
+};
+
+constexpr std::optional<Ipv6Addr> Ipv6Addr::parse(string_view text) {
+  uint16_t groups[8] = {};
+  int size = 0;
+  // Position of "::" in groups, or -1.
+  int gap = -1;
+
+  if (text.size() >= 2 && text[0] == ':' && text[1] == ':') {
+    gap = 0;
+    text.remove_prefix(2);
+  } else if (!text.empty() && text[0] == ':') {
+    return std::nullopt;
+  }
+  while (!text.empty()) {
+    if (size == 8) return std::nullopt;
+    // A trailing dotted quad takes the last two groups.
+    std::size_t digits = 0;
+    while (digits < text.size() && ip_detail::hex_digit(text[digits]) >= 0) digits++;
+    if (digits < text.size() && text[digits] == '.') {
+      if (size > 6) return std::nullopt;
+      auto ipv4 = ip_detail::parse_ipv4(text);
+      if (!ipv4 || !text.empty()) return std::nullopt;
+      groups[size++] = uint16_t(*ipv4 >> 16);
+      groups[size++] = uint16_t(*ipv4);
+      break;
+    }
+    if (!digits || digits > 4) return std::nullopt;
+    unsigned group = 0;
+    for (std::size_t i = 0; i < digits; i++) {
+      group = group << 4 | unsigned(ip_detail::hex_digit(text[i]));
+    }
+    groups[size++] = uint16_t(group);
+    text.remove_prefix(digits);
+
+    if (text.empty()) break;
+    if (text[0] != ':') return std::nullopt;
+    text.remove_prefix(1);
+    if (!text.empty() && text[0] == ':') {
+      if (gap >= 0) return std::nullopt;
+      gap = size;
+      text.remove_prefix(1);
+    } else if (text.empty()) {
+      return std::nullopt;
+    }
+  }
+
+  if (gap < 0 ? size != 8 : size == 8) return std::nullopt;
+  uint16_t expanded[8] = {};
+  int skipped = 8 - size;
+  for (int i = 0; i < size; i++) expanded[gap >= 0 && i >= gap ? i + skipped : i] = groups[i];
+  uint64_t hi = 0;
+  uint64_t lo = 0;
+  for (int i = 0; i < 4; i++) {
+    hi = hi << 16 | expanded[i];
+    lo = lo << 16 | expanded[4 + i];
+  }
+  return Ipv6Addr(hi, lo);
+}
+
+constexpr char* Ipv6Addr::format(char* out) const {
+  // The longest run of two or more zero groups is elided, the first if several are as long.
+  int best = -1;
+  int best_size = 1;
+  for (int i = 0; i < 8;) {
+    if (group(i)) {
+      i++;
+      continue;
+    }
+    int j = i;
+    while (j < 8 && !group(j)) j++;
+    if (j - i > best_size) {
+      best = i;
+      best_size = j - i;
+    }
+    i = j;
+  }
+
+  for (int i = 0; i < 8; i++) {
+    if (i == best) {
+      *out++ = ':';
+      // IPv4 compatible and mapped addresses end with the IPv4 address.
+      if (best == 0 && (best_size == 6 || (best_size == 5 && group(5) == 0xffff))) {
+        *out++ = ':';
+        if (best_size == 5) {
+          for (int j = 0; j < 5; j++) *out++ = "ffff:"[j];
+        }
+        return Ipv4Addr(uint32_t(lo_)).format(out);
+      }
+      i += best_size - 1;
+      if (i == 7) *out++ = ':';
+      continue;
+    }
+    if (i) *out++ = ':';
+    out = ip_detail::write_hex(out, group(i));
+  }
+  return out;
+}
+
+/* IPv4 or IPv6 address. IPv4 addresses order before IPv6 addresses. */
+class IpAddr {
+public:
+  static constexpr std::size_t MAX_SIZE = Ipv6Addr::MAX_SIZE;
+
+  /* 0.0.0.0. */
+  constexpr IpAddr() = default;
+  // NOLINTNEXTLINE(google-explicit-constructor): Widen IPv4 addresses.
+  constexpr IpAddr(Ipv4Addr addr) : bits_(0, addr.value()) {}
+  // NOLINTNEXTLINE(google-explicit-constructor): Widen IPv6 addresses.
+  constexpr IpAddr(Ipv6Addr addr) : bits_(addr), ipv6_(true) {}
+
+  /* 4 or 16 bytes in network byte order, e.g. from an ip_view. */
+  static constexpr IpAddr from_bytes(ip_view bytes) {
+    assert(bytes.size() == 4 || bytes.size() == 16);
+    if (bytes.size() == 4) return Ipv4Addr::from_bytes(bytes.data());
+    return Ipv6Addr::from_bytes(bytes.data());
+  }
+  static constexpr std::optional<IpAddr> parse(string_view text) {
+    if (text.find(':') == string_view::npos) {
+      auto addr = Ipv4Addr::parse(text);
+      return addr ? std::optional<IpAddr>(*addr) : std::nullopt;
+    }
+    auto addr = Ipv6Addr::parse(text);
+    return addr ? std::optional<IpAddr>(*addr) : std::nullopt;
+  }
+
+  constexpr bool is_ipv4() const { return !ipv6_; }
+  constexpr bool is_ipv6() const { return ipv6_; }
+  constexpr Ipv4Addr ipv4() const {
+    assert(is_ipv4());
+    return Ipv4Addr(uint32_t(bits_.lo()));
+  }
+  constexpr Ipv6Addr ipv6() const {
+    assert(is_ipv6());
+    return bits_;
+  }
+
+  constexpr unsigned bits() const { return ipv6_ ? Ipv6Addr::BITS : Ipv4Addr::BITS; }
+  constexpr std::size_t size() const { return bits() / 8; }
+  /* Write size() bytes in network byte order. */
+  constexpr void to_bytes(uint8_t* out) const {
+    ipv6_ ? bits_.to_bytes(out) : ipv4().to_bytes(out);
+  }
+
+  /* Bit i, counting from the most significant. */
+  constexpr bool bit(unsigned i) const { return ipv6_ ? bits_.bit(i) : ipv4().bit(i); }
+  /* The first len bits, the others cleared. */
+  constexpr IpAddr masked(unsigned len) const {
+    return ipv6_ ? IpAddr(bits_.masked(len)) : IpAddr(ipv4().masked(len));
+  }
+
+  constexpr char* format(char* out) const { return ipv6_ ? bits_.format(out) : ipv4().format(out); }
+  std::string to_string() const {
+    char text[MAX_SIZE];
+    return { text, format(text) };
+  }
+
+  std::size_t hash() const { return bits_.hash() ^ ipv6_; }
+
+  friend constexpr bool operator==(const IpAddr& lhs, const IpAddr& rhs) {
+    return lhs.ipv6_ == rhs.ipv6_ && lhs.bits_ == rhs.bits_;
+  }
+  friend constexpr bool operator!=(const IpAddr& lhs, const IpAddr& rhs) { return !(lhs == rhs); }
+  friend constexpr bool operator<(const IpAddr& lhs, const IpAddr& rhs) {
+    return lhs.ipv6_ < rhs.ipv6_ || (lhs.ipv6_ == rhs.ipv6_ && lhs.bits_ < rhs.bits_);
+  }
+  friend constexpr bool operator>(const IpAddr& lhs, const IpAddr& rhs) { return rhs < lhs; }
+  friend constexpr bool operator<=(const IpAddr& lhs, const IpAddr& rhs) { return !(rhs < lhs); }
+  friend constexpr bool operator>=(const IpAddr& lhs, const IpAddr& rhs) { return !(lhs < rhs); }
+
+private:
+  friend class IpPrefix;
+
+  // IPv4 addresses in the lower 32 bits.
+  Ipv6Addr bits_;
+  bool ipv6_ = false;
+};
+
+/*
+ * IPv4 or IPv6 prefix, with the bits past its length cleared. Prefixes order by address family,
+ * then address, then length, the order of TABLE_DUMP_V2 dumps.
+ */
+class IpPrefix {
+public:
+  // An IPv6 address and "/128".
+  static constexpr std::size_t MAX_SIZE = Ipv6Addr::MAX_SIZE + 4;
+
+  /* 0.0.0.0/0. */
+  constexpr IpPrefix() = default;
+  /* Clears the bits of addr past len, which must be at most addr.bits(). */
+  constexpr IpPrefix(IpAddr addr, uint8_t len)
+    : bits_(addr.masked(len).bits_), ipv6_(addr.is_ipv6()), len_(len) {
+    assert(len <= addr.bits());
+  }
+
+  /*
+   * Prefix of len bits with the address bytes in network byte order, as decoded. Lengths past the
+   * address are clamped to it rather than trusted.
+   */
+  static constexpr IpPrefix from_bytes(bool ipv6, const uint8_t* addr, uint8_t len) {
+    if (ipv6) return { Ipv6Addr::from_bytes(addr), len < 128 ? len : uint8_t(128) };
+    return { Ipv4Addr::from_bytes(addr), len < 32 ? len : uint8_t(32) };
+  }
+  /* "addr/len"; unset unless the whole of text is a prefix. Bits past len are cleared. */
+  static constexpr std::optional<IpPrefix> parse(string_view text) {
+    auto slash = text.rfind('/');
+    if (slash == string_view::npos) return std::nullopt;
+    auto addr = IpAddr::parse(text.substr(0, slash));
+    if (!addr) return std::nullopt;
+    text.remove_prefix(slash + 1);
+    auto len = ip_detail::parse_decimal(text, addr->bits());
+    if (!len || !text.empty()) return std::nullopt;
+    return IpPrefix(*addr, uint8_t(*len));
+  }
+
+  constexpr IpAddr addr() const {
+    return ipv6_ ? IpAddr(bits_) : IpAddr(Ipv4Addr(uint32_t(bits_.lo())));
+  }
+  constexpr uint8_t len() const { return len_; }
+  constexpr bool is_ipv4() const { return !ipv6_; }
+  constexpr bool is_ipv6() const { return ipv6_; }
+
+  /* Whether addr is in the prefix. */
+  constexpr bool contains(const IpAddr& addr) const {
+    return addr.is_ipv6() == ipv6_ && addr.masked(len_).bits_ == bits_;
+  }
+  /* Whether prefix is this prefix or more specific than it. */
+  constexpr bool contains(const IpPrefix& prefix) const {
+    return prefix.ipv6_ == ipv6_ && prefix.len_ >= len_ &&
+           prefix.addr().masked(len_).bits_ == bits_;
+  }
+
+  constexpr char* format(char* out) const {
+    out = addr().format(out);
+    *out++ = '/';
+    return ip_detail::write_decimal(out, len_);
+  }
+  std::string to_string() const {
+    char text[MAX_SIZE];
+    return { text, format(text) };
+  }
+
+  std::size_t hash() const {
+    return std::size_t(Hasher::hash_u64(bits_.hash() ^ (uint64_t(ipv6_) << 8 | len_)));
+  }
+
+  friend constexpr bool operator==(const IpPrefix& lhs, const IpPrefix& rhs) {
+    return lhs.bits_ == rhs.bits_ && lhs.ipv6_ == rhs.ipv6_ && lhs.len_ == rhs.len_;
+  }
+  friend constexpr bool operator!=(const IpPrefix& lhs, const IpPrefix& rhs) {
+    return !(lhs == rhs);
+  }
+  friend constexpr bool operator<(const IpPrefix& lhs, const IpPrefix& rhs) {
+    if (lhs.ipv6_ != rhs.ipv6_) return lhs.ipv6_ < rhs.ipv6_;
+    if (lhs.bits_ != rhs.bits_) return lhs.bits_ < rhs.bits_;
+    return lhs.len_ < rhs.len_;
+  }
+  friend constexpr bool operator>(const IpPrefix& lhs, const IpPrefix& rhs) { return rhs < lhs; }
+  friend constexpr bool operator<=(const IpPrefix& lhs, const IpPrefix& rhs) {
+    return !(rhs < lhs);
+  }
+  friend constexpr bool operator>=(const IpPrefix& lhs, const IpPrefix& rhs) {
+    return !(lhs < rhs);
+  }
+
+private:
+  // As in IpAddr, with the length in what would be padding.
+  Ipv6Addr bits_;
+  bool ipv6_ = false;
+  uint8_t len_ = 0;
+};
+
+} // namespace utils
+} // namespace parsebgp
+
+namespace std {
+
+template<>
+struct hash<parsebgp::utils::Ipv4Addr> {
+  std::size_t operator()(parsebgp::utils::Ipv4Addr addr) const { return addr.hash(); }
+};
+
+template<>
+struct hash<parsebgp::utils::Ipv6Addr> {
+  std::size_t operator()(parsebgp::utils::Ipv6Addr addr) const { return addr.hash(); }
+};
+
+template<>
+struct hash<parsebgp::utils::IpAddr> {
+  std::size_t operator()(const parsebgp::utils::IpAddr& addr) const { return addr.hash(); }
+};
+
+template<>
+struct hash<parsebgp::utils::IpPrefix> {
+  std::size_t operator()(const parsebgp::utils::IpPrefix& prefix) const { return prefix.hash(); }
+};
+
+} // namespace std
@@ -0,0 +1,29 @@
+#pragma once
+
+/*
+ * Static tracepoints (USDT) in the "parsebgp_cpp" provider, listed with e.g.
+ * `bpftrace -l 'usdt:/path/to/binary:parsebgp_cpp:*'`.
+ *
+ * A disabled probe is a single nop, so they stay compiled in. Arguments are still evaluated and
+ * must be cheap. Without <sys/sdt.h> (systemtap-sdt-dev), or with PARSEBGP_CPP_PROBES_DISABLED,
+ * probes expand to nothing and their arguments are not evaluated.
+ */
+
+#if !defined(PARSEBGP_CPP_PROBES_DISABLED) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PARSEBGP_CPP_PROBES_ENABLED
+#endif
+#endif
+
+#ifdef PARSEBGP_CPP_PROBES_ENABLED
+#define PARSEBGP_CPP_PROBE0(name_) DTRACE_PROBE(parsebgp_cpp, name_)
+#define PARSEBGP_CPP_PROBE1(name_, a1_) DTRACE_PROBE1(parsebgp_cpp, name_, a1_)
+#define PARSEBGP_CPP_PROBE2(name_, a1_, a2_) DTRACE_PROBE2(parsebgp_cpp, name_, a1_, a2_)
+#define PARSEBGP_CPP_PROBE3(name_, a1_, a2_, a3_) DTRACE_PROBE3(parsebgp_cpp, name_, a1_, a2_, a3_)
+#else
+#define PARSEBGP_CPP_PROBE0(name_) static_cast<void>(0)
+#define PARSEBGP_CPP_PROBE1(name_, a1_) static_cast<void>(0)
+#define PARSEBGP_CPP_PROBE2(name_, a1_, a2_) static_cast<void>(0)
+#define PARSEBGP_CPP_PROBE3(name_, a1_, a2_, a3_) static_cast<void>(0)
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace parsebgp {
+namespace utils {
+
+/*
+ * Bounded lock-free ring for exactly one producer and one consumer thread.
+ *
+ * Items are moved in and out in batches: a push() or pop() of n items costs one acquire load of
+ * the other side's index, and only when its cached copy says there isn't enough room, plus one
+ * release store. Indices live on separate cache lines so the two threads don't false share.
+ */
+template<typename T>
+class SpscRing {
+public:
+  /* Capacity is rounded up to a power of two. */
+  explicit SpscRing(std::size_t capacity) : slots_(ceil_pow2(capacity)), mask_(slots_.size() - 1) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  std::size_t capacity() const { return slots_.size(); }
+
+  /* Producer: move up to n items in, returning how many fit. */
+  std::size_t push(T* items, std::size_t n) {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (capacity() - (tail - head_cache_) < n) head_cache_ = head_.load(std::memory_order_acquire);
+    n = std::min(n, capacity() - (tail - head_cache_));
+    for (std::size_t i = 0; i < n; i++) slots_[(tail + i) & mask_] = std::move(items[i]);
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  /* Consumer: move up to n items out, returning how many there were. */
+  std::size_t pop(T* out, std::size_t n) {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    if (tail_cache_ - head < n) tail_cache_ = tail_.load(std::memory_order_acquire);
+    n = std::min(n, tail_cache_ - head);
+    for (std::size_t i = 0; i < n; i++) out[i] = std::move(slots_[(head + i) & mask_]);
+    head_.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  /* Approximate unless called from the consumer with the producer stopped, or vice versa. */
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+private:
+  static constexpr std::size_t CACHE_LINE = 64;
+
+  static std::size_t ceil_pow2(std::size_t n) {
+    assert(n > 0);
+    std::size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  std::vector<T> slots_;
+  std::size_t mask_;
+
+  // Written by the consumer.
+  alignas(CACHE_LINE) std::atomic<std::size_t> head_{ 0 };
+  std::size_t tail_cache_ = 0;
+
+  // Written by the producer.
+  alignas(CACHE_LINE) std::atomic<std::size_t> tail_{ 0 };
+  std::size_t head_cache_ = 0;
+};
+
+} // namespace utils
+} // namespace parsebgp
@@ -0,0 +1,325 @@
+#include <algorithm>
+
+#include <parsebgp/bgp/asn_kernels.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PARSEBGP_CPP_ASN_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace parsebgp {
+namespace bgp {
+namespace asn_kernels {
+
+namespace {
+
+/*
+ * Asn::is_public() is false exactly for three ranges: 0, 64496-131071 (documentation, private
+ * 16-bit, 65535 and the reserved 65536-131071 block) and 4200000000-4294967295 (private 32-bit and
+ * 4294967295). Kernels test these with unsigned comparisons.
+ */
+constexpr uint32_t NON_PUBLIC_LOW_BEGIN = 64496U;
+constexpr uint32_t NON_PUBLIC_LOW_SPAN = 131071U - NON_PUBLIC_LOW_BEGIN;
+constexpr uint32_t NON_PUBLIC_HIGH_BEGIN = 4200000000U;
+
+struct Kernels {
+  bool (*contains)(const uint32_t* asns, std::size_t n, uint32_t asn);
+  bool (*contains_any)(const uint32_t* asns, std::size_t n, const uint32_t* set, std::size_t m);
+  std::size_t (*find_non_public)(const uint32_t* asns, std::size_t n);
+  std::size_t (*count_prepends)(const uint32_t* asns, std::size_t n);
+};
+
+//==============================================================================
+// Scalar kernels
+//==============================================================================
+
+bool contains_scalar(const uint32_t* asns, std::size_t n, uint32_t asn) {
+  for (std::size_t i = 0; i < n; i++) {
+    if (asns[i] == asn) return true;
+  }
+  return false;
+}
+
+bool contains_any_scalar(const uint32_t* asns, std::size_t n, const uint32_t* set, std::size_t m) {
+  for (std::size_t i = 0; i < n; i++) {
+    if (contains_scalar(set, m, asns[i])) return true;
+  }
+  return false;
+}
+
+std::size_t find_non_public_scalar(const uint32_t* asns, std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    if (!Asn(asns[i]).is_public()) return i;
+  }
+  return n;
+}
+
+std::size_t count_prepends_scalar(const uint32_t* asns, std::size_t n) {
+  std::size_t count = 0;
+  for (std::size_t i = 1; i < n; i++) count += asns[i] == asns[i - 1];
+  return count;
+}
+
+constexpr Kernels SCALAR_KERNELS = {
+  contains_scalar,
+  contains_any_scalar,
+  find_non_public_scalar,
+  count_prepends_scalar,
+};
+
+#ifdef PARSEBGP_CPP_ASN_KERNELS_X86
+
+//==============================================================================
+// AVX2 kernels
+//==============================================================================
+
+#define PARSEBGP_CPP_AVX2 __attribute__((target("avx2")))
+
+PARSEBGP_CPP_AVX2 __m256i load_avx2(const uint32_t* p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+PARSEBGP_CPP_AVX2 int movemask_avx2(__m256i mask) {
+  return _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+}
+
+PARSEBGP_CPP_AVX2 bool contains_avx2(const uint32_t* asns, std::size_t n, uint32_t asn) {
+  const __m256i needle = _mm256_set1_epi32(int(asn));
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    if (movemask_avx2(_mm256_cmpeq_epi32(load_avx2(asns + i), needle))) return true;
+  }
+  return contains_scalar(asns + i, n - i, asn);
+}
+
+PARSEBGP_CPP_AVX2 bool contains_any_avx2(const uint32_t* asns,
+                                         std::size_t n,
+                                         const uint32_t* set,
+                                         std::size_t m) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i v = load_avx2(asns + i);
+    __m256i hits = _mm256_setzero_si256();
+    for (std::size_t j = 0; j < m; j++) {
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi32(v, _mm256_set1_epi32(int(set[j]))));
+    }
+    if (movemask_avx2(hits)) return true;
+  }
+  return contains_any_scalar(asns + i, n - i, set, m);
+}
+
+PARSEBGP_CPP_AVX2 std::size_t find_non_public_avx2(const uint32_t* asns, std::size_t n) {
+  const __m256i low_begin = _mm256_set1_epi32(int(NON_PUBLIC_LOW_BEGIN));
+  const __m256i low_span = _mm256_set1_epi32(int(NON_PUBLIC_LOW_SPAN));
+  const __m256i high_begin = _mm256_set1_epi32(int(NON_PUBLIC_HIGH_BEGIN));
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i v = load_avx2(asns + i);
+    const __m256i low = _mm256_sub_epi32(v, low_begin);
+    // Unsigned x <= y iff min(x, y) == x, and x >= y iff max(x, y) == x.
+    __m256i hits = _mm256_cmpeq_epi32(_mm256_min_epu32(low, low_span), low);
+    hits = _mm256_or_si256(hits, _mm256_cmpeq_epi32(_mm256_max_epu32(v, high_begin), v));
+    hits = _mm256_or_si256(hits, _mm256_cmpeq_epi32(v, _mm256_setzero_si256()));
+    if (int mask = movemask_avx2(hits)) return i + __builtin_ctz(mask);
+  }
+  return i + find_non_public_scalar(asns + i, n - i);
+}
+
+PARSEBGP_CPP_AVX2 std::size_t count_prepends_avx2(const uint32_t* asns, std::size_t n) {
+  std::size_t count = 0;
+  std::size_t i = 1;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i eq = _mm256_cmpeq_epi32(load_avx2(asns + i), load_avx2(asns + i - 1));
+    count += __builtin_popcount(movemask_avx2(eq));
+  }
+  return n ? count + count_prepends_scalar(asns + i - 1, n - i + 1) : 0;
+}
+
+#undef PARSEBGP_CPP_AVX2
+
+constexpr Kernels AVX2_KERNELS = {
+  contains_avx2,
+  contains_any_avx2,
+  find_non_public_avx2,
+  count_prepends_avx2,
+};
+
+//==============================================================================
+// AVX-512 kernels
+//==============================================================================
+
+#define PARSEBGP_CPP_AVX512 __attribute__((target("avx512f")))
+
+/* Lanes [0, n) if n < 16, otherwise all lanes. Masked-out lanes are not loaded. */
+PARSEBGP_CPP_AVX512 __mmask16 tail_mask_avx512(std::size_t n) {
+  return n >= 16 ? __mmask16(0xffff) : __mmask16((1U << n) - 1);
+}
+
+PARSEBGP_CPP_AVX512 bool contains_avx512(const uint32_t* asns, std::size_t n, uint32_t asn) {
+  const __m512i needle = _mm512_set1_epi32(int(asn));
+  for (std::size_t i = 0; i < n; i += 16) {
+    __mmask16 m = tail_mask_avx512(n - i);
+    __m512i v = _mm512_maskz_loadu_epi32(m, asns + i);
+    if (_mm512_mask_cmpeq_epi32_mask(m, v, needle)) return true;
+  }
+  return false;
+}
+
+PARSEBGP_CPP_AVX512 bool contains_any_avx512(const uint32_t* asns,
+                                             std::size_t n,
+                                             const uint32_t* set,
+                                             std::size_t m) {
+  for (std::size_t i = 0; i < n; i += 16) {
+    __mmask16 lanes = tail_mask_avx512(n - i);
+    __m512i v = _mm512_maskz_loadu_epi32(lanes, asns + i);
+    __mmask16 hits = 0;
+    for (std::size_t j = 0; j < m; j++) {
+      hits |= _mm512_mask_cmpeq_epi32_mask(lanes, v, _mm512_set1_epi32(int(set[j])));
+    }
+    if (hits) return true;
+  }
+  return false;
+}
+
+PARSEBGP_CPP_AVX512 std::size_t find_non_public_avx512(const uint32_t* asns, std::size_t n) {
+  const __m512i low_begin = _mm512_set1_epi32(int(NON_PUBLIC_LOW_BEGIN));
+  const __m512i low_span = _mm512_set1_epi32(int(NON_PUBLIC_LOW_SPAN));
+  const __m512i high_begin = _mm512_set1_epi32(int(NON_PUBLIC_HIGH_BEGIN));
+  for (std::size_t i = 0; i < n; i += 16) {
+    __mmask16 m = tail_mask_avx512(n - i);
+    __m512i v = _mm512_maskz_loadu_epi32(m, asns + i);
+    __mmask16 hits = _mm512_mask_cmple_epu32_mask(m, _mm512_sub_epi32(v, low_begin), low_span);
+    hits |= _mm512_mask_cmpge_epu32_mask(m, v, high_begin);
+    hits |= _mm512_mask_cmpeq_epi32_mask(m, v, _mm512_setzero_si512());
+    if (hits) return i + __builtin_ctz(hits);
+  }
+  return n;
+}
+
+PARSEBGP_CPP_AVX512 std::size_t count_prepends_avx512(const uint32_t* asns, std::size_t n) {
+  std::size_t count = 0;
+  for (std::size_t i = 1; i < n; i += 16) {
+    __mmask16 m = tail_mask_avx512(n - i);
+    __m512i cur = _mm512_maskz_loadu_epi32(m, asns + i);
+    __m512i prev = _mm512_maskz_loadu_epi32(m, asns + i - 1);
+    count += __builtin_popcount(_mm512_mask_cmpeq_epi32_mask(m, cur, prev));
+  }
+  return count;
+}
+
+#undef PARSEBGP_CPP_AVX512
+
+constexpr Kernels AVX512_KERNELS = {
+  contains_avx512,
+  contains_any_avx512,
+  find_non_public_avx512,
+  count_prepends_avx512,
+};
+
+#endif // PARSEBGP_CPP_ASN_KERNELS_X86
+
+//==============================================================================
+// Dispatch
+//==============================================================================
+
+const Kernels& kernels_for(Isa isa) {
+#ifdef PARSEBGP_CPP_ASN_KERNELS_X86
+  if (isa.is_avx512()) return AVX512_KERNELS;
+  if (isa.is_avx2()) return AVX2_KERNELS;
+#endif
+  return SCALAR_KERNELS;
+}
+
+const Kernels*& active_kernels() {
+  static const Kernels* kernels = &kernels_for(utils::supported_isa());
+  return kernels;
+}
+
+Isa::Value& active_isa() {
+  static Isa::Value value = utils::supported_isa();
+  return value;
+}
+
+const Kernels& kernels() {
+  return *active_kernels();
+}
+
+} // namespace
+
+Isa isa() {
+  return active_isa();
+}
+
+Isa set_isa(Isa isa) {
+  auto value = std::min(isa.value(), utils::supported_isa().value());
+  active_isa() = value;
+  active_kernels() = &kernels_for(value);
+  return value;
+}
+
+//==============================================================================
+// Kernels
+//==============================================================================
+
+bool contains(Asns asns, uint32_t asn) {
+  return kernels().contains(asns.data(), asns.size(), asn);
+}
+
+bool contains_any(Asns asns, Asns set) {
+  return kernels().contains_any(asns.data(), asns.size(), set.data(), set.size());
+}
+
+std::size_t find_non_public(Asns asns) {
+  return kernels().find_non_public(asns.data(), asns.size());
+}
+
+std::size_t count_prepends(Asns asns) {
+  return kernels().count_prepends(asns.data(), asns.size());
+}
+
+bool contains(const PathAttributes::AsPath& path, uint32_t asn) {
+  for (auto seg : path) {
+    if (contains(seg.asns(), asn)) return true;
+  }
+  return false;
+}
+
+bool contains_any(const PathAttributes::AsPath& path, Asns set) {
+  for (auto seg : path) {
+    if (contains_any(seg.asns(), set)) return true;
+  }
+  return false;
+}
+
+bool has_non_public(const PathAttributes::AsPath& path) {
+  for (auto seg : path) {
+    auto asns = seg.asns();
+    if (find_non_public(asns) != asns.size()) return true;
+  }
+  return false;
+}
+
+std::size_t count_prepends(const PathAttributes::AsPath& path) {
+  std::size_t count = 0;
+  for (auto seg : path) {
+    if (seg.type().is_as_seq()) count += count_prepends(seg.asns());
+  }
+  return count;
+}
+
+std::optional<uint32_t> origin(const PathAttributes::AsPath& path) {
+  std::optional<uint32_t> last;
+  for (auto seg : path) {
+    auto asns = seg.asns();
+    if (seg.type().is_as_seq() && !asns.empty()) {
+      last = asns[asns.size() - 1];
+    } else {
+      last.reset();
+    }
+  }
+  return last;
+}
+
+} // namespace asn_kernels
+} // namespace bgp
+} // namespace parsebgp
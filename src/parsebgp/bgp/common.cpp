@@ -54,6 +54,10 @@ utils::ipv6_view Prefix::addr() const {
   return cptr()->addr;
 }
 
+utils::IpPrefix Prefix::ip_prefix() const {
+  return utils::IpPrefix::from_bytes(afi_type().is_ipv6(), cptr()->addr, cptr()->len);
+}
+
 //==============================================================================
 // bgp::Asn
 //==============================================================================
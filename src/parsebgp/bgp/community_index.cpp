@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <vector>
+
+#include <parsebgp/bgp/community_index.hpp>
+
+namespace parsebgp {
+namespace bgp {
+
+namespace {
+
+template<typename Map, typename Keys>
+utils::Bitmap intersect_all(const Map& map, Keys keys) {
+  std::vector<const utils::Bitmap*> bitmaps;
+  bitmaps.reserve(keys.size());
+  for (auto& key : keys) {
+    auto it = map.find(key);
+    if (it == map.end()) return {};
+    bitmaps.push_back(&it->second);
+  }
+  if (bitmaps.empty()) return {};
+
+  // Start from the smallest set so intermediate results stay small.
+  std::sort(bitmaps.begin(), bitmaps.end(), [](const utils::Bitmap* l, const utils::Bitmap* r) {
+    return l->cardinality() < r->cardinality();
+  });
+  utils::Bitmap out = *bitmaps.front();
+  for (auto it = bitmaps.begin() + 1; it != bitmaps.end() && !out.empty(); it++) out &= **it;
+  return out;
+}
+
+template<typename Map, typename Keys>
+utils::Bitmap unite_any(const Map& map, Keys keys) {
+  utils::Bitmap out;
+  for (auto& key : keys) {
+    auto it = map.find(key);
+    if (it != map.end()) out |= it->second;
+  }
+  return out;
+}
+
+} // namespace
+
+//==============================================================================
+// bgp::CommunityIndex
+//==============================================================================
+
+void CommunityIndex::add(EntryId id, PathAttributes attrs) {
+  if (attrs.has_communities()) {
+    for (auto c : attrs.communities()) add_community(id, c.u32);
+  }
+  if (attrs.has_large_communities()) {
+    for (auto c : attrs.large_communities()) add_large_community(id, c);
+  }
+}
+
+void CommunityIndex::add_community(EntryId id, uint32_t community) {
+  communities_[community].add(id);
+}
+
+void CommunityIndex::add_large_community(EntryId id, const LargeCommunityKey& community) {
+  large_communities_[community].add(id);
+}
+
+const utils::Bitmap* CommunityIndex::find(uint32_t community) const {
+  auto it = communities_.find(community);
+  return it == communities_.end() ? nullptr : &it->second;
+}
+
+const utils::Bitmap* CommunityIndex::find(const LargeCommunityKey& community) const {
+  auto it = large_communities_.find(community);
+  return it == large_communities_.end() ? nullptr : &it->second;
+}
+
+utils::Bitmap CommunityIndex::all_of(utils::span<const uint32_t> communities) const {
+  return intersect_all(communities_, communities);
+}
+
+utils::Bitmap CommunityIndex::all_of(utils::span<const LargeCommunityKey> communities) const {
+  return intersect_all(large_communities_, communities);
+}
+
+utils::Bitmap CommunityIndex::any_of(utils::span<const uint32_t> communities) const {
+  return unite_any(communities_, communities);
+}
+
+utils::Bitmap CommunityIndex::any_of(utils::span<const LargeCommunityKey> communities) const {
+  return unite_any(large_communities_, communities);
+}
+
+std::size_t CommunityIndex::memory_usage() const {
+  std::size_t total = 0;
+  for (auto& kv : communities_) total += sizeof(kv) + kv.second.memory_usage();
+  for (auto& kv : large_communities_) total += sizeof(kv) + kv.second.memory_usage();
+  return total;
+}
+
+void CommunityIndex::shrink_to_fit() {
+  for (auto& kv : communities_) kv.second.shrink_to_fit();
+  for (auto& kv : large_communities_) kv.second.shrink_to_fit();
+}
+
+void CommunityIndex::clear() {
+  communities_.clear();
+  large_communities_.clear();
+}
+
+} // namespace bgp
+} // namespace parsebgp
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cassert>
+
+#include <parsebgp/bgp/community_matcher.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PARSEBGP_CPP_COMMUNITY_MATCHER_X86
+#include <immintrin.h>
+#endif
+
+namespace parsebgp {
+namespace bgp {
+
+namespace {
+
+using Matches = CommunityMatcher::Matches;
+using Lanes = std::array<uint32_t, 4>;
+
+//==============================================================================
+// Scalar kernels
+//==============================================================================
+
+Matches match_scalar(const uint32_t* values,
+                     std::size_t n,
+                     const uint32_t* masks,
+                     const uint32_t* bases,
+                     const uint32_t* spans,
+                     std::size_t patterns) {
+  Matches matches = 0;
+  for (std::size_t p = 0; p < patterns; p++) {
+    for (std::size_t i = 0; i < n; i++) {
+      if (uint32_t((values[i] & masks[p]) - bases[p]) <= spans[p]) {
+        matches |= Matches(1) << p;
+        break;
+      }
+    }
+  }
+  return matches;
+}
+
+Matches match_large_scalar(const uint32_t* values,
+                           std::size_t n,
+                           const Lanes* bases,
+                           const Lanes* spans,
+                           std::size_t patterns) {
+  Matches matches = 0;
+  for (std::size_t p = 0; p < patterns; p++) {
+    for (std::size_t i = 0; i < n; i++) {
+      const uint32_t* c = values + 3 * i;
+      if (uint32_t(c[0] - bases[p][0]) <= spans[p][0] &&
+          uint32_t(c[1] - bases[p][1]) <= spans[p][1] &&
+          uint32_t(c[2] - bases[p][2]) <= spans[p][2]) {
+        matches |= Matches(1) << p;
+        break;
+      }
+    }
+  }
+  return matches;
+}
+
+#ifdef PARSEBGP_CPP_COMMUNITY_MATCHER_X86
+
+//==============================================================================
+// AVX2 kernels
+//==============================================================================
+
+#define PARSEBGP_CPP_AVX2 __attribute__((target("avx2")))
+
+/* Unsigned x <= y as all-ones lanes, using min(x, y) == x. */
+PARSEBGP_CPP_AVX2 __m256i cmple_epu32_avx2(__m256i x, __m256i y) {
+  return _mm256_cmpeq_epi32(_mm256_min_epu32(x, y), x);
+}
+
+PARSEBGP_CPP_AVX2 Matches match_avx2(const uint32_t* values,
+                                     std::size_t n,
+                                     const uint32_t* masks,
+                                     const uint32_t* bases,
+                                     const uint32_t* spans,
+                                     std::size_t patterns) {
+  Matches matches = 0;
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+    for (std::size_t p = 0; p < patterns; p++) {
+      __m256i x = _mm256_sub_epi32(_mm256_and_si256(v, _mm256_set1_epi32(int(masks[p]))),
+                                   _mm256_set1_epi32(int(bases[p])));
+      __m256i hits = cmple_epu32_avx2(x, _mm256_set1_epi32(int(spans[p])));
+      if (_mm256_movemask_ps(_mm256_castsi256_ps(hits))) matches |= Matches(1) << p;
+    }
+  }
+  return matches | match_scalar(values + i, n - i, masks, bases, spans, patterns);
+}
+
+PARSEBGP_CPP_AVX2 Matches match_large_avx2(const uint32_t* values,
+                                           std::size_t n,
+                                           const Lanes* bases,
+                                           const Lanes* spans,
+                                           std::size_t patterns) {
+  // Two 12-byte communities per register, each widened to 4 lanes by repeating local_2.
+  const __m256i spread = _mm256_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5);
+  const __m256i six = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+  Matches matches = 0;
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m256i v = _mm256_maskload_epi32(reinterpret_cast<const int*>(values + 3 * i), six);
+    v = _mm256_permutevar8x32_epi32(v, spread);
+    for (std::size_t p = 0; p < patterns; p++) {
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bases[p].data()));
+      __m128i span = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spans[p].data()));
+      __m256i hits = cmple_epu32_avx2(_mm256_sub_epi32(v, _mm256_broadcastsi128_si256(base)),
+                                      _mm256_broadcastsi128_si256(span));
+      int mask = _mm256_movemask_ps(_mm256_castsi256_ps(hits));
+      if ((mask & 0xf) == 0xf || (mask >> 4) == 0xf) matches |= Matches(1) << p;
+    }
+  }
+  return matches | match_large_scalar(values + 3 * i, n - i, bases, spans, patterns);
+}
+
+#undef PARSEBGP_CPP_AVX2
+
+//==============================================================================
+// AVX-512 kernels
+//==============================================================================
+
+#define PARSEBGP_CPP_AVX512 __attribute__((target("avx512f")))
+
+PARSEBGP_CPP_AVX512 Matches match_avx512(const uint32_t* values,
+                                         std::size_t n,
+                                         const uint32_t* masks,
+                                         const uint32_t* bases,
+                                         const uint32_t* spans,
+                                         std::size_t patterns) {
+  Matches matches = 0;
+  for (std::size_t i = 0; i < n; i += 16) {
+    __mmask16 lanes = n - i >= 16 ? __mmask16(0xffff) : __mmask16((1U << (n - i)) - 1);
+    __m512i v = _mm512_maskz_loadu_epi32(lanes, values + i);
+    for (std::size_t p = 0; p < patterns; p++) {
+      __m512i x = _mm512_sub_epi32(_mm512_and_si512(v, _mm512_set1_epi32(int(masks[p]))),
+                                   _mm512_set1_epi32(int(bases[p])));
+      if (_mm512_mask_cmple_epu32_mask(lanes, x, _mm512_set1_epi32(int(spans[p])))) {
+        matches |= Matches(1) << p;
+      }
+    }
+  }
+  return matches;
+}
+
+/* Same 128 bits in each quarter. The maskz form avoids GCC warning on undefined upper lanes. */
+PARSEBGP_CPP_AVX512 __m512i broadcast_avx512(__m128i x) {
+  return _mm512_maskz_broadcast_i32x4(__mmask16(0xffff), x);
+}
+
+PARSEBGP_CPP_AVX512 Matches match_large_avx512(const uint32_t* values,
+                                               std::size_t n,
+                                               const Lanes* bases,
+                                               const Lanes* spans,
+                                               std::size_t patterns) {
+  // Four 12-byte communities per register, each widened to 4 lanes by repeating local_2.
+  const __m512i spread = _mm512_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5, 6, 7, 8, 8, 9, 10, 11, 11);
+  Matches matches = 0;
+  for (std::size_t i = 0; i < n; i += 4) {
+    std::size_t count = std::min<std::size_t>(n - i, 4);
+    __mmask16 lanes = __mmask16((1U << (4 * count)) - 1);
+    __m512i v = _mm512_maskz_loadu_epi32(__mmask16((1U << (3 * count)) - 1), values + 3 * i);
+    v = _mm512_maskz_permutexvar_epi32(lanes, spread, v);
+    for (std::size_t p = 0; p < patterns; p++) {
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bases[p].data()));
+      __m128i span = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spans[p].data()));
+      __mmask16 hits = _mm512_mask_cmple_epu32_mask(lanes,
+                                                    _mm512_sub_epi32(v, broadcast_avx512(base)),
+                                                    broadcast_avx512(span));
+      // A community matches if all 4 lanes of its group do.
+      for (unsigned group = hits; group; group >>= 4) {
+        if ((group & 0xf) == 0xf) {
+          matches |= Matches(1) << p;
+          break;
+        }
+      }
+    }
+  }
+  return matches;
+}
+
+#undef PARSEBGP_CPP_AVX512
+
+#endif // PARSEBGP_CPP_COMMUNITY_MATCHER_X86
+
+} // namespace
+
+//==============================================================================
+// bgp::CommunityMatcher
+//==============================================================================
+
+CommunityMatcher::CommunityMatcher() : isa_(utils::supported_isa()) {}
+
+std::size_t CommunityMatcher::add(const Pattern& pattern) {
+  assert(masks_.size() < MAX_PATTERNS);
+  masks_.push_back(pattern.mask);
+  bases_.push_back(pattern.base & pattern.mask);
+  spans_.push_back(pattern.span);
+  return masks_.size() - 1;
+}
+
+std::size_t CommunityMatcher::add(const LargePattern& pattern) {
+  assert(large_bases_.size() < MAX_PATTERNS);
+  Lanes base{ pattern.first[0], pattern.first[1], pattern.first[2], 0 };
+  Lanes span{ pattern.last[0] - pattern.first[0],
+              pattern.last[1] - pattern.first[1],
+              pattern.last[2] - pattern.first[2],
+              0xffffffff };
+  large_bases_.push_back(base);
+  large_spans_.push_back(span);
+  return large_bases_.size() - 1;
+}
+
+auto CommunityMatcher::match(utils::span<const uint32_t> communities) const -> Matches {
+  auto data = communities.data();
+  auto n = communities.size();
+#ifdef PARSEBGP_CPP_COMMUNITY_MATCHER_X86
+  if (isa_.is_avx512()) {
+    return match_avx512(data, n, masks_.data(), bases_.data(), spans_.data(), masks_.size());
+  }
+  if (isa_.is_avx2()) {
+    return match_avx2(data, n, masks_.data(), bases_.data(), spans_.data(), masks_.size());
+  }
+#endif
+  return match_scalar(data, n, masks_.data(), bases_.data(), spans_.data(), masks_.size());
+}
+
+auto CommunityMatcher::match_large(utils::span<const uint32_t> large_communities) const
+  -> Matches {
+  assert(large_communities.size() % 3 == 0);
+  auto data = large_communities.data();
+  auto n = large_communities.size() / 3;
+#ifdef PARSEBGP_CPP_COMMUNITY_MATCHER_X86
+  if (isa_.is_avx512()) {
+    return match_large_avx512(data, n, large_bases_.data(), large_spans_.data(), large_size());
+  }
+  if (isa_.is_avx2()) {
+    return match_large_avx2(data, n, large_bases_.data(), large_spans_.data(), large_size());
+  }
+#endif
+  return match_large_scalar(data, n, large_bases_.data(), large_spans_.data(), large_size());
+}
+
+bool CommunityMatcher::any(const PathAttributes& attrs) const {
+  if (size() && attrs.has_communities() && match(attrs.communities())) return true;
+  return large_size() && attrs.has_large_communities() && match(attrs.large_communities());
+}
+
+utils::Isa CommunityMatcher::set_isa(utils::Isa isa) {
+  isa_ = std::min(isa.value(), utils::supported_isa().value());
+  return isa_;
+}
+
+} // namespace bgp
+} // namespace parsebgp
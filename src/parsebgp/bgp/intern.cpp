@@ -0,0 +1,44 @@
+#include <cassert>
+
+#include <parsebgp/bgp/intern.hpp>
+
+namespace parsebgp {
+namespace bgp {
+
+//==============================================================================
+// bgp::AttributeSetInterner
+//==============================================================================
+
+auto AttributeSetInterner::intern(uint64_t fingerprint, PathAttributes attrs) -> Id {
+  auto ret = ids_.try_emplace(fingerprint, Id(sets_.size()));
+  if (!ret.second) {
+    auto id = ret.first->second;
+    sets_[id].references++;
+    return id;
+  }
+
+  assert(sets_.size() < INVALID_ID);
+  auto offset = canonical_.size();
+  attrs.append_canonical(canonical_);
+  sets_.push_back({ fingerprint, offset, uint32_t(canonical_.size() - offset), 1 });
+  return ret.first->second;
+}
+
+auto AttributeSetInterner::find(uint64_t fingerprint) const -> Id {
+  auto it = ids_.find(fingerprint);
+  return it == ids_.end() ? INVALID_ID : it->second;
+}
+
+void AttributeSetInterner::reserve(std::size_t sets) {
+  ids_.reserve(sets);
+  sets_.reserve(sets);
+}
+
+void AttributeSetInterner::clear() {
+  ids_.clear();
+  sets_.clear();
+  canonical_.clear();
+}
+
+} // namespace bgp
+} // namespace parsebgp
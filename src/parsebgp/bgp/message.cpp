@@ -0,0 +1,37 @@
+#include <cassert>
+
+#include <parsebgp/bgp/message.hpp>
+#include <parsebgp_bgp.h>
+
+namespace parsebgp {
+namespace bgp {
+
+//==============================================================================
+// bgp::Message
+//==============================================================================
+
+auto Message::type() const -> Type {
+  return Type::Value(cptr()->type);
+}
+
+uint16_t Message::length() const {
+  return cptr()->len;
+}
+
+Update Message::to_update() const {
+  assert(type().is_update());
+  return Update(cptr()->types.update);
+}
+
+//==============================================================================
+// bgp::Message::Type
+//==============================================================================
+
+static_assert(Message::Type::OPEN == int(PARSEBGP_BGP_TYPE_OPEN));
+static_assert(Message::Type::UPDATE == int(PARSEBGP_BGP_TYPE_UPDATE));
+static_assert(Message::Type::NOTIFICATION == int(PARSEBGP_BGP_TYPE_NOTIFICATION));
+static_assert(Message::Type::KEEPALIVE == int(PARSEBGP_BGP_TYPE_KEEPALIVE));
+static_assert(Message::Type::ROUTE_REFRESH == int(PARSEBGP_BGP_TYPE_ROUTE_REFRESH));
+
+} // namespace bgp
+} // namespace parsebgp
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cstddef>
 #include <parsebgp/bgp/update.hpp>
+#include <parsebgp/utils/hash.hpp>
 #include <parsebgp_bgp_update.h>
 
 namespace parsebgp {
@@ -81,6 +83,15 @@ auto PathAttributes::communities() const -> Communities {
   return &cptr()->attrs[Type::COMMUNITIES];
 }
 
+bool PathAttributes::has_originator_id() const {
+  return has_attr_type(cptr(), Type::ORIGINATOR_ID);
+}
+
+auto PathAttributes::originator_id() const -> OriginatorId {
+  assert(has_originator_id());
+  return &cptr()->attrs[Type::ORIGINATOR_ID];
+}
+
 bool PathAttributes::has_cluster_list() const {
   return has_attr_type(cptr(), Type::CLUSTER_LIST);
 }
@@ -90,6 +101,24 @@ auto PathAttributes::cluster_list() const -> ClusterList {
   return &cptr()->attrs[Type::CLUSTER_LIST];
 }
 
+bool PathAttributes::has_mp_reach() const {
+  return has_attr_type(cptr(), Type::MP_REACH_NLRI);
+}
+
+auto PathAttributes::mp_reach() const -> MpReach {
+  assert(has_mp_reach());
+  return &cptr()->attrs[Type::MP_REACH_NLRI];
+}
+
+bool PathAttributes::has_mp_unreach() const {
+  return has_attr_type(cptr(), Type::MP_UNREACH_NLRI);
+}
+
+auto PathAttributes::mp_unreach() const -> MpUnreach {
+  assert(has_mp_unreach());
+  return &cptr()->attrs[Type::MP_UNREACH_NLRI];
+}
+
 bool PathAttributes::has_large_communities() const {
   return has_attr_type(cptr(), Type::LARGE_COMMUNITIES);
 }
@@ -99,6 +128,130 @@ auto PathAttributes::large_communities() const -> LargeCommunities {
   return &cptr()->attrs[Type::LARGE_COMMUNITIES];
 }
 
+namespace {
+
+struct CanonicalBytes {
+  std::vector<uint8_t>& out;
+
+  void update(const void* data, size_t len) {
+    auto p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + len);
+  }
+  void update_u8(uint8_t value) { out.push_back(value); }
+  void update_u32(uint32_t value) { update(&value, sizeof(value)); }
+};
+
+template<typename Sink>
+void canonicalize_attr(const parsebgp_bgp_update_path_attr_t& attr, Sink& sink) {
+  // Extended length flag only reflects how the length was encoded.
+  sink.update_u8(attr.type);
+  sink.update_u8(attr.flags & ~PathAttributes::Flags::EXTENDED);
+
+  switch (attr.type) {
+    case PathAttributes::Type::MP_REACH_NLRI: {
+      auto* mp_reach = attr.data.mp_reach;
+      sink.update_u32(mp_reach->afi);
+      sink.update_u8(mp_reach->safi);
+      sink.update_u8(mp_reach->next_hop_len);
+      sink.update(mp_reach->next_hop, mp_reach->next_hop_len);
+      return;
+    }
+    case PathAttributes::Type::MP_UNREACH_NLRI:
+      return;
+  }
+
+  if (attr.raw) {
+    sink.update_u32(attr.len);
+    sink.update(attr.raw, attr.len);
+    return;
+  }
+
+  switch (attr.type) {
+    case PathAttributes::Type::ORIGIN:
+      sink.update_u8(attr.data.origin);
+      break;
+    case PathAttributes::Type::AS_PATH: {
+      auto* as_path = attr.data.as_path;
+      sink.update_u32(as_path->segs_cnt);
+      for (int i = 0; i < as_path->segs_cnt; i++) {
+        auto& seg = as_path->segs[i];
+        sink.update_u8(seg.type);
+        sink.update_u32(seg.asns_cnt);
+        sink.update(seg.asns, seg.asns_cnt * sizeof(*seg.asns));
+      }
+      break;
+    }
+    case PathAttributes::Type::NEXT_HOP:
+      sink.update(attr.data.next_hop, sizeof(attr.data.next_hop));
+      break;
+    case PathAttributes::Type::MED:
+      sink.update_u32(attr.data.med);
+      break;
+    case PathAttributes::Type::LOCAL_PREF:
+      sink.update_u32(attr.data.local_pref);
+      break;
+    case PathAttributes::Type::AGGREGATOR:
+      sink.update_u32(attr.data.aggregator.asn);
+      sink.update(attr.data.aggregator.addr, sizeof(attr.data.aggregator.addr));
+      break;
+    case PathAttributes::Type::COMMUNITIES: {
+      auto* communities = attr.data.communities;
+      sink.update_u32(communities->communities_cnt);
+      sink.update(communities->communities,
+                  communities->communities_cnt * sizeof(*communities->communities));
+      break;
+    }
+    case PathAttributes::Type::ORIGINATOR_ID:
+      sink.update_u32(attr.data.originator_id);
+      break;
+    case PathAttributes::Type::CLUSTER_LIST: {
+      auto* cluster_list = attr.data.cluster_list;
+      sink.update_u32(cluster_list->cluster_ids_cnt);
+      sink.update(cluster_list->cluster_ids,
+                  cluster_list->cluster_ids_cnt * sizeof(*cluster_list->cluster_ids));
+      break;
+    }
+    case PathAttributes::Type::LARGE_COMMUNITIES: {
+      auto* communities = attr.data.large_communities;
+      sink.update_u32(communities->communities_cnt);
+      for (int i = 0; i < communities->communities_cnt; i++) {
+        sink.update_u32(communities->communities[i].global_admin);
+        sink.update_u32(communities->communities[i].local_1);
+        sink.update_u32(communities->communities[i].local_2);
+      }
+      break;
+    }
+    default:
+      // Neither decoded by this library nor available raw; only its presence and length count.
+      sink.update_u32(attr.len);
+      break;
+  }
+}
+
+template<typename Sink>
+void canonicalize(const parsebgp_bgp_update_path_attrs_t* attrs, Sink& sink) {
+  uint8_t types[PARSEBGP_BGP_PATH_ATTRS_LEN];
+  auto types_end = std::copy_n(attrs->attrs_used, attrs->attrs_used_cnt, types);
+  std::sort(types, types_end);
+  for (auto type = types; type != types_end; type++) {
+    if (attrs->attrs[*type].type != *type) continue;
+    canonicalize_attr(attrs->attrs[*type], sink);
+  }
+}
+
+} // namespace
+
+uint64_t PathAttributes::fingerprint() const {
+  utils::Hasher hasher;
+  canonicalize(cptr(), hasher);
+  return hasher.digest();
+}
+
+void PathAttributes::append_canonical(std::vector<uint8_t>& out) const {
+  CanonicalBytes sink{ out };
+  canonicalize(cptr(), sink);
+}
+
 //==============================================================================
 // bgp::PathAttributes::Type
 //==============================================================================
@@ -143,8 +296,13 @@ auto PathAttributes::Base::type() const -> Type {
   return Type(Type::Value(cptr()->type));
 }
 
+utils::bytes_view PathAttributes::Base::raw() const {
+  if (!cptr()->raw) return {};
+  return { cptr()->raw, cptr()->len };
+}
+
 //==============================================================================
-// bgp::PathAttributes::{Origin, NextHop, Med, LocalPref}
+// bgp::PathAttributes::{Origin, NextHop, Med, LocalPref, OriginatorId}
 //==============================================================================
 
 #define PARSEBGP_CPP_GENERIC_PATH_ATTRIBUTE(ClassName_, MemberName_)                               \
@@ -158,6 +316,7 @@ PARSEBGP_CPP_GENERIC_PATH_ATTRIBUTE(Origin, origin)
 PARSEBGP_CPP_GENERIC_PATH_ATTRIBUTE(NextHop, next_hop)
 PARSEBGP_CPP_GENERIC_PATH_ATTRIBUTE(Med, med)
 PARSEBGP_CPP_GENERIC_PATH_ATTRIBUTE(LocalPref, local_pref)
+PARSEBGP_CPP_GENERIC_PATH_ATTRIBUTE(OriginatorId, originator_id)
 
 #undef PARSEBGP_CPP_GENERIC_PATH_ATTRIBUTE
 
@@ -177,6 +336,10 @@ std::size_t PathAttributes::AsPathSegment::range_size() const {
   return cptr()->asns_cnt;
 }
 
+utils::span<const uint32_t> PathAttributes::AsPathSegment::asns() const {
+  return { range_data(), range_size() };
+}
+
 //==============================================================================
 // bgp::PathAttributes::AsPathSegment::Type
 //==============================================================================
@@ -248,6 +411,10 @@ std::size_t PathAttributes::Communities::range_size() const {
   return cptr()->data.communities->communities_cnt;
 }
 
+utils::span<const uint32_t> PathAttributes::Communities::values() const {
+  return { range_data(), range_size() };
+}
+
 //==============================================================================
 // bgp::PathAttributes::ClusterList
 //==============================================================================
@@ -260,6 +427,10 @@ std::size_t PathAttributes::ClusterList::range_size() const {
   return cptr()->data.cluster_list->cluster_ids_cnt;
 }
 
+utils::span<const uint32_t> PathAttributes::ClusterList::values() const {
+  return { range_data(), range_size() };
+}
+
 //==============================================================================
 // bgp::PathAttributes::MpReach
 //==============================================================================
@@ -316,19 +487,19 @@ std::ptrdiff_t PathAttributes::MpReach::range_difference(const ElementCPtr lhs,
 //==============================================================================
 
 AfiType PathAttributes::MpUnreach::afi_type() const {
-  return AfiType::Value(cptr()->data.mp_reach->afi);
+  return AfiType::Value(cptr()->data.mp_unreach->afi);
 }
 
 SafiType PathAttributes::MpUnreach::safi_type() const {
-  return SafiType::Value(cptr()->data.mp_reach->safi);
+  return SafiType::Value(cptr()->data.mp_unreach->safi);
 }
 
 auto PathAttributes::MpUnreach::range_data() const -> ElementCPtr {
-  return cptr()->data.mp_reach->nlris;
+  return cptr()->data.mp_unreach->withdrawn_nlris;
 }
 
 std::size_t PathAttributes::MpUnreach::range_size() const {
-  return cptr()->data.mp_reach->nlris_cnt;
+  return cptr()->data.mp_unreach->withdrawn_nlris_cnt;
 }
 
 auto PathAttributes::MpUnreach::range_add(const ElementCPtr ptr, std::ptrdiff_t n) -> ElementCPtr {
@@ -364,6 +535,12 @@ std::size_t PathAttributes::LargeCommunities::range_size() const {
   return cptr()->data.large_communities->communities_cnt;
 }
 
+utils::span<const uint32_t> PathAttributes::LargeCommunities::values() const {
+  static_assert(sizeof(parsebgp_bgp_update_large_community) == 3 * sizeof(uint32_t),
+                "Large communities are expected to be packed triplets");
+  return { &range_data()->global_admin, 3 * range_size() };
+}
+
 auto PathAttributes::LargeCommunities::range_add(const ElementCPtr ptr, std::ptrdiff_t n)
   -> ElementCPtr {
   return ptr + n;
@@ -379,5 +556,45 @@ std::ptrdiff_t PathAttributes::LargeCommunities::range_difference(const ElementC
   return lhs - rhs;
 }
 
+//==============================================================================
+// bgp::Nlris
+//==============================================================================
+
+auto Nlris::range_data() const -> ElementCPtr {
+  return cptr()->prefixes;
+}
+
+std::size_t Nlris::range_size() const {
+  return cptr()->prefixes_cnt;
+}
+
+auto Nlris::range_add(const ElementCPtr ptr, std::ptrdiff_t n) -> ElementCPtr {
+  return ptr + n;
+}
+
+auto Nlris::range_subtract(const ElementCPtr ptr, std::ptrdiff_t n) -> ElementCPtr {
+  return ptr - n;
+}
+
+std::ptrdiff_t Nlris::range_difference(const ElementCPtr lhs, const ElementCPtr rhs) {
+  return lhs - rhs;
+}
+
+//==============================================================================
+// bgp::Update
+//==============================================================================
+
+Nlris Update::withdrawn() const {
+  return &cptr()->withdrawn_nlris;
+}
+
+PathAttributes Update::path_attributes() const {
+  return &cptr()->path_attrs;
+}
+
+Nlris Update::announced() const {
+  return &cptr()->announced_nlris;
+}
+
 } // namespace bgp
 } // namespace parsebgp
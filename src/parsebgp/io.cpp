@@ -1,35 +1,207 @@
+#include <algorithm>
 #include <bzlib.h>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
 #include <sys/mman.h>
 #include <unistd.h>
 #include <zlib.h>
 
 #include <parsebgp/io.hpp>
 
+#include "io/mirror.hpp"
+
 namespace parsebgp {
 namespace io {
 
+namespace {
+
+// 15 bits of window, plus 16 to expect a gzip wrapper or negated for raw deflate data.
+constexpr int GZIP_WINDOW_BITS = 15 + 16;
+constexpr int RAW_WINDOW_BITS = -15;
+constexpr unsigned WINDOW_SIZE = 1U << 15;
+constexpr unsigned GZIP_TRAILER_SIZE = 8;
+// Out offset, in offset and bit count before the window.
+constexpr size_t ACCESS_POINT_HEADER_SIZE = 8 + 8 + 1;
+
+void store64(std::vector<uint8_t>& out, uint64_t value) {
+  for (int i = 7; i >= 0; i--) out.push_back(uint8_t(value >> (8 * i)));
+}
+
+uint64_t load64(const uint8_t* p) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) value = value << 8 | p[i];
+  return value;
+}
+
+/* Read and drop bytes from stream, for restoring streams without usable restart state. */
+template<typename Stream>
+bool skip(Stream& stream, uint64_t bytes) {
+  std::vector<uint8_t> scratch(std::min<uint64_t>(bytes, 1 << 16));
+  while (bytes) {
+    auto length = size_t(std::min<uint64_t>(bytes, scratch.size()));
+    auto bytes_read = stream.read(scratch.data(), length);
+    bytes -= bytes_read;
+    if (bytes_read < length) return false;
+  }
+  return true;
+}
+
+} // namespace
+
 //==============================================================================
 // io::GzipStream
 //==============================================================================
 
+struct GzipStream::Inflate {
+  struct AccessPoint {
+    uint64_t out;
+    uint64_t in;
+    // Bits of the byte at in - 1 which are still to be inflated.
+    int bits;
+    std::vector<uint8_t> window;
+  };
+
+  /* Refill the input buffer. Return false at the end of the file or on error. */
+  bool fill(FILE* file) {
+    size_t bytes_read = std::fread(in.data(), 1, in.size(), file);
+    strm.next_in = in.data();
+    strm.avail_in = uInt(bytes_read);
+    in_offset += bytes_read;
+    return bytes_read > 0;
+  }
+
+  void consume_input(size_t bytes) {
+    strm.next_in += bytes;
+    strm.avail_in -= uInt(bytes);
+  }
+
+  void add_access_point() {
+    if (out_offset - (points.empty() ? 0 : points.back().out) < ACCESS_POINT_SPAN) return;
+    AccessPoint point{ out_offset, in_offset - strm.avail_in, strm.data_type & 7, {} };
+    point.window.resize(WINDOW_SIZE);
+    uInt window_size = WINDOW_SIZE;
+    if (inflateGetDictionary(&strm, point.window.data(), &window_size) != Z_OK) return;
+    point.window.resize(window_size);
+    if (points.size() == MAX_ACCESS_POINTS) points.pop_front();
+    points.push_back(std::move(point));
+  }
+
+  z_stream strm{};
+  bool initialized = false;
+  // Not gzip: bytes are passed through.
+  bool gzip = false;
+  // Restarted from an access point without the member header, so the trailer is left to skip.
+  bool raw = false;
+  bool member_end = false;
+  unsigned trailer_left = 0;
+  bool eof = false;
+  std::vector<uint8_t> in;
+  uint64_t in_offset = 0;
+  uint64_t out_offset = 0;
+  std::deque<AccessPoint> points;
+};
+
 GzipStream::GzipStream(utils::string_view path, size_t internal_buf_size)
-  : BaseView(gzopen(path.data(), "rb")), status_(Status::Value(cptr() ? Z_OK : Z_MEM_ERROR)) {
-  if (cptr()) status_ = Status(Status::Value(gzbuffer(cptr(), internal_buf_size)));
+  : BaseView(std::fopen(path.data(), "rb")), inflate_(new Inflate), status_(Status::OK) {
+  if (!cptr()) {
+    status_ = Status::ERRNO;
+    return;
+  }
+  // The input buffer below replaces stdio's.
+  std::setvbuf(cptr(), nullptr, _IONBF, 0);
+  auto& z = *inflate_;
+  z.in.resize(std::max<size_t>(internal_buf_size, 2));
+  if (inflateInit2(&z.strm, GZIP_WINDOW_BITS) != Z_OK) {
+    status_ = Status::MEM_ERROR;
+    return;
+  }
+  z.initialized = true;
+  z.fill(cptr());
+  if (std::ferror(cptr())) status_ = Status::ERRNO;
+  z.gzip = z.strm.avail_in >= 2 && z.in[0] == 0x1f && z.in[1] == 0x8b;
 }
 
 GzipStream::~GzipStream() {
+  if (inflate_ && inflate_->initialized) inflateEnd(&inflate_->strm);
   if (cptr()) {
-    int ret = gzclose_r(cptr());
-    assert(ret == Z_OK);
+    int ret = std::fclose(cptr());
+    assert(ret == 0);
   }
 }
 
+GzipStream::GzipStream(GzipStream&&) noexcept = default;
+
+GzipStream& GzipStream::operator=(GzipStream&&) noexcept = default;
+
 size_t GzipStream::read(void* buffer, size_t length) {
-  int ret = gzread(cptr(), buffer, length);
-  if (ret >= 0) return size_t(ret);
-  status_ = Status(Status::Value(ret));
-  return 0;
+  auto& z = *inflate_;
+  if (bad() || z.eof) return 0;
+  z.strm.next_out = static_cast<Bytef*>(buffer);
+  z.strm.avail_out = uInt(std::min<size_t>(length, std::numeric_limits<uInt>::max()));
+  uInt requested = z.strm.avail_out;
+
+  while (z.strm.avail_out) {
+    if (!z.strm.avail_in && !z.fill(cptr())) {
+      if (std::ferror(cptr())) {
+        status_ = Status::ERRNO;
+      } else if (z.gzip && !z.member_end) {
+        // Truncated member, reported like gzread() does.
+        status_ = Status::BUF_ERROR;
+      } else {
+        z.eof = true;
+      }
+      break;
+    }
+
+    if (!z.gzip) {
+      auto n = std::min(z.strm.avail_in, z.strm.avail_out);
+      std::memcpy(z.strm.next_out, z.strm.next_in, n);
+      z.strm.next_out += n;
+      z.strm.avail_out -= n;
+      z.out_offset += n;
+      z.consume_input(n);
+      continue;
+    }
+
+    if (z.trailer_left) {
+      auto n = std::min(z.strm.avail_in, z.trailer_left);
+      z.consume_input(n);
+      z.trailer_left -= n;
+      continue;
+    }
+
+    if (z.member_end) {
+      // Concatenated members are inflated in turn; anything else after a member is ignored.
+      if (z.strm.next_in[0] != 0x1f) {
+        z.eof = true;
+        break;
+      }
+      inflateReset2(&z.strm, GZIP_WINDOW_BITS);
+      z.member_end = false;
+    }
+
+    uInt avail_out = z.strm.avail_out;
+    int ret = inflate(&z.strm, Z_BLOCK);
+    z.out_offset += avail_out - z.strm.avail_out;
+    if (ret == Z_STREAM_END) {
+      z.member_end = true;
+      if (z.raw) z.trailer_left = GZIP_TRAILER_SIZE;
+      z.raw = false;
+    } else if (ret == Z_NEED_DICT) {
+      status_ = Status::DATA_ERROR;
+      break;
+    } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      status_ = Status(Status::Value(ret));
+      break;
+    } else if ((z.strm.data_type & 128) && !(z.strm.data_type & 64)) {
+      // At a block boundary, other than the end of the last block.
+      z.add_access_point();
+    }
+  }
+  return requested - z.strm.avail_out;
 }
 
 bool GzipStream::good() {
@@ -37,7 +209,7 @@ bool GzipStream::good() {
 }
 
 bool GzipStream::eof() {
-  return gzeof(cptr());
+  return inflate_->eof;
 }
 
 bool GzipStream::bad() const {
@@ -52,6 +224,73 @@ void GzipStream::clear_status() {
   status_ = Status::OK;
 }
 
+std::vector<uint8_t> GzipStream::access_point(uint64_t offset) const {
+  std::vector<uint8_t> out;
+  auto& points = inflate_->points;
+  auto it = std::find_if(
+    points.rbegin(), points.rend(), [&](const Inflate::AccessPoint& p) { return p.out <= offset; });
+  if (it == points.rend()) return out;
+  store64(out, it->out);
+  store64(out, it->in);
+  out.push_back(uint8_t(it->bits));
+  out.insert(out.end(), it->window.begin(), it->window.end());
+  return out;
+}
+
+bool GzipStream::restore(uint64_t offset, utils::bytes_view access_point) {
+  auto& z = *inflate_;
+  if (bad()) return false;
+  if (!z.gzip) {
+    if (fseeko(cptr(), off_t(offset), SEEK_SET) != 0) {
+      status_ = Status::ERRNO;
+      return false;
+    }
+    z.strm.avail_in = 0;
+    z.out_offset = offset;
+    return true;
+  }
+
+  if (!access_point.empty()) {
+    if (access_point.size() < ACCESS_POINT_HEADER_SIZE ||
+        access_point.size() > ACCESS_POINT_HEADER_SIZE + WINDOW_SIZE) {
+      status_ = Status::DATA_ERROR;
+      return false;
+    }
+    uint64_t out = load64(access_point.data());
+    uint64_t in = load64(access_point.data() + 8);
+    int bits = access_point[16];
+    if (out > offset || bits > 7 || in < uint64_t(bits ? 1 : 0)) {
+      status_ = Status::DATA_ERROR;
+      return false;
+    }
+    uint64_t seek_to = in - (bits ? 1 : 0);
+    if (fseeko(cptr(), off_t(seek_to), SEEK_SET) != 0) {
+      status_ = Status::ERRNO;
+      return false;
+    }
+    inflateReset2(&z.strm, RAW_WINDOW_BITS);
+    z.strm.avail_in = 0;
+    z.in_offset = seek_to;
+    if (bits) {
+      int byte = std::fgetc(cptr());
+      if (byte == EOF) {
+        status_ = Status::ERRNO;
+        return false;
+      }
+      z.in_offset++;
+      inflatePrime(&z.strm, bits, byte >> (8 - bits));
+    }
+    auto window = access_point.subspan(ACCESS_POINT_HEADER_SIZE);
+    inflateSetDictionary(&z.strm, window.data(), uInt(window.size()));
+    z.raw = true;
+    z.member_end = false;
+    z.trailer_left = 0;
+    z.out_offset = out;
+    z.points.clear();
+  }
+  return skip(*this, offset - z.out_offset);
+}
+
 //==============================================================================
 // io::Bzip2Stream
 //==============================================================================
@@ -67,8 +306,10 @@ Bzip2Stream::~Bzip2Stream() {
 }
 
 size_t Bzip2Stream::read(void* buffer, size_t length) {
+  if (!cptr()) return 0;
   int ret = BZ2_bzread(cptr(), buffer, length);
   if (ret >= 0) {
+    offset_ += uint64_t(ret);
     if (ret < length) {
       status_ = Status::Value(BZ_STREAM_END);
     }
@@ -85,7 +326,7 @@ bool Bzip2Stream::good() {
 }
 
 bool Bzip2Stream::eof() {
-  return status_ == Z_STREAM_END;
+  return status_.is_stream_end();
 }
 
 bool Bzip2Stream::bad() const {
@@ -100,55 +341,111 @@ void Bzip2Stream::clear_status() {
   status_ = Status::OK;
 }
 
+std::vector<uint8_t> Bzip2Stream::access_point(uint64_t) const {
+  return {};
+}
+
+bool Bzip2Stream::restore(uint64_t offset, utils::bytes_view) {
+  return !bad() && offset >= offset_ && skip(*this, offset - offset_);
+}
+
 //==============================================================================
-// io::MirroredRingBuffer
+// io::FileStream
 //==============================================================================
 
-utils::span<uint8_t> MirroredRingBuffer::mirror_create(size_t capacity) {
-  int fd = -1;
-  uint8_t* addr = nullptr;
-  uint8_t* tmp = nullptr;
+FileStream::FileStream(utils::string_view path)
+  : BaseView(std::fopen(path.data(), "rb")), status_(cptr() ? Status::OK : Status::ERRNO) {
+  // Reader has its own buffer, so avoid copying through stdio's.
+  if (cptr()) std::setvbuf(cptr(), nullptr, _IONBF, 0);
+}
 
-  auto page_size = size_t(getpagesize());
-  if (capacity % page_size) capacity += page_size - capacity % page_size;
+FileStream::~FileStream() {
+  if (cptr()) {
+    int ret = std::fclose(cptr());
+    assert(ret == 0);
+  }
+}
 
-  if (capacity >= 2 * capacity) return {};
+size_t FileStream::read(void* buffer, size_t length) {
+  if (!cptr()) return 0;
+  size_t ret = std::fread(buffer, 1, length, cptr());
+  if (ret < length) status_ = std::ferror(cptr()) ? Status::ERRNO : Status::STREAM_END;
+  return ret;
+}
 
-  fd = memfd_create("temp", 0);
-  if (fd == -1) return {};
+bool FileStream::good() {
+  return !bad() && !eof();
+}
 
-  int ret = ftruncate(fd, capacity);
-  if (ret) goto fail;
+bool FileStream::eof() {
+  return status_.is_stream_end();
+}
 
-  addr = static_cast<uint8_t*>(
-    mmap(nullptr, 2 * capacity, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
-  if (addr == MAP_FAILED) goto fail;
+bool FileStream::bad() const {
+  return status_.is_errno();
+}
 
-  tmp = static_cast<uint8_t*>(
-    mmap(addr, capacity, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_SHARED, fd, 0));
-  if (tmp != addr) goto fail;
+auto FileStream::status() const -> Status {
+  return status_;
+}
 
-  tmp = static_cast<uint8_t*>(
-    mmap(addr + capacity, capacity, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_SHARED, fd, 0));
-  if (tmp != addr + capacity) goto fail;
+void FileStream::clear_status() {
+  status_ = Status::OK;
+}
 
-  if (close(fd)) {
-    fd = -1;
-    goto fail;
+std::vector<uint8_t> FileStream::access_point(uint64_t) const {
+  return {};
+}
+
+bool FileStream::restore(uint64_t offset, utils::bytes_view) {
+  if (bad()) return false;
+  if (fseeko(cptr(), off_t(offset), SEEK_SET) != 0) {
+    status_ = Status::ERRNO;
+    return false;
   }
+  return true;
+}
 
-  return { addr, 2 * capacity };
+//==============================================================================
+// io::MirroredRingBuffer
+//==============================================================================
 
-fail:
-  if (fd != -1) {
-    int ret = close(fd);
-    assert(ret == 0);
+utils::span<uint8_t> map_mirrored(int fd, off_t offset, size_t size, int prot) {
+  auto* addr =
+    static_cast<uint8_t*>(mmap(nullptr, 2 * size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+  if (addr == MAP_FAILED) return {};
+
+  for (uint8_t* half : { addr, addr + size }) {
+    auto* tmp = static_cast<uint8_t*>(mmap(half, size, prot, MAP_FIXED | MAP_SHARED, fd, offset));
+    if (tmp != half) {
+      int ret = munmap(addr, 2 * size);
+      assert(ret == 0);
+      return {};
+    }
   }
-  if (addr && addr != MAP_FAILED) {
-    int ret = munmap(addr, 2 * capacity);
-    assert(ret == 0);
+  return { addr, 2 * size };
+}
+
+utils::span<uint8_t> MirroredRingBuffer::mirror_create(size_t capacity) {
+  auto page_size = size_t(getpagesize());
+  if (capacity % page_size) capacity += page_size - capacity % page_size;
+
+  if (capacity >= 2 * capacity) return {};
+
+  int fd = memfd_create("temp", 0);
+  if (fd == -1) return {};
+
+  utils::span<uint8_t> buf;
+  if (ftruncate(fd, off_t(capacity)) == 0) {
+    buf = map_mirrored(fd, 0, capacity, PROT_READ | PROT_WRITE);
   }
-  return {};
+
+  // The mappings keep the memory alive.
+  if (close(fd) && buf.data()) {
+    mirror_destroy(buf);
+    return {};
+  }
+  return buf;
 }
 
 void MirroredRingBuffer::mirror_destroy(utils::span<uint8_t> buf) noexcept {
@@ -0,0 +1,335 @@
+#include <cstring>
+
+#include <parsebgp/io/bgpdump.hpp>
+
+#include "text.hpp"
+
+namespace parsebgp {
+namespace io {
+
+namespace {
+
+using mrt::table_dump_v2::PeerTable;
+using AsPathSegmentType = bgp::PathAttributes::AsPathSegment::Type;
+
+// Longest field written with a single reserve().
+constexpr size_t MAX_FIELD_SIZE = text::MAX_PREFIX_SIZE;
+
+const char* origin_text(uint8_t origin) {
+  switch (origin) {
+    case 0:
+      return "IGP";
+    case 1:
+      return "EGP";
+    case 2:
+      return "INCOMPLETE";
+  }
+  return "";
+}
+
+/* Name bgpdump gives a well-known community (RFC 1997), or null. */
+const char* community_name(uint32_t community) {
+  switch (community) {
+    case 0xffffff01:
+      return "no-export";
+    case 0xffffff02:
+      return "no-advertise";
+    case 0xffffff03:
+      return "local-AS";
+  }
+  return nullptr;
+}
+
+/* Enclosing characters and separator of an AS path segment. */
+struct SegmentSyntax {
+  char open;
+  char close;
+  char separator;
+};
+
+SegmentSyntax segment_syntax(AsPathSegmentType type) {
+  switch (type.value()) {
+    case AsPathSegmentType::AS_SET:
+      return { '{', '}', ',' };
+    case AsPathSegmentType::CONFED_SEQ:
+      return { '(', ')', ' ' };
+    case AsPathSegmentType::CONFED_SET:
+      return { '[', ']', ',' };
+    default:
+      return { 0, 0, ' ' };
+  }
+}
+
+} // namespace
+
+//==============================================================================
+// io::BgpdumpFormatter
+//==============================================================================
+
+void BgpdumpFormatter::append(const mrt::Message& msg, const PeerTable& peers) {
+  if (msg.type().is_table_dump_v2()) {
+    auto table_dump_v2 = msg.to_table_dump_v2();
+    if (table_dump_v2.subtype().is_rib_ip()) append_rib(msg, table_dump_v2.to_rib(), peers);
+  } else if (msg.type().is_bgp4mp()) {
+    append_bgp4mp(msg.to_bgp4mp());
+  }
+}
+
+void BgpdumpFormatter::append_rib(const mrt::Message& msg,
+                                  const mrt::table_dump_v2::Rib& rib,
+                                  const PeerTable& peers) {
+  auto subtype = msg.to_table_dump_v2().subtype();
+  bool ipv6 = subtype.is_rib_ipv6_unicast() || subtype.is_rib_ipv6_multicast();
+  auto prefix = rib.prefix();
+  uint8_t prefix_len = rib.prefix_len();
+  if (!filter_.keeps(RIB) ||
+      !filter_.keeps(utils::IpPrefix::from_bytes(ipv6, prefix.data(), prefix_len))) {
+    return;
+  }
+
+  for (auto entry : rib) {
+    auto* peer = peers.find(entry.peer_index());
+    if (!peer) continue;
+    put_line_start(msg.type(), msg.timestamp_sec(), 0);
+    put("B|");
+    if (peer->is_ipv4()) {
+      uint32_t addr = peer->ipv4();
+      uint8_t bytes[4] = { uint8_t(addr >> 24), uint8_t(addr >> 16), uint8_t(addr >> 8),
+                           uint8_t(addr) };
+      put_ipv4(bytes);
+    } else {
+      put_ipv6(peers.ipv6(*peer).data());
+    }
+    put('|');
+    put_u32(peer->asn());
+    put('|');
+    put_prefix(ipv6, prefix.data(), prefix_len);
+    put('|');
+    put_attributes(entry.path_attributes(), ipv6);
+  }
+}
+
+void BgpdumpFormatter::append_bgp4mp(const mrt::bgp4mp::Message& msg) {
+  auto subtype = msg.subtype();
+
+  if (subtype.is_state_change()) {
+    if (!filter_.keeps(STATE) || filter_.prefix) return;
+    auto state_change = msg.to_state_change();
+    put_line_start(msg.type(), msg.timestamp_sec(), msg.timestamp_usec());
+    put("STATE|");
+    put_ip(msg.peer_ip());
+    put('|');
+    put_u32(msg.peer_asn());
+    put('|');
+    put_u32(state_change.old_state().value());
+    put('|');
+    put_u32(state_change.new_state().value());
+    put('\n');
+    lines_++;
+    return;
+  }
+  if (!subtype.is_message()) return;
+  auto bgp = msg.to_bgp();
+  if (!bgp.type().is_update()) return;
+  auto update = bgp.to_update();
+  auto attrs = update.path_attributes();
+
+  // Kind, peer and the separator before the prefix, shared by all lines of the same kind.
+  auto put_head = [&](char kind) {
+    put_line_start(msg.type(), msg.timestamp_sec(), msg.timestamp_usec());
+    put(kind);
+    put('|');
+    put_ip(msg.peer_ip());
+    put('|');
+    put_u32(msg.peer_asn());
+    put('|');
+  };
+  auto withdraw = [&](const bgp::Prefix& prefix) {
+    bool ipv6 = prefix.afi_type().is_ipv6();
+    if (!filter_.keeps(WITHDRAW) || !filter_.keeps(prefix.ip_prefix())) return;
+    put_head('W');
+    put_prefix(ipv6, prefix.addr().data(), prefix.len());
+    put('\n');
+    lines_++;
+  };
+  for (auto prefix : update.withdrawn()) withdraw(prefix);
+  if (attrs.has_mp_unreach()) {
+    for (auto prefix : attrs.mp_unreach()) withdraw(prefix);
+  }
+
+  // Lines of announcements differ only in the prefix: the head and the attributes of the first
+  // line of each family are copied into the following ones.
+  auto announce = [&](auto&& prefixes) {
+    if (!filter_.keeps(ANNOUNCE)) return;
+    size_t head = 0;
+    size_t head_size = 0;
+    size_t tail = 0;
+    size_t tail_size = 0;
+    uint64_t count = 0;
+    for (auto prefix : prefixes) {
+      bool ipv6 = prefix.afi_type().is_ipv6();
+      if (!filter_.keeps(prefix.ip_prefix())) continue;
+      if (!count++) {
+        head = size_;
+        put_head('A');
+        head_size = size_ - head;
+        put_prefix(ipv6, prefix.addr().data(), prefix.len());
+        put('|');
+        tail = size_;
+        put_attributes(attrs, ipv6);
+        tail_size = size_ - tail;
+      } else {
+        put_copy(head, head_size);
+        put_prefix(ipv6, prefix.addr().data(), prefix.len());
+        put('|');
+        put_copy(tail, tail_size);
+        lines_++;
+      }
+    }
+  };
+  announce(update.announced());
+  if (attrs.has_mp_reach()) announce(attrs.mp_reach());
+}
+
+bool BgpdumpFormatter::flush(FILE* file) {
+  size_t size = size_;
+  clear();
+  return std::fwrite(buffer_.data(), 1, size, file) == size;
+}
+
+void BgpdumpFormatter::put(utils::string_view s) {
+  std::memcpy(reserve(s.size()), s.data(), s.size());
+  size_ += s.size();
+}
+
+void BgpdumpFormatter::put_u32(uint32_t value) {
+  size_ = text::write_u32(reserve(text::MAX_U32_SIZE), value) - buffer_.data();
+}
+
+void BgpdumpFormatter::put_ipv4(const uint8_t* addr) {
+  size_ = text::write_ipv4(reserve(MAX_FIELD_SIZE), addr) - buffer_.data();
+}
+
+void BgpdumpFormatter::put_ipv6(const uint8_t* addr) {
+  size_ = text::write_ipv6(reserve(MAX_FIELD_SIZE), addr) - buffer_.data();
+}
+
+void BgpdumpFormatter::put_ip(utils::ip_view addr) {
+  size_ = text::write_ip(reserve(MAX_FIELD_SIZE), addr) - buffer_.data();
+}
+
+void BgpdumpFormatter::put_prefix(bool ipv6, const uint8_t* addr, uint8_t len) {
+  size_ = text::write_prefix(reserve(MAX_FIELD_SIZE), ipv6, addr, len) - buffer_.data();
+}
+
+void BgpdumpFormatter::put_line_start(mrt::Message::Type type, uint32_t sec, uint32_t usec) {
+  bool extended = type.value() == mrt::Message::Type::BGP4MP_ET;
+  if (type.is_table_dump_v2()) {
+    put("TABLE_DUMP2|");
+  } else {
+    put(extended ? "BGP4MP_ET|" : "BGP4MP|");
+  }
+  put_u32(sec);
+  if (extended) {
+    // Microseconds, zero padded to six digits.
+    char* out = reserve(7);
+    out[0] = '.';
+    for (int i = 6; i > 0; i--, usec /= 10) out[i] = char('0' + usec % 10);
+    size_ += 7;
+  }
+  put('|');
+}
+
+void BgpdumpFormatter::put_attributes(const bgp::PathAttributes& attrs, bool ipv6) {
+  if (attrs.has_as_path()) {
+    bool first = true;
+    for (auto segment : attrs.as_path()) {
+      auto syntax = segment_syntax(segment.type());
+      if (!first) put(' ');
+      first = false;
+      if (syntax.open) put(syntax.open);
+      bool first_asn = true;
+      for (uint32_t asn : segment.asns()) {
+        if (!first_asn) put(syntax.separator);
+        first_asn = false;
+        put_u32(asn);
+      }
+      if (syntax.close) put(syntax.close);
+    }
+  }
+  put('|');
+
+  put(attrs.has_origin() ? origin_text(attrs.origin().value()) : "");
+  put('|');
+
+  // Next hop of the prefix's family; inet_ntop() of the unset address when it's missing.
+  static constexpr uint8_t unset[16] = {};
+  if (ipv6) {
+    const uint8_t* next_hop = unset;
+    if (attrs.has_mp_reach()) {
+      auto raw = attrs.mp_reach().raw_next_hop();
+      if (raw.size() >= 16) next_hop = raw.data();
+    }
+    put_ipv6(next_hop);
+  } else if (attrs.has_next_hop()) {
+    put_ipv4(attrs.next_hop().value().data());
+  } else if (attrs.has_mp_reach() && attrs.mp_reach().raw_next_hop().size() == 4) {
+    put_ipv4(attrs.mp_reach().raw_next_hop().data());
+  } else {
+    put_ipv4(unset);
+  }
+  put('|');
+
+  put_u32(attrs.has_local_pref() ? attrs.local_pref().value() : 0);
+  put('|');
+  put_u32(attrs.has_med() ? attrs.med().value() : 0);
+  put('|');
+
+  bool first = true;
+  if (attrs.has_communities()) {
+    for (uint32_t community : attrs.communities().values()) {
+      if (!first) put(' ');
+      first = false;
+      if (auto name = community_name(community)) {
+        put(name);
+        continue;
+      }
+      put_u32(community >> 16);
+      put(':');
+      put_u32(community & 0xffff);
+    }
+  }
+  if (attrs.has_large_communities()) {
+    auto values = attrs.large_communities().values();
+    for (size_t i = 0; i + 2 < values.size(); i += 3) {
+      if (!first) put(' ');
+      first = false;
+      put_u32(values[i]);
+      put(':');
+      put_u32(values[i + 1]);
+      put(':');
+      put_u32(values[i + 2]);
+    }
+  }
+  put('|');
+
+  put(attrs.has_atomic_aggregate() ? "AG|" : "NAG|");
+  if (attrs.has_aggregator()) {
+    auto aggregator = attrs.aggregator();
+    put_u32(aggregator.asn());
+    put(' ');
+    put_ipv4(aggregator.addr().data());
+  }
+  put("|\n");
+  lines_++;
+}
+
+void BgpdumpFormatter::put_copy(size_t offset, size_t size) {
+  // reserve() may move the buffer, so the source is taken after it.
+  char* out = reserve(size);
+  std::memcpy(out, buffer_.data() + offset, size);
+  size_ += size;
+}
+
+} // namespace io
+} // namespace parsebgp
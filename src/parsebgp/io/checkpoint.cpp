@@ -0,0 +1,77 @@
+#include <parsebgp/io/checkpoint.hpp>
+
+namespace parsebgp {
+namespace io {
+
+namespace {
+
+// "PBCK" and a format version.
+constexpr uint32_t MAGIC = 0x5042434b;
+constexpr uint32_t VERSION = 1;
+
+void put64(std::vector<uint8_t>& out, uint64_t value) {
+  for (int i = 7; i >= 0; i--) out.push_back(uint8_t(value >> (8 * i)));
+}
+
+void put_bytes(std::vector<uint8_t>& out, const std::vector<uint8_t>& bytes) {
+  put64(out, bytes.size());
+  out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+class Parser {
+public:
+  explicit Parser(utils::bytes_view data) : data_(data) {}
+
+  bool get64(uint64_t& value) {
+    if (data_.size() - pos_ < 8) return false;
+    value = 0;
+    for (int i = 0; i < 8; i++) value = value << 8 | data_[pos_++];
+    return true;
+  }
+
+  bool get_bytes(std::vector<uint8_t>& bytes) {
+    uint64_t size;
+    if (!get64(size) || data_.size() - pos_ < size) return false;
+    bytes.assign(data_.data() + pos_, data_.data() + pos_ + size);
+    pos_ += size;
+    return true;
+  }
+
+  bool done() const { return pos_ == data_.size(); }
+
+private:
+  utils::bytes_view data_;
+  std::size_t pos_ = 0;
+};
+
+} // namespace
+
+//==============================================================================
+// io::Checkpoint
+//==============================================================================
+
+std::vector<uint8_t> Checkpoint::serialize() const {
+  std::vector<uint8_t> out;
+  put64(out, uint64_t(MAGIC) << 32 | VERSION);
+  put64(out, offset);
+  put64(out, last_timestamp ? uint64_t(1) << 32 | *last_timestamp : 0);
+  put_bytes(out, stream);
+  put_bytes(out, peer_index);
+  return out;
+}
+
+std::optional<Checkpoint> Checkpoint::deserialize(utils::bytes_view data) {
+  Parser parser(data);
+  Checkpoint checkpoint;
+  uint64_t header;
+  uint64_t timestamp;
+  if (!parser.get64(header) || header != (uint64_t(MAGIC) << 32 | VERSION)) return {};
+  if (!parser.get64(checkpoint.offset) || !parser.get64(timestamp)) return {};
+  if (timestamp >> 32) checkpoint.last_timestamp = uint32_t(timestamp);
+  if (!parser.get_bytes(checkpoint.stream) || !parser.get_bytes(checkpoint.peer_index)) return {};
+  if (!parser.done()) return {};
+  return checkpoint;
+}
+
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace io {
+
+/*
+ * Map size bytes of fd starting at offset twice, back to back, so that accesses running past the
+ * end of the first copy continue at the start of the data. size and offset must be multiples of
+ * the page size. prot is passed to mmap(). Return the 2 * size bytes, or an empty span on failure.
+ * Unmap with munmap().
+ */
+utils::span<uint8_t> map_mirrored(int fd, off_t offset, size_t size, int prot);
+
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,451 @@
+#include <cstring>
+
+#include <parsebgp/io/ndjson.hpp>
+
+#include "text.hpp"
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define PARSEBGP_CPP_NDJSON_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace parsebgp {
+namespace io {
+
+namespace {
+
+using mrt::table_dump_v2::PeerTable;
+using AsPathSegmentType = bgp::PathAttributes::AsPathSegment::Type;
+
+// Longest field written with a single reserve(): a quoted IPv6 prefix.
+constexpr size_t MAX_FIELD_SIZE = text::MAX_PREFIX_SIZE + 2;
+// Worst case of escaping one byte: "\u001f", or "\ufffd" for a byte of invalid UTF-8.
+constexpr size_t MAX_ESCAPE_SIZE = 6;
+
+const char* origin_text(uint8_t origin) {
+  switch (origin) {
+    case 0:
+      return "IGP";
+    case 1:
+      return "EGP";
+    case 2:
+      return "INCOMPLETE";
+  }
+  return "";
+}
+
+const char* segment_type_text(AsPathSegmentType type) {
+  switch (type.value()) {
+    case AsPathSegmentType::AS_SET:
+      return "AS_SET";
+    case AsPathSegmentType::AS_SEQ:
+      return "AS_SEQUENCE";
+    case AsPathSegmentType::CONFED_SEQ:
+      return "AS_CONFED_SEQUENCE";
+    case AsPathSegmentType::CONFED_SET:
+      return "AS_CONFED_SET";
+  }
+  return "";
+}
+
+char* escape_byte(char* out, uint8_t c) {
+  static constexpr char HEX[] = "0123456789abcdef";
+  char short_escape = 0;
+  switch (c) {
+    case '"':
+      short_escape = '"';
+      break;
+    case '\\':
+      short_escape = '\\';
+      break;
+    case '\b':
+      short_escape = 'b';
+      break;
+    case '\f':
+      short_escape = 'f';
+      break;
+    case '\n':
+      short_escape = 'n';
+      break;
+    case '\r':
+      short_escape = 'r';
+      break;
+    case '\t':
+      short_escape = 't';
+      break;
+  }
+  if (short_escape) {
+    out[0] = '\\';
+    out[1] = short_escape;
+    return out + 2;
+  }
+  if (c < 0x20) {
+    std::memcpy(out, "\\u00", 4);
+    out[4] = HEX[c >> 4];
+    out[5] = HEX[c & 0xf];
+    return out + 6;
+  }
+  *out = char(c);
+  return out + 1;
+}
+
+/* Length of the well-formed UTF-8 sequence at s, at most size bytes, or 0 if there is none. */
+size_t utf8_sequence(const uint8_t* s, size_t size) {
+  // Bounds of the second byte exclude overlong forms, surrogates and code points past U+10FFFF.
+  size_t length = 4;
+  uint8_t low = 0x80;
+  uint8_t high = 0xbf;
+  if (s[0] >= 0xc2 && s[0] <= 0xdf) {
+    length = 2;
+  } else if (s[0] >= 0xe0 && s[0] <= 0xef) {
+    length = 3;
+    if (s[0] == 0xe0) low = 0xa0;
+    if (s[0] == 0xed) high = 0x9f;
+  } else if (s[0] == 0xf0) {
+    low = 0x90;
+  } else if (s[0] == 0xf4) {
+    high = 0x8f;
+  } else if (s[0] < 0xf1 || s[0] > 0xf3) {
+    return 0;
+  }
+  if (size < length || s[1] < low || s[1] > high) return 0;
+  for (size_t i = 2; i < length; i++) {
+    if (s[i] < 0x80 || s[i] > 0xbf) return 0;
+  }
+  return length;
+}
+
+/* Escaped copy of the character at s + i, moving i past it. */
+char* escape_char(char* out, const uint8_t* s, size_t size, size_t& i) {
+  if (s[i] < 0x80) return escape_byte(out, s[i++]);
+  size_t length = utf8_sequence(s + i, size - i);
+  if (!length) {
+    // Names are not guaranteed to be UTF-8; each stray byte becomes U+FFFD.
+    std::memcpy(out, "\\ufffd", 6);
+    i++;
+    return out + 6;
+  }
+  std::memcpy(out, s + i, length);
+  i += length;
+  return out + length;
+}
+
+/*
+ * JSON escaped copy of the size bytes at s, which needs room for MAX_ESCAPE_SIZE * size bytes.
+ * Bytes which are not part of well-formed UTF-8 are replaced, so the output is valid JSON.
+ *
+ * Blocks of 16 ASCII bytes without a quote, backslash or control character are copied whole; each
+ * block is stored before it is checked, so a block with one is copied up to that byte and resumed
+ * after the character it starts. Names in MRT dumps rarely need escaping, so this is one compare
+ * chain and store per block.
+ */
+char* escape(char* out, const char* text, size_t size) {
+  auto s = reinterpret_cast<const uint8_t*>(text);
+  size_t i = 0;
+#ifdef PARSEBGP_CPP_NDJSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i last_control = _mm_set1_epi8(0x1f);
+  // Whole blocks are stored while 16 input bytes are left, for which the room is at least 96.
+  while (size - i >= 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    __m128i special = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+      _mm_cmpeq_epi8(_mm_min_epu8(block, last_control), block));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), block);
+    // Bytes past 0x7f have their top bit set, which movemask picks up as well.
+    auto mask = unsigned(_mm_movemask_epi8(_mm_or_si128(special, block)));
+    if (!mask) {
+      out += 16;
+      i += 16;
+      continue;
+    }
+    auto clean = unsigned(__builtin_ctz(mask));
+    out += clean;
+    i += clean;
+    out = escape_char(out, s, size, i);
+  }
+#endif
+  while (i < size) out = escape_char(out, s, size, i);
+  return out;
+}
+
+} // namespace
+
+//==============================================================================
+// io::NdjsonFormatter
+//==============================================================================
+
+void NdjsonFormatter::append(const mrt::Message& msg, const PeerTable& peers) {
+  if (msg.type().is_table_dump_v2()) {
+    auto table_dump_v2 = msg.to_table_dump_v2();
+    auto subtype = table_dump_v2.subtype();
+    if (subtype.is_peer_index_table()) {
+      append_peer_index(msg, table_dump_v2.to_peer_index());
+    } else if (subtype.is_rib_ip()) {
+      append_rib(msg, table_dump_v2.to_rib(), peers);
+    }
+  } else if (msg.type().is_bgp4mp()) {
+    append_bgp4mp(msg.to_bgp4mp());
+  }
+}
+
+void NdjsonFormatter::append_peer_index(const mrt::Message& msg,
+                                        const mrt::table_dump_v2::PeerIndex& peer_index) {
+  put_object_start("peer_index", msg.type(), msg.timestamp_sec(), 0);
+  put("\"collector_bgp_id\":");
+  put_ip(peer_index.collector_bgp_id());
+  put(",\"view_name\":");
+  put_string(peer_index.view_name());
+  put(",\"peers\":[");
+  bool first = true;
+  for (auto peer : peer_index) {
+    put(first ? "{\"bgp_id\":" : ",{\"bgp_id\":");
+    first = false;
+    put_ip(peer.bgp_id());
+    put(",\"ip\":");
+    put_ip(peer.ip());
+    put(",\"asn\":");
+    put_u32(peer.asn());
+    put('}');
+  }
+  put(']');
+  put_line_end();
+}
+
+void NdjsonFormatter::append_rib(const mrt::Message& msg,
+                                 const mrt::table_dump_v2::Rib& rib,
+                                 const PeerTable& peers) {
+  auto subtype = msg.to_table_dump_v2().subtype();
+  bool ipv6 = subtype.is_rib_ipv6_unicast() || subtype.is_rib_ipv6_multicast();
+  put_object_start("rib", msg.type(), msg.timestamp_sec(), 0);
+  put("\"sequence\":");
+  put_u32(rib.sequence_no());
+  put(",\"prefix\":");
+  put_prefix(ipv6, rib.prefix().data(), rib.prefix_len());
+  put(",\"entries\":[");
+  bool first = true;
+  for (auto entry : rib) {
+    put(first ? "{\"peer_index\":" : ",{\"peer_index\":");
+    first = false;
+    put_u32(entry.peer_index());
+    if (auto* peer = peers.find(entry.peer_index())) {
+      put(",\"peer_ip\":");
+      if (peer->is_ipv4()) {
+        uint32_t addr = peer->ipv4();
+        uint8_t bytes[4] = { uint8_t(addr >> 24), uint8_t(addr >> 16), uint8_t(addr >> 8),
+                             uint8_t(addr) };
+        put_ip(bytes);
+      } else {
+        put_ip(peers.ipv6(*peer));
+      }
+      put(",\"peer_asn\":");
+      put_u32(peer->asn());
+    }
+    put(",\"originated_time\":");
+    put_u32(entry.originated_time());
+    put(',');
+    put_attributes(entry.path_attributes());
+    put('}');
+  }
+  put(']');
+  put_line_end();
+}
+
+void NdjsonFormatter::append_bgp4mp(const mrt::bgp4mp::Message& msg) {
+  auto subtype = msg.subtype();
+  auto put_peer = [&] {
+    put("\"peer_ip\":");
+    put_ip(msg.peer_ip());
+    put(",\"peer_asn\":");
+    put_u32(msg.peer_asn());
+  };
+
+  if (subtype.is_state_change()) {
+    auto state_change = msg.to_state_change();
+    put_object_start("state", msg.type(), msg.timestamp_sec(), msg.timestamp_usec());
+    put_peer();
+    put(",\"old_state\":");
+    put_u32(state_change.old_state().value());
+    put(",\"new_state\":");
+    put_u32(state_change.new_state().value());
+    put_line_end();
+    return;
+  }
+  if (!subtype.is_message()) return;
+  auto bgp = msg.to_bgp();
+  if (!bgp.type().is_update()) return;
+  auto update = bgp.to_update();
+  auto attrs = update.path_attributes();
+
+  put_object_start("update", msg.type(), msg.timestamp_sec(), msg.timestamp_usec());
+  put_peer();
+  bool first = true;
+  auto put_prefixes = [&](auto&& prefixes) {
+    for (auto prefix : prefixes) {
+      if (!first) put(',');
+      first = false;
+      put_prefix(prefix.afi_type().is_ipv6(), prefix.addr().data(), prefix.len());
+    }
+  };
+  put(",\"withdrawn\":[");
+  put_prefixes(update.withdrawn());
+  if (attrs.has_mp_unreach()) put_prefixes(attrs.mp_unreach());
+  put("],\"announced\":[");
+  first = true;
+  put_prefixes(update.announced());
+  if (attrs.has_mp_reach()) put_prefixes(attrs.mp_reach());
+  put("],");
+  put_attributes(attrs);
+  put_line_end();
+}
+
+bool NdjsonFormatter::flush(FILE* file) {
+  size_t size = size_;
+  clear();
+  return std::fwrite(buffer_.data(), 1, size, file) == size;
+}
+
+void NdjsonFormatter::put(utils::string_view s) {
+  std::memcpy(reserve(s.size()), s.data(), s.size());
+  size_ += s.size();
+}
+
+void NdjsonFormatter::put_u32(uint32_t value) {
+  size_ = text::write_u32(reserve(text::MAX_U32_SIZE), value) - buffer_.data();
+}
+
+void NdjsonFormatter::put_string(utils::string_view s) {
+  char* out = reserve(MAX_ESCAPE_SIZE * s.size() + 2);
+  *out++ = '"';
+  out = escape(out, s.data(), s.size());
+  *out++ = '"';
+  size_ = out - buffer_.data();
+}
+
+void NdjsonFormatter::put_ip(utils::ip_view addr) {
+  char* out = reserve(MAX_FIELD_SIZE);
+  *out++ = '"';
+  out = text::write_ip(out, addr);
+  *out++ = '"';
+  size_ = out - buffer_.data();
+}
+
+void NdjsonFormatter::put_prefix(bool ipv6, const uint8_t* addr, uint8_t len) {
+  char* out = reserve(MAX_FIELD_SIZE);
+  *out++ = '"';
+  out = text::write_prefix(out, ipv6, addr, len);
+  *out++ = '"';
+  size_ = out - buffer_.data();
+}
+
+void NdjsonFormatter::put_object_start(utils::string_view type,
+                                       mrt::Message::Type record_type,
+                                       uint32_t sec,
+                                       uint32_t usec) {
+  put("{\"type\":\"");
+  put(type);
+  put("\",\"timestamp\":");
+  put_u32(sec);
+  if (record_type.value() == mrt::Message::Type::BGP4MP_ET) {
+    put(",\"timestamp_usec\":");
+    put_u32(usec);
+  }
+  put(',');
+}
+
+void NdjsonFormatter::put_attributes(const bgp::PathAttributes& attrs) {
+  // Each member starts with the separator from the previous one, '{' for the first.
+  char separator = '{';
+  auto put_key = [&](utils::string_view key) {
+    put(separator);
+    separator = ',';
+    put(key);
+  };
+
+  put("\"attributes\":");
+  if (attrs.has_origin()) {
+    put_key("\"origin\":\"");
+    put(origin_text(attrs.origin().value()));
+    put('"');
+  }
+  if (attrs.has_as_path()) {
+    put_key("\"as_path\":[");
+    bool first = true;
+    for (auto segment : attrs.as_path()) {
+      put(first ? "{\"type\":\"" : ",{\"type\":\"");
+      first = false;
+      put(segment_type_text(segment.type()));
+      put("\",\"asns\":[");
+      bool first_asn = true;
+      for (uint32_t asn : segment.asns()) {
+        if (!first_asn) put(',');
+        first_asn = false;
+        put_u32(asn);
+      }
+      put("]}");
+    }
+    put(']');
+  }
+  if (attrs.has_next_hop()) {
+    put_key("\"next_hop\":");
+    put_ip(attrs.next_hop().value());
+  }
+  if (attrs.has_mp_reach()) {
+    // The global address of IPv6 next hops which also carry a link-local one.
+    auto raw = attrs.mp_reach().raw_next_hop();
+    if (raw.size() == 4 || raw.size() >= 16) {
+      put_key("\"mp_next_hop\":");
+      put_ip(raw.size() == 4 ? utils::ip_view(raw.data(), 4) : utils::ip_view(raw.data(), 16));
+    }
+  }
+  if (attrs.has_local_pref()) {
+    put_key("\"local_pref\":");
+    put_u32(attrs.local_pref().value());
+  }
+  if (attrs.has_med()) {
+    put_key("\"med\":");
+    put_u32(attrs.med().value());
+  }
+  if (attrs.has_atomic_aggregate()) put_key("\"atomic_aggregate\":true");
+  if (attrs.has_aggregator()) {
+    auto aggregator = attrs.aggregator();
+    put_key("\"aggregator\":{\"asn\":");
+    put_u32(aggregator.asn());
+    put(",\"ip\":");
+    put_ip(aggregator.addr());
+    put('}');
+  }
+  if (attrs.has_communities()) {
+    put_key("\"communities\":[");
+    bool first = true;
+    for (uint32_t community : attrs.communities().values()) {
+      put(first ? "\"" : ",\"");
+      first = false;
+      put_u32(community >> 16);
+      put(':');
+      put_u32(community & 0xffff);
+      put('"');
+    }
+    put(']');
+  }
+  if (attrs.has_large_communities()) {
+    put_key("\"large_communities\":[");
+    auto values = attrs.large_communities().values();
+    for (size_t i = 0; i + 2 < values.size(); i += 3) {
+      put(i ? ",\"" : "\"");
+      put_u32(values[i]);
+      put(':');
+      put_u32(values[i + 1]);
+      put(':');
+      put_u32(values[i + 2]);
+      put('"');
+    }
+    put(']');
+  }
+  if (separator == '{') put('{');
+  put('}');
+}
+
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,482 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#include <parsebgp/io/shared_ring.hpp>
+
+#include "mirror.hpp"
+
+namespace parsebgp {
+namespace io {
+
+namespace {
+
+using mrt::table_dump_v2::PeerTable;
+using Header = SharedRecord::Header;
+using Type = bgp::PathAttributes::Type;
+using Flags = bgp::PathAttributes::Flags;
+
+// "PBSR" and a format version.
+constexpr uint64_t MAGIC = uint64_t(0x50425352) << 32 | 1;
+
+static_assert(sizeof(Header) % 8 == 0);
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Positions are shared across processes.");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Positions are shared across processes.");
+
+size_t page_size() {
+  return size_t(getpagesize());
+}
+
+/* Appends attributes in the encoding of SharedRecord::Attribute. */
+class AttributeEncoder {
+public:
+  explicit AttributeEncoder(std::vector<uint8_t>& out) : out_(out) { out_.clear(); }
+
+  void begin(Type::Value type, uint8_t flags) {
+    begin_ = out_.size();
+    out_.push_back(uint8_t(type));
+    out_.push_back(uint8_t(flags & ~Flags::EXTENDED));
+    out_.resize(out_.size() + 2);
+  }
+
+  void append(const void* data, size_t size) {
+    auto* p = static_cast<const uint8_t*>(data);
+    out_.insert(out_.end(), p, p + size);
+  }
+  void append_u32(uint32_t value) { append(&value, sizeof(value)); }
+
+  /* Set the payload size and pad; attributes too large for the size field are left out. */
+  void end() {
+    size_t size = out_.size() - begin_ - SharedRecord::Attribute::HEADER_SIZE;
+    if (size > std::numeric_limits<uint16_t>::max()) {
+      out_.resize(begin_);
+      return;
+    }
+    auto size16 = uint16_t(size);
+    std::memcpy(out_.data() + begin_ + 2, &size16, sizeof(size16));
+    out_.resize((out_.size() + 3) / 4 * 4);
+  }
+
+private:
+  std::vector<uint8_t>& out_;
+  size_t begin_ = 0;
+};
+
+} // namespace
+
+//==============================================================================
+// io::SharedRecord
+//==============================================================================
+
+auto SharedRecord::find(Type::Value type) const -> std::optional<Attribute> {
+  for (auto attribute : attributes()) {
+    if (attribute.type().value() == type) return attribute;
+  }
+  return {};
+}
+
+//==============================================================================
+// io::SharedRingPublisher
+//==============================================================================
+
+SharedRingPublisher::SharedRingPublisher(size_t capacity) {
+  if (capacity % page_size()) capacity += page_size() - capacity % page_size();
+  if (!capacity || capacity >= 2 * capacity) return;
+
+  fd_ = memfd_create("parsebgp_cpp_shared_ring", 0);
+  if (fd_ == -1) return;
+  void* control = MAP_FAILED;
+  utils::span<uint8_t> data;
+  if (ftruncate(fd_, off_t(page_size() + capacity)) == 0) {
+    control = mmap(nullptr, page_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (control != MAP_FAILED) {
+    data = map_mirrored(fd_, off_t(page_size()), capacity, PROT_READ | PROT_WRITE);
+  }
+  if (!data.data()) {
+    if (control != MAP_FAILED) {
+      int ret = munmap(control, page_size());
+      assert(ret == 0);
+    }
+    release();
+    return;
+  }
+
+  control_ = new (control) SharedRingControl{};
+  control_->capacity = capacity;
+  capacity_ = capacity;
+  data_ = data.data();
+  // Written last: subscribers check it before trusting the rest.
+  std::atomic_thread_fence(std::memory_order_release);
+  control_->magic = MAGIC;
+}
+
+SharedRingPublisher::~SharedRingPublisher() {
+  release();
+}
+
+SharedRingPublisher::SharedRingPublisher(SharedRingPublisher&& other) noexcept {
+  *this = std::move(other);
+}
+
+SharedRingPublisher& SharedRingPublisher::operator=(SharedRingPublisher&& other) noexcept {
+  if (this == &other) return *this;
+  release();
+  fd_ = std::exchange(other.fd_, -1);
+  capacity_ = std::exchange(other.capacity_, 0);
+  control_ = std::exchange(other.control_, nullptr);
+  data_ = std::exchange(other.data_, nullptr);
+  tail_ = other.tail_;
+  sequence_ = other.sequence_;
+  marked_ = other.marked_;
+  dropped_ = other.dropped_;
+  attrs_ = std::move(other.attrs_);
+  return *this;
+}
+
+void SharedRingPublisher::release() {
+  if (data_) {
+    int ret = munmap(data_, 2 * capacity_);
+    assert(ret == 0);
+    data_ = nullptr;
+  }
+  if (control_) {
+    int ret = munmap(control_, page_size());
+    assert(ret == 0);
+    control_ = nullptr;
+  }
+  if (fd_ != -1) {
+    int ret = ::close(fd_);
+    assert(ret == 0);
+    fd_ = -1;
+  }
+}
+
+size_t SharedRingPublisher::publish(const mrt::Message& msg, const PeerTable& peers) {
+  assert(!is_null());
+  size_t count = 0;
+  Header header{};
+  header.timestamp = msg.timestamp_sec();
+
+  if (msg.type().is_table_dump_v2()) {
+    auto table_dump_v2 = msg.to_table_dump_v2();
+    auto subtype = table_dump_v2.subtype();
+    if (!subtype.is_rib_ip()) return 0;
+    auto rib = table_dump_v2.to_rib();
+    header.kind = SharedRecord::RIB;
+    if (subtype.is_rib_ipv6_unicast() || subtype.is_rib_ipv6_multicast()) {
+      header.flags = SharedRecord::PREFIX_IPV6;
+    }
+    header.prefix_len = rib.prefix_len();
+    std::memcpy(header.prefix, rib.prefix().data(), sizeof(header.prefix));
+    for (auto entry : rib) {
+      auto* peer = peers.find(entry.peer_index());
+      if (!peer) continue;
+      header.flags &= ~SharedRecord::PEER_IPV6;
+      std::memset(header.peer_ip, 0, sizeof(header.peer_ip));
+      if (peer->is_ipv4()) {
+        uint32_t addr = peer->ipv4();
+        uint8_t bytes[4] = { uint8_t(addr >> 24), uint8_t(addr >> 16), uint8_t(addr >> 8),
+                             uint8_t(addr) };
+        std::memcpy(header.peer_ip, bytes, sizeof(bytes));
+      } else {
+        header.flags |= SharedRecord::PEER_IPV6;
+        std::memcpy(header.peer_ip, peers.ipv6(*peer).data(), sizeof(header.peer_ip));
+      }
+      header.peer_asn = peer->asn();
+      encode_attributes(entry.path_attributes());
+      count += write(header, true);
+    }
+  } else if (msg.type().is_bgp4mp()) {
+    auto bgp4mp = msg.to_bgp4mp();
+    if (!bgp4mp.subtype().is_message()) return 0;
+    auto bgp = bgp4mp.to_bgp();
+    if (!bgp.type().is_update()) return 0;
+    auto update = bgp.to_update();
+    auto attrs = update.path_attributes();
+
+    auto peer_ip = bgp4mp.peer_ip();
+    if (peer_ip.size() == 16) header.flags |= SharedRecord::PEER_IPV6;
+    std::memcpy(header.peer_ip, peer_ip.data(), peer_ip.size());
+    header.peer_asn = bgp4mp.peer_asn();
+
+    auto write_prefixes = [&](auto&& prefixes, bool with_attributes) {
+      for (auto prefix : prefixes) {
+        header.flags &= ~SharedRecord::PREFIX_IPV6;
+        if (prefix.afi_type().is_ipv6()) header.flags |= SharedRecord::PREFIX_IPV6;
+        header.prefix_len = prefix.len();
+        std::memcpy(header.prefix, prefix.addr().data(), sizeof(header.prefix));
+        count += write(header, with_attributes);
+      }
+    };
+    header.kind = SharedRecord::WITHDRAW;
+    write_prefixes(update.withdrawn(), false);
+    if (attrs.has_mp_unreach()) write_prefixes(attrs.mp_unreach(), false);
+    header.kind = SharedRecord::ANNOUNCE;
+    encode_attributes(attrs);
+    write_prefixes(update.announced(), true);
+    if (attrs.has_mp_reach()) write_prefixes(attrs.mp_reach(), true);
+  }
+
+  commit();
+  return count;
+}
+
+void SharedRingPublisher::close() {
+  assert(!is_null());
+  commit();
+  control_->closed.store(1, std::memory_order_release);
+}
+
+void SharedRingPublisher::encode_attributes(const bgp::PathAttributes& attrs) {
+  AttributeEncoder out(attrs_);
+  auto u32_attribute = [&](Type::Value type, uint8_t flags, uint32_t value) {
+    out.begin(type, flags);
+    out.append_u32(value);
+    out.end();
+  };
+
+  if (attrs.has_origin()) {
+    auto origin = attrs.origin();
+    u32_attribute(Type::ORIGIN, origin.flags().value(), origin.value());
+  }
+  if (attrs.has_as_path()) {
+    auto as_path = attrs.as_path();
+    out.begin(Type::AS_PATH, as_path.flags().value());
+    for (auto segment : as_path) {
+      auto asns = segment.asns();
+      out.append_u32(segment.type().value());
+      out.append_u32(uint32_t(asns.size()));
+      out.append(asns.data(), asns.size() * sizeof(uint32_t));
+    }
+    out.end();
+  }
+  if (attrs.has_next_hop()) {
+    auto next_hop = attrs.next_hop();
+    out.begin(Type::NEXT_HOP, next_hop.flags().value());
+    out.append(next_hop.value().data(), next_hop.value().size());
+    out.end();
+  }
+  if (attrs.has_med()) {
+    auto med = attrs.med();
+    u32_attribute(Type::MED, med.flags().value(), med.value());
+  }
+  if (attrs.has_local_pref()) {
+    auto local_pref = attrs.local_pref();
+    u32_attribute(Type::LOCAL_PREF, local_pref.flags().value(), local_pref.value());
+  }
+  if (attrs.has_atomic_aggregate()) {
+    // Well-known discretionary, so its flags are fixed.
+    out.begin(Type::ATOMIC_AGGREGATE, Flags::TRANSITIVE);
+    out.end();
+  }
+  if (attrs.has_aggregator()) {
+    auto aggregator = attrs.aggregator();
+    out.begin(Type::AGGREGATOR, aggregator.flags().value());
+    out.append_u32(aggregator.asn());
+    out.append(aggregator.addr().data(), aggregator.addr().size());
+    out.end();
+  }
+  if (attrs.has_communities()) {
+    auto communities = attrs.communities();
+    auto values = communities.values();
+    out.begin(Type::COMMUNITIES, communities.flags().value());
+    out.append(values.data(), values.size() * sizeof(uint32_t));
+    out.end();
+  }
+  if (attrs.has_originator_id()) {
+    auto originator_id = attrs.originator_id();
+    u32_attribute(Type::ORIGINATOR_ID, originator_id.flags().value(), originator_id.value());
+  }
+  if (attrs.has_cluster_list()) {
+    auto cluster_list = attrs.cluster_list();
+    auto values = cluster_list.values();
+    out.begin(Type::CLUSTER_LIST, cluster_list.flags().value());
+    out.append(values.data(), values.size() * sizeof(uint32_t));
+    out.end();
+  }
+  if (attrs.has_mp_reach()) {
+    auto mp_reach = attrs.mp_reach();
+    auto next_hop = mp_reach.raw_next_hop();
+    out.begin(Type::MP_REACH_NLRI, mp_reach.flags().value());
+    out.append(next_hop.data(), next_hop.size());
+    out.end();
+  }
+  if (attrs.has_large_communities()) {
+    auto large_communities = attrs.large_communities();
+    auto values = large_communities.values();
+    out.begin(Type::LARGE_COMMUNITIES, large_communities.flags().value());
+    out.append(values.data(), values.size() * sizeof(uint32_t));
+    out.end();
+  }
+}
+
+bool SharedRingPublisher::write(Header header, bool with_attributes) {
+  size_t attrs_size = with_attributes ? attrs_.size() : 0;
+  size_t size = (sizeof(Header) + attrs_size + 7) / 8 * 8;
+  if (size > capacity_) {
+    dropped_++;
+    return false;
+  }
+  header.size = uint32_t(size);
+  header.sequence = sequence_++;
+
+  // Seqlock style: subscribers that copied any of the bytes written below will see the new
+  // reserved position, and know their copy of the oldest capacity bytes may be torn.
+  uint64_t end = tail_ + size;
+  control_->reserved.store(end, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint64_t mark = tail_ / (capacity_ / SharedRingControl::MARKS);
+  if (mark != marked_) {
+    control_->marks[mark % SharedRingControl::MARKS].store(tail_, std::memory_order_relaxed);
+    marked_ = mark;
+  }
+
+  uint8_t* out = data_ + tail_ % capacity_;
+  std::memcpy(out, &header, sizeof(Header));
+  std::memcpy(out + sizeof(Header), attrs_.data(), attrs_size);
+  std::memset(out + sizeof(Header) + attrs_size, 0, size - sizeof(Header) - attrs_size);
+  tail_ = end;
+  return true;
+}
+
+void SharedRingPublisher::commit() {
+  control_->tail.store(tail_, std::memory_order_release);
+}
+
+//==============================================================================
+// io::SharedRingSubscriber
+//==============================================================================
+
+SharedRingSubscriber::SharedRingSubscriber(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < page_size()) return;
+
+  void* control = mmap(nullptr, page_size(), PROT_READ, MAP_SHARED, fd, 0);
+  if (control == MAP_FAILED) return;
+  control_ = static_cast<const SharedRingControl*>(control);
+  uint64_t magic = control_->magic;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t capacity = control_->capacity;
+  utils::span<uint8_t> data;
+  if (magic == MAGIC && capacity && capacity % page_size() == 0 &&
+      size_t(st.st_size) - page_size() >= capacity) {
+    data = map_mirrored(fd, off_t(page_size()), size_t(capacity), PROT_READ);
+  }
+  if (!data.data()) {
+    release();
+    return;
+  }
+  capacity_ = size_t(capacity);
+  data_ = data.data();
+  position_ = control_->tail.load(std::memory_order_acquire);
+}
+
+SharedRingSubscriber::~SharedRingSubscriber() {
+  release();
+}
+
+SharedRingSubscriber::SharedRingSubscriber(SharedRingSubscriber&& other) noexcept {
+  *this = std::move(other);
+}
+
+SharedRingSubscriber& SharedRingSubscriber::operator=(SharedRingSubscriber&& other) noexcept {
+  if (this == &other) return *this;
+  release();
+  capacity_ = std::exchange(other.capacity_, 0);
+  control_ = std::exchange(other.control_, nullptr);
+  data_ = std::exchange(other.data_, nullptr);
+  position_ = other.position_;
+  started_ = other.started_;
+  sequence_ = other.sequence_;
+  lost_ = other.lost_;
+  batch_ = std::move(other.batch_);
+  return *this;
+}
+
+void SharedRingSubscriber::release() {
+  if (data_) {
+    int ret = munmap(const_cast<uint8_t*>(data_), 2 * capacity_);
+    assert(ret == 0);
+    data_ = nullptr;
+  }
+  if (control_) {
+    int ret = munmap(const_cast<SharedRingControl*>(control_), page_size());
+    assert(ret == 0);
+    control_ = nullptr;
+  }
+}
+
+bool SharedRingSubscriber::finished() const {
+  assert(!is_null());
+  // closed is set after the last tail, so the tail read after it is final.
+  if (!control_->closed.load(std::memory_order_acquire)) return false;
+  return position_ == control_->tail.load(std::memory_order_acquire);
+}
+
+size_t SharedRingSubscriber::copy(size_t max_bytes) {
+  assert(!is_null());
+  uint64_t tail = control_->tail.load(std::memory_order_acquire);
+  if (tail - position_ > capacity_) skip(tail);
+  size_t available = size_t(tail - position_);
+  size_t size = std::min(available, max_bytes);
+
+  while (size) {
+    batch_.resize((size + 7) / 8);
+    auto* batch = reinterpret_cast<uint8_t*>(batch_.data());
+    std::memcpy(batch, data_ + position_ % capacity_, size);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (control_->reserved.load(std::memory_order_relaxed) > position_ + capacity_) {
+      // The publisher lapped us while copying.
+      skip(control_->tail.load(std::memory_order_acquire));
+      return 0;
+    }
+
+    size_t whole = 0;
+    while (sizeof(Header) <= size - whole) {
+      size_t record_size = SharedRecord(batch + whole).size();
+      assert(record_size >= sizeof(Header) && record_size % 8 == 0);
+      if (record_size > size - whole) break;
+      whole += record_size;
+    }
+    if (!whole) {
+      // The first record is larger than max_bytes, or its header was cut.
+      size = size < sizeof(Header) ? sizeof(Header) : SharedRecord(batch).size();
+      assert(size <= available);
+      continue;
+    }
+
+    for (size_t offset = 0; offset < whole;) {
+      SharedRecord record(batch + offset);
+      if (started_ && record.sequence() != sequence_) lost_ += record.sequence() - sequence_;
+      started_ = true;
+      sequence_ = record.sequence() + 1;
+      offset += record.size();
+    }
+    position_ += whole;
+    return whole;
+  }
+  return 0;
+}
+
+void SharedRingSubscriber::skip(uint64_t tail) {
+  // Marks in the oldest capacity / MARKS bytes would soon be overwritten again, and those older
+  // than the data are from previous laps.
+  uint64_t oldest = tail - capacity_ + capacity_ / SharedRingControl::MARKS;
+  uint64_t resume = tail;
+  for (auto& mark : control_->marks) {
+    uint64_t position = mark.load(std::memory_order_relaxed);
+    if (position >= oldest && position < resume) resume = position;
+  }
+  position_ = resume;
+}
+
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,66 @@
+#include <array>
+#include <charconv>
+#include <cstring>
+
+#include <parsebgp/utils/ip.hpp>
+
+#include "text.hpp"
+
+namespace parsebgp {
+namespace io {
+namespace text {
+
+namespace {
+
+struct Suffix {
+  char text[4];
+  uint8_t size;
+};
+
+/* "/len" of each prefix length, so the length of a prefix is one table copy. */
+constexpr std::array<Suffix, 129> make_suffixes() {
+  std::array<Suffix, 129> suffixes{};
+  for (unsigned i = 0; i <= 128; i++) {
+    auto& suffix = suffixes[i];
+    suffix.text[suffix.size++] = '/';
+    if (i >= 100) suffix.text[suffix.size++] = char('0' + i / 100);
+    if (i >= 10) suffix.text[suffix.size++] = char('0' + i / 10 % 10);
+    suffix.text[suffix.size++] = char('0' + i % 10);
+  }
+  return suffixes;
+}
+
+constexpr std::array<Suffix, 129> SUFFIXES = make_suffixes();
+
+} // namespace
+
+char* write_ipv4(char* out, const uint8_t* addr) {
+  return utils::Ipv4Addr::from_bytes(addr).format(out);
+}
+
+char* write_ipv6(char* out, const uint8_t* addr) {
+  return utils::Ipv6Addr::from_bytes(addr).format(out);
+}
+
+char* write_ip(char* out, utils::ip_view addr) {
+  return addr.size() == 4 ? write_ipv4(out, addr.data()) : write_ipv6(out, addr.data());
+}
+
+char* write_prefix(char* out, bool ipv6, const uint8_t* addr, uint8_t len) {
+  out = ipv6 ? write_ipv6(out, addr) : write_ipv4(out, addr);
+  if (len > 128) {
+    *out++ = '/';
+    return std::to_chars(out, out + 3, len).ptr;
+  }
+  auto& suffix = SUFFIXES[len];
+  std::memcpy(out, suffix.text, 4);
+  return out + suffix.size;
+}
+
+char* write_u32(char* out, uint32_t value) {
+  return std::to_chars(out, out + MAX_U32_SIZE, value).ptr;
+}
+
+} // namespace text
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <parsebgp/utils.hpp>
+
+namespace parsebgp {
+namespace io {
+namespace text {
+
+/*
+ * Locale independent text of addresses and numbers, shared by the formatters in io/. Each writes to
+ * out, which must have room for the MAX_*_SIZE bytes below, and returns the end of the text.
+ */
+
+// "255.255.255.255", or "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff".
+constexpr std::size_t MAX_IP_SIZE = 39;
+// An IPv6 address and "/128".
+constexpr std::size_t MAX_PREFIX_SIZE = MAX_IP_SIZE + 4;
+// "4294967295".
+constexpr std::size_t MAX_U32_SIZE = 10;
+
+/* Addresses in network byte order, written by utils::Ipv4Addr::format() and Ipv6Addr::format(). */
+char* write_ipv4(char* out, const uint8_t* addr);
+char* write_ipv6(char* out, const uint8_t* addr);
+/* IPv4 or IPv6 by the size of addr. */
+char* write_ip(char* out, utils::ip_view addr);
+char* write_prefix(char* out, bool ipv6, const uint8_t* addr, uint8_t len);
+char* write_u32(char* out, uint32_t value);
+
+} // namespace text
+} // namespace io
+} // namespace parsebgp
@@ -0,0 +1,162 @@
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include <parsebgp/io/writer.hpp>
+
+namespace parsebgp {
+namespace io {
+
+namespace {
+
+constexpr size_t MRT_HEADER_SIZE = 12;
+constexpr uint16_t MRT_TABLE_DUMP_V2 = 13;
+// Peer index, originated time and attribute length.
+constexpr size_t RIB_ENTRY_HEADER_SIZE = 8;
+
+uint16_t load16(const uint8_t* p) {
+  return uint16_t(p[0] << 8 | p[1]);
+}
+
+uint32_t load32(const uint8_t* p) {
+  return uint32_t(load16(p)) << 16 | load16(p + 2);
+}
+
+void store16(uint8_t* p, uint16_t value) {
+  p[0] = uint8_t(value >> 8);
+  p[1] = uint8_t(value);
+}
+
+void store32(uint8_t* p, uint32_t value) {
+  store16(p, uint16_t(value >> 16));
+  store16(p + 2, uint16_t(value));
+}
+
+} // namespace
+
+//==============================================================================
+// io::MrtWriter
+//==============================================================================
+
+MrtWriter::MrtWriter(utils::string_view path, size_t buffer_size)
+  : BaseView(std::fopen(path.data(), "wb"))
+  , buffer_size_(buffer_size)
+  , status_(cptr() ? Status::OK : Status::ERRNO) {
+  // Writes are already batched into buffer_.
+  if (cptr()) std::setvbuf(cptr(), nullptr, _IONBF, 0);
+  buffer_.reserve(buffer_size_);
+}
+
+MrtWriter::~MrtWriter() {
+  if (cptr()) {
+    flush();
+    std::fclose(cptr());
+  }
+}
+
+MrtWriter& MrtWriter::operator=(MrtWriter&& other) noexcept {
+  if (this == &other) return *this;
+  if (cptr()) {
+    flush();
+    std::fclose(cptr());
+  }
+  BaseView::operator=(std::move(other));
+  buffer_ = std::move(other.buffer_);
+  other.buffer_.clear();
+  buffer_size_ = other.buffer_size_;
+  kept_ = std::move(other.kept_);
+  bytes_written_ = other.bytes_written_;
+  status_ = other.status_;
+  return *this;
+}
+
+bool MrtWriter::write(utils::bytes_view record) {
+  if (!good()) return false;
+  if (buffer_.size() + record.size() > buffer_size_) {
+    if (!flush()) return false;
+    if (record.size() >= buffer_size_) return write_file(record.data(), record.size());
+  }
+  buffer_.insert(buffer_.end(), record.begin(), record.end());
+  return true;
+}
+
+bool MrtWriter::write_rib(utils::bytes_view record, utils::span<const uint16_t> entries) {
+  if (!good()) return false;
+  if (record.size() < MRT_HEADER_SIZE) return false;
+  const uint8_t* in = record.data();
+  auto subtype = mrt::table_dump_v2::Message::Subtype::Value(load16(in + 6));
+  if (load16(in + 4) != MRT_TABLE_DUMP_V2 ||
+      !mrt::table_dump_v2::Message::Subtype(subtype).is_rib_ip() ||
+      load32(in + 8) != record.size() - MRT_HEADER_SIZE) {
+    return false;
+  }
+
+  // Sequence number, prefix length and prefix, up to the entry count.
+  size_t pos = MRT_HEADER_SIZE + 4;
+  if (pos + 1 > record.size()) return false;
+  pos += 1 + (in[pos] + 7) / 8;
+  if (pos + 2 > record.size()) return false;
+  uint16_t count = load16(in + pos);
+  size_t count_at = pos;
+  pos += 2;
+
+  if (!reserve(record.size())) return false;
+  size_t start = buffer_.size();
+  buffer_.insert(buffer_.end(), in, in + pos);
+
+  auto next = entries.begin();
+  for (uint16_t i = 0; i < count && next != entries.end(); i++) {
+    if (pos + RIB_ENTRY_HEADER_SIZE > record.size()) break;
+    size_t size = RIB_ENTRY_HEADER_SIZE + load16(in + pos + 6);
+    if (pos + size > record.size()) break;
+    if (*next == i) {
+      buffer_.insert(buffer_.end(), in + pos, in + pos + size);
+      ++next;
+    }
+    pos += size;
+  }
+  if (next != entries.end()) {
+    // Malformed entries, or indices out of range or not ascending.
+    buffer_.resize(start);
+    return false;
+  }
+
+  uint8_t* out = buffer_.data() + start;
+  store32(out + 8, uint32_t(buffer_.size() - start - MRT_HEADER_SIZE));
+  store16(out + count_at, uint16_t(entries.size()));
+  return true;
+}
+
+bool MrtWriter::flush() {
+  if (!good()) return false;
+  bool ok = write_file(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  return ok;
+}
+
+bool MrtWriter::good() const {
+  return status_.is_ok();
+}
+
+auto MrtWriter::status() const -> Status {
+  return status_;
+}
+
+bool MrtWriter::reserve(size_t size) {
+  if (buffer_.size() + size > buffer_size_ && !flush()) return false;
+  // A record larger than the whole buffer is assembled in place anyway.
+  buffer_.reserve(size);
+  return true;
+}
+
+bool MrtWriter::write_file(const uint8_t* data, size_t size) {
+  if (size && std::fwrite(data, 1, size, cptr()) != size) {
+    status_ = Status::ERRNO;
+    return false;
+  }
+  bytes_written_ += size;
+  return true;
+}
+
+} // namespace io
+} // namespace parsebgp
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 
 #include <parsebgp/mrt.hpp>
@@ -26,11 +27,24 @@ uint32_t Message::length() const {
   return cptr()->len;
 }
 
+uint32_t Message::timestamp_sec() const {
+  return cptr()->timestamp_sec;
+}
+
+uint32_t Message::timestamp_usec() const {
+  return cptr()->timestamp_usec;
+}
+
 table_dump_v2::Message Message::to_table_dump_v2() const {
   assert(type().is_table_dump_v2());
   return table_dump_v2::Message(cptr());
 }
 
+bgp4mp::Message Message::to_bgp4mp() const {
+  assert(type().is_bgp4mp());
+  return bgp4mp::Message(cptr());
+}
+
 //==============================================================================
 // mrt::Message::Type
 //==============================================================================
@@ -92,6 +106,11 @@ utils::ipv6_view PeerEntry::ipv6() const {
   return cptr()->ip;
 }
 
+utils::IpAddr PeerEntry::ip_addr() const {
+  assert(ip_afi().is_valid());
+  return utils::IpAddr::from_bytes(ip());
+}
+
 uint32_t PeerEntry::asn() const {
   return cptr()->asn;
 }
@@ -128,6 +147,43 @@ std::ptrdiff_t PeerIndex::range_difference(const ElementCPtr lhs, const ElementC
   return lhs - rhs;
 }
 
+//==============================================================================
+// mrt::table_dump_v2::PeerTable
+//==============================================================================
+
+static uint32_t load_be32(const uint8_t* p) {
+  return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+}
+
+void PeerTable::load(const PeerIndex& peer_index) {
+  clear();
+  peers_.reserve(peer_index.size());
+  for (auto entry : peer_index) {
+    Peer peer;
+    peer.asn_ = entry.asn();
+    peer.bgp_id_ = load_be32(entry.bgp_id().data());
+    peer.afi_ = entry.ip_afi();
+    if (peer.is_ipv4()) {
+      peer.addr_ = load_be32(entry.ipv4().data());
+    } else {
+      peer.addr_ = uint32_t(ipv6_.size());
+      ipv6_.emplace_back();
+      std::copy_n(entry.ipv6().data(), 16, ipv6_.back().data());
+    }
+    peers_.push_back(peer);
+  }
+  collector_bgp_id_ = load_be32(peer_index.collector_bgp_id().data());
+  auto name = peer_index.view_name();
+  view_name_.assign(name.data(), name.size());
+}
+
+void PeerTable::clear() {
+  peers_.clear();
+  ipv6_.clear();
+  collector_bgp_id_ = 0;
+  view_name_.clear();
+}
+
 //==============================================================================
 // mrt::table_dump_v2::RibEntry
 //==============================================================================
@@ -160,6 +216,10 @@ utils::ipv6_view Rib::prefix() const {
   return cptr()->prefix;
 }
 
+utils::IpPrefix Rib::ip_prefix(AfiType afi) const {
+  return utils::IpPrefix::from_bytes(afi.is_ipv6(), cptr()->prefix, cptr()->prefix_len);
+}
+
 auto Rib::range_data() const -> ElementCPtr {
   return cptr()->entries;
 }
@@ -180,6 +240,14 @@ std::ptrdiff_t Rib::range_difference(const ElementCPtr lhs, const ElementCPtr rh
   return lhs - rhs;
 }
 
+void Rib::range_prefetch(const ElementCPtr ptr) {
+  PARSEBGP_CPP_PREFETCH(ptr);
+  PARSEBGP_CPP_PREFETCH(ptr->path_attrs.attrs_used);
+  PARSEBGP_CPP_PREFETCH(&ptr->path_attrs.attrs[bgp::PathAttributes::Type::AS_PATH]);
+  PARSEBGP_CPP_PREFETCH(&ptr->path_attrs.attrs[bgp::PathAttributes::Type::COMMUNITIES]);
+  PARSEBGP_CPP_PREFETCH(&ptr->path_attrs.attrs[bgp::PathAttributes::Type::NEXT_HOP]);
+}
+
 //==============================================================================
 // mrt::table_dump_v2::Message
 //==============================================================================
@@ -227,5 +295,103 @@ static_assert(Message::Subtype::RIB_IPV6_MULTICAST ==
 static_assert(Message::Subtype::RIB_GENERIC == int(PARSEBGP_MRT_TABLE_DUMP_V2_RIB_GENERIC));
 
 } // namespace table_dump_v2
+
+namespace bgp4mp {
+
+//==============================================================================
+// mrt::bgp4mp::StateChange
+//==============================================================================
+
+auto StateChange::old_state() const -> State {
+  return State::Value(cptr()->old_state);
+}
+
+auto StateChange::new_state() const -> State {
+  return State::Value(cptr()->new_state);
+}
+
+//==============================================================================
+// mrt::bgp4mp::StateChange::State
+//==============================================================================
+
+static_assert(StateChange::State::IDLE == int(PARSEBGP_MRT_BGP4MP_STATE_IDLE));
+static_assert(StateChange::State::CONNECT == int(PARSEBGP_MRT_BGP4MP_STATE_CONNECT));
+static_assert(StateChange::State::ACTIVE == int(PARSEBGP_MRT_BGP4MP_STATE_ACTIVE));
+static_assert(StateChange::State::OPENSENT == int(PARSEBGP_MRT_BGP4MP_STATE_OPENSENT));
+static_assert(StateChange::State::OPENCONFIRM == int(PARSEBGP_MRT_BGP4MP_STATE_OPENCONFIRM));
+static_assert(StateChange::State::ESTABLISHED == int(PARSEBGP_MRT_BGP4MP_STATE_ESTABLISHED));
+
+//==============================================================================
+// mrt::bgp4mp::Message
+//==============================================================================
+
+mrt::Message::Type Message::type() const {
+  return mrt::Message::Type::Value(cptr()->type);
+}
+
+auto Message::subtype() const -> Subtype {
+  return Subtype::Value(cptr()->subtype);
+}
+
+uint32_t Message::length() const {
+  return cptr()->len;
+}
+
+uint32_t Message::timestamp_sec() const {
+  return cptr()->timestamp_sec;
+}
+
+uint32_t Message::timestamp_usec() const {
+  return cptr()->timestamp_usec;
+}
+
+uint32_t Message::peer_asn() const {
+  return cptr()->types.bgp4mp->peer_asn;
+}
+
+uint32_t Message::local_asn() const {
+  return cptr()->types.bgp4mp->local_asn;
+}
+
+uint16_t Message::interface_index() const {
+  return cptr()->types.bgp4mp->interface_index;
+}
+
+AfiType Message::afi() const {
+  return AfiType::Value(cptr()->types.bgp4mp->afi);
+}
+
+utils::ip_view Message::peer_ip() const {
+  assert(afi().is_valid());
+  return { cptr()->types.bgp4mp->peer_ip, size_t(afi().is_ipv4() ? 4 : 16) };
+}
+
+utils::ip_view Message::local_ip() const {
+  assert(afi().is_valid());
+  return { cptr()->types.bgp4mp->local_ip, size_t(afi().is_ipv4() ? 4 : 16) };
+}
+
+StateChange Message::to_state_change() const {
+  assert(subtype().is_state_change());
+  return StateChange(&cptr()->types.bgp4mp->data.state_change);
+}
+
+bgp::Message Message::to_bgp() const {
+  assert(subtype().is_message());
+  return bgp::Message(cptr()->types.bgp4mp->data.bgp_msg);
+}
+
+//==============================================================================
+// mrt::bgp4mp::Message::Subtype
+//==============================================================================
+
+static_assert(Message::Subtype::STATE_CHANGE == int(PARSEBGP_MRT_BGP4MP_STATE_CHANGE));
+static_assert(Message::Subtype::MESSAGE == int(PARSEBGP_MRT_BGP4MP_MESSAGE));
+static_assert(Message::Subtype::MESSAGE_AS4 == int(PARSEBGP_MRT_BGP4MP_MESSAGE_AS4));
+static_assert(Message::Subtype::STATE_CHANGE_AS4 == int(PARSEBGP_MRT_BGP4MP_STATE_CHANGE_AS4));
+static_assert(Message::Subtype::MESSAGE_LOCAL == int(PARSEBGP_MRT_BGP4MP_MESSAGE_LOCAL));
+static_assert(Message::Subtype::MESSAGE_AS4_LOCAL == int(PARSEBGP_MRT_BGP4MP_MESSAGE_AS4_LOCAL));
+
+} // namespace bgp4mp
 } // namespace mrt
 } // namespace parsebgp
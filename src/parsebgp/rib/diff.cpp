@@ -0,0 +1,35 @@
+#include <parsebgp/rib/diff.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+//==============================================================================
+// rib::RibDiff
+//==============================================================================
+
+std::optional<utils::IpPrefix> RibDiff::load(Side& side, const mrt::table_dump_v2::Message& msg) {
+  auto subtype = msg.subtype();
+  if (subtype.is_peer_index_table()) {
+    side.peers.clear();
+    for (auto entry : msg.to_peer_index()) {
+      side.peers.push_back({ entry.ip_addr(), entry.asn() });
+    }
+    return std::nullopt;
+  }
+  if (!subtype.is_rib_ip_unicast()) return std::nullopt;
+
+  bgp::AfiType afi = subtype.is_rib_ipv4_unicast() ? bgp::AfiType::IPV4 : bgp::AfiType::IPV6;
+  // Bits past the prefix length are not guaranteed to be zero; IpPrefix clears them.
+  return msg.to_rib().ip_prefix(afi);
+}
+
+void RibDiff::add_entries(Side& side, mrt::table_dump_v2::Rib rib) {
+  for (auto entry : rib) {
+    // Entries referring to peers missing from the index cannot be matched across dumps.
+    if (entry.peer_index() >= side.peers.size()) continue;
+    side.entries.push_back({ side.peers[entry.peer_index()], entry });
+  }
+}
+
+} // namespace rib
+} // namespace parsebgp
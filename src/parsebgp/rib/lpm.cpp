@@ -0,0 +1,117 @@
+#include <cassert>
+
+#include <parsebgp/rib/lpm.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+Ipv4Key ipv4_key(utils::bytes_view addr) {
+  assert(addr.size() >= 4);
+  return Ipv4Key(addr[0]) << 24 | Ipv4Key(addr[1]) << 16 | Ipv4Key(addr[2]) << 8 | addr[3];
+}
+
+Ipv6Key ipv6_key(utils::bytes_view addr) {
+  assert(addr.size() >= 16);
+  Ipv6Key key = 0;
+  for (std::size_t i = 0; i < 16; i++) key = key << 8 | addr[i];
+  return key;
+}
+
+void ipv4_key_to_bytes(Ipv4Key key, uint8_t* out) {
+  for (int i = 3; i >= 0; i--, key >>= 8) out[i] = uint8_t(key);
+}
+
+void ipv6_key_to_bytes(Ipv6Key key, uint8_t* out) {
+  for (int i = 15; i >= 0; i--, key >>= 8) out[i] = uint8_t(key);
+}
+
+//==============================================================================
+// rib::Dir24Table
+//==============================================================================
+
+template<typename Pred>
+void Dir24Table::assign(Ipv4Key addr, uint8_t len, uint32_t entry, Pred should_replace) {
+  assert(len <= 32);
+  addr &= PrefixTrie<Ipv4Key>::mask(len);
+  if (len <= 24) {
+    uint32_t first = addr >> 8;
+    uint32_t last = first + (1U << (24 - len));
+    for (uint32_t i = first; i < last; i++) {
+      uint32_t& e = tbl24_[i];
+      if (!(e & GROUP)) {
+        if (should_replace(e)) e = entry;
+        continue;
+      }
+      auto group = tbl8_.begin() + (e & PAYLOAD) * 256;
+      for (auto it = group; it != group + 256; it++) {
+        if (should_replace(*it)) *it = entry;
+      }
+    }
+    return;
+  }
+
+  uint32_t& e = tbl24_[addr >> 8];
+  if (!(e & GROUP)) {
+    // Split the /24 into a group inheriting the less specific mapping.
+    uint32_t group = uint32_t(tbl8_.size() / 256);
+    assert(group <= PAYLOAD);
+    tbl8_.resize(tbl8_.size() + 256, e);
+    e = GROUP | group;
+  }
+  auto group = tbl8_.begin() + (e & PAYLOAD) * 256;
+  uint32_t first = addr & 0xff;
+  uint32_t last = first + (1U << (32 - len));
+  for (auto it = group + first; it != group + last; it++) {
+    if (should_replace(*it)) *it = entry;
+  }
+}
+
+void Dir24Table::insert(Ipv4Key addr, uint8_t len, Value value) {
+  assert(value <= MAX_VALUE);
+  if (tbl24_.empty()) tbl24_.assign(1U << 24, 0);
+  assign(addr, len, make_entry(value, len), [len](uint32_t e) {
+    return !is_set(e) || depth(e) <= len;
+  });
+}
+
+void Dir24Table::erase(Ipv4Key addr, uint8_t len, Value covering_value, uint8_t covering_len) {
+  assert(covering_value == NONE || covering_len < len);
+  if (tbl24_.empty()) return;
+  assign(addr, len, make_entry(covering_value, covering_len), [len](uint32_t e) {
+    return is_set(e) && depth(e) == len;
+  });
+}
+
+void Dir24Table::clear() {
+  std::fill(tbl24_.begin(), tbl24_.end(), 0);
+  tbl8_.clear();
+}
+
+//==============================================================================
+// rib::Ipv4PrefixTable
+//==============================================================================
+
+auto Ipv4PrefixTable::insert(Key key, uint8_t len, Value value) -> Value {
+  Value old = trie_.insert(key, len, value);
+  if (old != value) dir_.insert(key, len, value);
+  return old;
+}
+
+auto Ipv4PrefixTable::erase(Key key, uint8_t len) -> Value {
+  Value old = trie_.erase(key, len);
+  if (old == NONE) return old;
+
+  Value covering_value = NONE;
+  uint8_t covering_len = 0;
+  if (len > 0) {
+    trie_.covering(key, len - 1, [&](Key, uint8_t l, Value v) {
+      covering_value = v;
+      covering_len = l;
+    });
+  }
+  dir_.erase(key, len, covering_value, covering_len);
+  return old;
+}
+
+} // namespace rib
+} // namespace parsebgp
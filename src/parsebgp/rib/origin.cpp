@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cassert>
+
+#include <parsebgp/rib/origin.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+//==============================================================================
+// rib::OriginTable
+//==============================================================================
+
+bool OriginTable::load(const mrt::table_dump_v2::Message& msg) {
+  auto subtype = msg.subtype();
+  if (subtype.is_rib_ipv4_unicast()) {
+    insert(bgp::AfiType::IPV4, msg.to_rib());
+  } else if (subtype.is_rib_ipv6_unicast()) {
+    insert(bgp::AfiType::IPV6, msg.to_rib());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void OriginTable::insert(bgp::AfiType afi, mrt::table_dump_v2::Rib rib) {
+  assert(afi.is_valid());
+  scratch_.clear();
+  for (auto entry : rib) {
+    entries_++;
+    auto attrs = entry.path_attributes();
+    if (!attrs.has_as_path()) {
+      no_origin_++;
+      continue;
+    }
+
+    // Confederation segments are local to the neighboring AS and are not the origin.
+    auto path = attrs.as_path();
+    std::size_t i = path.size();
+    while (i && (path[i - 1].type().is_confed_seq() || path[i - 1].type().is_confed_set())) i--;
+    if (!i || path[i - 1].asns().empty()) {
+      no_origin_++;
+      continue;
+    }
+    auto segment = path[i - 1];
+    auto asns = segment.asns();
+    if (segment.type().is_as_seq()) {
+      scratch_.push_back(Origin(asns[asns.size() - 1], false, 1));
+    } else if (segment.type().is_as_set()) {
+      set_scratch_.assign(asns.begin(), asns.end());
+      std::sort(set_scratch_.begin(), set_scratch_.end());
+      set_scratch_.erase(std::unique(set_scratch_.begin(), set_scratch_.end()), set_scratch_.end());
+      if (set_scratch_.size() == 1) {
+        scratch_.push_back(Origin(set_scratch_[0], false, 1));
+      } else {
+        scratch_.push_back(Origin(intern_set(set_scratch_), true, 1));
+      }
+    } else {
+      no_origin_++;
+    }
+  }
+  if (!scratch_.empty()) append(rib.ip_prefix(afi));
+}
+
+void OriginTable::combine_scratch() {
+  std::sort(scratch_.begin(), scratch_.end(), [](const Origin& lhs, const Origin& rhs) {
+    return lhs.key() < rhs.key();
+  });
+  std::size_t size = 0;
+  for (auto& origin : scratch_) {
+    if (size && scratch_[size - 1].key() == origin.key()) {
+      scratch_[size - 1].add_peers(origin.peers());
+    } else {
+      scratch_[size++] = origin;
+    }
+  }
+  scratch_.erase(scratch_.begin() + std::ptrdiff_t(size), scratch_.end());
+}
+
+void OriginTable::append(const utils::IpPrefix& prefix) {
+  if (!prefixes_.empty() && prefixes_.back() == prefix) {
+    // A prefix split across records: fold the origins loaded so far into the new ones.
+    scratch_.insert(scratch_.end(), origins_.begin() + offsets_[size() - 1], origins_.end());
+    origins_.erase(origins_.begin() + offsets_[size() - 1], origins_.end());
+    prefixes_.pop_back();
+    offsets_.pop_back();
+  } else if (!prefixes_.empty() && prefix < prefixes_.back()) {
+    sorted_ = false;
+  }
+  combine_scratch();
+  prefixes_.push_back(prefix);
+  origins_.insert(origins_.end(), scratch_.begin(), scratch_.end());
+  offsets_.push_back(uint32_t(origins_.size()));
+}
+
+uint32_t OriginTable::intern_set(const std::vector<uint32_t>& asns) {
+  auto it = set_ids_.find(asns);
+  if (it != set_ids_.end()) return it->second;
+  auto id = uint32_t(set_offsets_.size() - 1);
+  set_asns_.insert(set_asns_.end(), asns.begin(), asns.end());
+  set_offsets_.push_back(uint32_t(set_asns_.size()));
+  set_ids_.emplace(asns, id);
+  return id;
+}
+
+void OriginTable::finish() {
+  if (sorted_) return;
+  std::vector<uint32_t> order(size());
+  for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+    return prefixes_[lhs] < prefixes_[rhs];
+  });
+
+  auto prefixes = std::move(prefixes_);
+  auto offsets = std::move(offsets_);
+  auto origins = std::move(origins_);
+  prefixes_.clear();
+  offsets_.assign(1, 0);
+  origins_.clear();
+  sorted_ = true;
+  for (auto i : order) {
+    scratch_.assign(origins.begin() + offsets[i], origins.begin() + offsets[i + 1]);
+    append(prefixes[i]);
+  }
+}
+
+void OriginTable::merge(OriginTable other) {
+  finish();
+  other.finish();
+
+  // AS_SET ids of other, in this table.
+  std::vector<uint32_t> set_ids(other.set_offsets_.size() - 1);
+  for (uint32_t id = 0; id < set_ids.size(); id++) {
+    set_scratch_.assign(other.set_asns_.begin() + other.set_offsets_[id],
+                        other.set_asns_.begin() + other.set_offsets_[id + 1]);
+    set_ids[id] = intern_set(set_scratch_);
+  }
+  for (auto& origin : other.origins_) {
+    if (origin.is_as_set()) origin.value_ = set_ids[origin.value_];
+  }
+
+  auto prefixes = std::move(prefixes_);
+  auto offsets = std::move(offsets_);
+  auto origins = std::move(origins_);
+  prefixes_.clear();
+  prefixes_.reserve(prefixes.size() + other.size());
+  offsets_.assign(1, 0);
+  offsets_.reserve(prefixes.size() + other.size() + 1);
+  origins_.clear();
+  origins_.reserve(origins.size() + other.origins_.size());
+
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < prefixes.size() || j < other.size()) {
+    scratch_.clear();
+    bool take_this =
+      i < prefixes.size() && (j == other.size() || !(other.prefixes_[j] < prefixes[i]));
+    bool take_other =
+      j < other.size() && (i == prefixes.size() || !(prefixes[i] < other.prefixes_[j]));
+    auto& prefix = take_this ? prefixes[i] : other.prefixes_[j];
+    if (take_this) {
+      scratch_.insert(scratch_.end(),
+                      origins.begin() + offsets[i],
+                      origins.begin() + offsets[i + 1]);
+      i++;
+    }
+    if (take_other) {
+      scratch_.insert(scratch_.end(),
+                      other.origins_.begin() + other.offsets_[j],
+                      other.origins_.begin() + other.offsets_[j + 1]);
+      j++;
+    }
+    append(prefix);
+  }
+
+  entries_ += other.entries_;
+  no_origin_ += other.no_origin_;
+}
+
+std::optional<OriginTable::Origins> OriginTable::find(const utils::IpPrefix& prefix) const {
+  assert(sorted_);
+  auto it = std::lower_bound(prefixes_.begin(), prefixes_.end(), prefix);
+  if (it == prefixes_.end() || *it != prefix) return std::nullopt;
+  return (*this)[std::size_t(it - prefixes_.begin())].origins;
+}
+
+std::size_t OriginTable::moas_size() const {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < size(); i++) count += offsets_[i + 1] - offsets_[i] > 1;
+  return count;
+}
+
+std::size_t OriginTable::memory_usage() const {
+  std::size_t sets = 0;
+  for (auto& kv : set_ids_) sets += kv.first.capacity() * sizeof(uint32_t) + 64;
+  return prefixes_.capacity() * sizeof(utils::IpPrefix) + offsets_.capacity() * sizeof(uint32_t) +
+         origins_.capacity() * sizeof(Origin) + set_asns_.capacity() * sizeof(uint32_t) +
+         set_offsets_.capacity() * sizeof(uint32_t) + sets;
+}
+
+void OriginTable::clear() {
+  prefixes_.clear();
+  offsets_.assign(1, 0);
+  origins_.clear();
+  sorted_ = true;
+  set_asns_.clear();
+  set_offsets_.assign(1, 0);
+  set_ids_.clear();
+  entries_ = 0;
+  no_origin_ = 0;
+}
+
+} // namespace rib
+} // namespace parsebgp
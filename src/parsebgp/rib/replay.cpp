@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cassert>
+
+#include <parsebgp/rib/replay.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+//==============================================================================
+// rib::RibReplayer
+//==============================================================================
+
+RibReplayer::RibReplayer()
+  : attributes_(std::make_shared<bgp::AttributeSetInterner>())
+  , position_({ 0, 0, 0 })
+  , out_of_order_(0)
+  , checkpoint_interval_(0)
+  , checkpoint_max_count_(0) {}
+
+auto RibReplayer::intern_peer(const utils::IpAddr& ip, uint32_t asn) -> PeerId {
+  Peer peer{ ip, asn };
+  auto ret = peer_ids_.try_emplace(peer, PeerId(peers_.size()));
+  if (ret.second) {
+    peers_.push_back(peer);
+    ribs_.push_back(std::make_shared<PeerRib>());
+  }
+  return ret.first->second;
+}
+
+auto RibReplayer::mutable_rib(PeerId peer) -> PeerRib& {
+  auto& rib = ribs_[peer];
+  if (rib.use_count() > 1) rib = std::make_shared<PeerRib>(*rib);
+  return *rib;
+}
+
+auto RibReplayer::find_peer(const Peer& peer) const -> std::optional<PeerId> {
+  auto it = peer_ids_.find(peer);
+  if (it == peer_ids_.end()) return std::nullopt;
+  return it->second;
+}
+
+bool RibReplayer::load(const mrt::table_dump_v2::Message& msg) {
+  auto subtype = msg.subtype();
+  if (subtype.is_peer_index_table()) {
+    load_peer_index(msg.to_peer_index());
+  } else if (subtype.is_rib_ipv4_unicast()) {
+    load_rib(bgp::AfiType::IPV4, msg.to_rib());
+  } else if (subtype.is_rib_ipv6_unicast()) {
+    load_rib(bgp::AfiType::IPV6, msg.to_rib());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void RibReplayer::load_peer_index(mrt::table_dump_v2::PeerIndex peer_index) {
+  peer_index_.clear();
+  peer_index_.reserve(peer_index.size());
+  for (auto entry : peer_index) {
+    peer_index_.push_back(intern_peer(entry.ip_addr(), entry.asn()));
+  }
+}
+
+void RibReplayer::load_rib(bgp::AfiType afi, mrt::table_dump_v2::Rib rib) {
+  auto prefix = rib.ip_prefix(afi);
+  for (auto entry : rib) {
+    if (entry.peer_index() >= peer_index_.size()) continue;
+    auto& peer_rib = mutable_rib(peer_index_[entry.peer_index()]);
+    Route route{ attributes_->intern(entry.path_attributes()), entry.originated_time() };
+    if (afi.is_ipv4()) {
+      peer_rib.ipv4[ipv4_prefix(prefix)] = route;
+    } else {
+      peer_rib.ipv6[ipv6_prefix(prefix)] = route;
+    }
+  }
+}
+
+void RibReplayer::announce(PeerId peer, bgp::Prefix prefix, Route route) {
+  if (prefix.afi_type().is_ipv4()) {
+    mutable_rib(peer).ipv4[ipv4_prefix(prefix.ip_prefix())] = route;
+  } else {
+    mutable_rib(peer).ipv6[ipv6_prefix(prefix.ip_prefix())] = route;
+  }
+}
+
+void RibReplayer::withdraw(PeerId peer, bgp::Prefix prefix) {
+  if (prefix.afi_type().is_ipv4()) {
+    mutable_rib(peer).ipv4.erase(ipv4_prefix(prefix.ip_prefix()));
+  } else {
+    mutable_rib(peer).ipv6.erase(ipv6_prefix(prefix.ip_prefix()));
+  }
+}
+
+bool RibReplayer::advance(uint32_t sec, uint32_t usec) {
+  auto before = [](uint32_t s1, uint32_t us1, uint32_t s2, uint32_t us2) {
+    return s1 < s2 || (s1 == s2 && us1 < us2);
+  };
+
+  if (resume_) {
+    if (before(sec, usec, resume_->sec, resume_->usec)) return false;
+    if (sec == resume_->sec && usec == resume_->usec && resume_->count) {
+      resume_->count--;
+      return false;
+    }
+    resume_.reset();
+  }
+
+  if (before(sec, usec, position_.sec, position_.usec)) {
+    out_of_order_++;
+    return true;
+  }
+  if (sec == position_.sec && usec == position_.usec) {
+    position_.count++;
+    return true;
+  }
+
+  bool crossed = checkpoint_interval_ &&
+                 position_.sec / checkpoint_interval_ != sec / checkpoint_interval_;
+  if (crossed && position_.sec) {
+    // The checkpoint covers everything up to, but excluding, the current record.
+    checkpoints_.push_back(std::make_unique<Checkpoint>(checkpoint()));
+    if (checkpoints_.size() > checkpoint_max_count_) checkpoints_.pop_front();
+  }
+  position_ = { sec, usec, 1 };
+  return true;
+}
+
+auto RibReplayer::apply(const mrt::Message& msg) -> Result {
+  if (!msg.type().is_bgp4mp()) return Result::IGNORED;
+  auto bgp4mp = msg.to_bgp4mp();
+  auto subtype = bgp4mp.subtype();
+
+  bgp::Message bgp_msg = nullptr;
+  if (subtype.is_message()) {
+    if (subtype.is_local()) return Result::IGNORED;
+    bgp_msg = bgp4mp.to_bgp();
+    if (!bgp_msg.type().is_update()) return Result::IGNORED;
+  } else if (!subtype.is_state_change()) {
+    return Result::IGNORED;
+  }
+
+  if (!advance(msg.timestamp_sec(), msg.timestamp_usec())) return Result::SKIPPED;
+  auto peer = intern_peer(utils::IpAddr::from_bytes(bgp4mp.peer_ip()), bgp4mp.peer_asn());
+
+  if (subtype.is_state_change()) {
+    auto state_change = bgp4mp.to_state_change();
+    if (state_change.old_state().is_established() && !state_change.new_state().is_established()) {
+      ribs_[peer] = std::make_shared<PeerRib>();
+    }
+    return Result::APPLIED;
+  }
+
+  auto update = bgp_msg.to_update();
+  auto attrs = update.path_attributes();
+
+  for (auto prefix : update.withdrawn()) withdraw(peer, prefix);
+  if (attrs.has_mp_unreach()) {
+    for (auto prefix : attrs.mp_unreach()) withdraw(peer, prefix);
+  }
+
+  bool has_mp_reach = attrs.has_mp_reach() && attrs.mp_reach().size();
+  if (update.announced().size() || has_mp_reach) {
+    Route route{ attributes_->intern(attrs), msg.timestamp_sec() };
+    for (auto prefix : update.announced()) announce(peer, prefix, route);
+    if (has_mp_reach) {
+      for (auto prefix : attrs.mp_reach()) announce(peer, prefix, route);
+    }
+  }
+  return Result::APPLIED;
+}
+
+auto RibReplayer::checkpoint() const -> Checkpoint {
+  Checkpoint checkpoint;
+  checkpoint.peers_ = peers_;
+  checkpoint.peer_index_ = peer_index_;
+  checkpoint.ribs_ = ribs_;
+  checkpoint.position_ = position_;
+  return checkpoint;
+}
+
+void RibReplayer::restore(const Checkpoint& checkpoint) {
+  peers_ = checkpoint.peers_;
+  peer_ids_.clear();
+  for (PeerId id = 0; id < peers_.size(); id++) peer_ids_.emplace(peers_[id], id);
+  peer_index_ = checkpoint.peer_index_;
+  ribs_ = checkpoint.ribs_;
+  position_ = checkpoint.position_;
+  resume_ = position_;
+  // Automatic checkpoints after this one describe a future we are about to replay again.
+  while (!checkpoints_.empty() && checkpoints_.back()->position_.sec > position_.sec) {
+    checkpoints_.pop_back();
+  }
+}
+
+void RibReplayer::set_checkpoint_interval(uint32_t interval, std::size_t max_count) {
+  checkpoint_interval_ = interval;
+  checkpoint_max_count_ = max_count;
+  while (checkpoints_.size() > checkpoint_max_count_) checkpoints_.pop_front();
+}
+
+bool RibReplayer::rewind(uint32_t target_sec) {
+  auto it = std::find_if(checkpoints_.rbegin(), checkpoints_.rend(), [&](const auto& c) {
+    return c->position_.sec <= target_sec;
+  });
+  if (it == checkpoints_.rend()) return false;
+  restore(**it);
+  return true;
+}
+
+auto RibReplayer::find(PeerId peer, const utils::IpPrefix& prefix) const
+  -> std::optional<Route> {
+  if (peer >= ribs_.size()) return std::nullopt;
+  auto& peer_rib = *ribs_[peer];
+  if (prefix.is_ipv4()) {
+    auto it = peer_rib.ipv4.find(ipv4_prefix(prefix));
+    if (it == peer_rib.ipv4.end()) return std::nullopt;
+    return it->second;
+  }
+  auto it = peer_rib.ipv6.find(ipv6_prefix(prefix));
+  if (it == peer_rib.ipv6.end()) return std::nullopt;
+  return it->second;
+}
+
+std::size_t RibReplayer::size() const {
+  std::size_t total = 0;
+  for (auto& peer_rib : ribs_) total += peer_rib->ipv4.size() + peer_rib->ipv6.size();
+  return total;
+}
+
+} // namespace rib
+} // namespace parsebgp
@@ -0,0 +1,119 @@
+#include <cassert>
+#include <type_traits>
+
+#include <parsebgp/rib/store.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+//==============================================================================
+// rib::RibStore
+//==============================================================================
+
+bool RibStore::load(const mrt::table_dump_v2::Message& msg) {
+  auto subtype = msg.subtype();
+  if (subtype.is_rib_ipv4_unicast()) {
+    insert(bgp::AfiType::IPV4, msg.to_rib());
+  } else if (subtype.is_rib_ipv6_unicast()) {
+    insert(bgp::AfiType::IPV6, msg.to_rib());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+template<typename Table, typename Key>
+void RibStore::insert_routes(Table& table,
+                             std::vector<Slot<Key>>& slots,
+                             Key key,
+                             uint8_t len,
+                             mrt::table_dump_v2::Rib rib) {
+  key &= PrefixTrie<Key>::mask(len);
+  auto id = table.find(key, len);
+  if (id == Table::NONE) {
+    id = uint32_t(slots.size());
+    slots.push_back({ key, 0, 0, len });
+    table.insert(key, len, id);
+  }
+
+  bool ipv6 = std::is_same<Key, Ipv6Key>::value;
+  auto& slot = slots[id];
+  if (id == last_id_ && ipv6 == last_ipv6_) {
+    assert(slot.routes_offset + slot.routes_count == routes_.size());
+  } else {
+    // Routes of a replaced prefix are left behind rather than compacted.
+    slot.routes_offset = uint32_t(routes_.size());
+    slot.routes_count = 0;
+  }
+  slot.routes_count += uint32_t(rib.size());
+  last_id_ = id;
+  last_ipv6_ = ipv6;
+  for (auto entry : rib) {
+    routes_.push_back({ entry.peer_index(),
+                        entry.originated_time(),
+                        attributes_.intern(entry.path_attributes()) });
+  }
+}
+
+void RibStore::insert(bgp::AfiType afi, mrt::table_dump_v2::Rib rib) {
+  assert(afi.is_valid());
+  auto prefix = rib.ip_prefix(afi);
+  if (prefix.is_ipv4()) {
+    insert_routes(v4_, v4_slots_, key(prefix.addr().ipv4()), prefix.len(), rib);
+  } else {
+    insert_routes(v6_, v6_slots_, key(prefix.addr().ipv6()), prefix.len(), rib);
+  }
+}
+
+auto RibStore::match(const Slot<Ipv4Key>& slot) const -> Match {
+  Routes routes(routes_.data() + slot.routes_offset, slot.routes_count);
+  return { utils::IpPrefix(utils::Ipv4Addr(slot.key), slot.len), routes };
+}
+
+auto RibStore::match(const Slot<Ipv6Key>& slot) const -> Match {
+  Routes routes(routes_.data() + slot.routes_offset, slot.routes_count);
+  utils::Ipv6Addr addr(uint64_t(slot.key >> 64), uint64_t(slot.key));
+  return { utils::IpPrefix(addr, slot.len), routes };
+}
+
+auto RibStore::lookup(const utils::IpAddr& addr) const -> std::optional<Match> {
+  if (addr.is_ipv4()) {
+    auto id = v4_.lookup(key(addr.ipv4()));
+    if (id == Ipv4PrefixTable::NONE) return std::nullopt;
+    return match(v4_slots_[id]);
+  }
+  auto id = v6_.lookup(key(addr.ipv6()));
+  if (id == Ipv6PrefixTable::NONE) return std::nullopt;
+  return match(v6_slots_[id]);
+}
+
+auto RibStore::find(const utils::IpPrefix& prefix) const -> std::optional<Match> {
+  if (prefix.is_ipv4()) {
+    auto id = v4_.find(key(prefix.addr().ipv4()), prefix.len());
+    if (id == Ipv4PrefixTable::NONE) return std::nullopt;
+    return match(v4_slots_[id]);
+  }
+  auto id = v6_.find(key(prefix.addr().ipv6()), prefix.len());
+  if (id == Ipv6PrefixTable::NONE) return std::nullopt;
+  return match(v6_slots_[id]);
+}
+
+std::size_t RibStore::memory_usage() const {
+  return v4_.memory_usage() + v6_.memory_usage() +
+         v4_slots_.capacity() * sizeof(Slot<Ipv4Key>) +
+         v6_slots_.capacity() * sizeof(Slot<Ipv6Key>) + routes_.capacity() * sizeof(Route) +
+         attributes_.canonical_bytes();
+}
+
+void RibStore::clear() {
+  v4_.clear();
+  v6_.clear();
+  v4_slots_.clear();
+  v6_slots_.clear();
+  routes_.clear();
+  attributes_.clear();
+  last_id_ = NO_SLOT;
+}
+
+} // namespace rib
+} // namespace parsebgp
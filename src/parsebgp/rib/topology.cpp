@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include <parsebgp/rib/topology.hpp>
+
+namespace parsebgp {
+namespace rib {
+
+//==============================================================================
+// rib::AsTopology
+//==============================================================================
+
+auto AsTopology::csr() const -> Csr {
+  // Both directions of undirected edges, sorted by their first AS.
+  struct Arc {
+    uint64_t key;
+    uint64_t routes;
+    uint64_t peers;
+
+    bool operator<(const Arc& other) const { return key < other.key; }
+  };
+  std::vector<Arc> arcs;
+  arcs.reserve(options_.directed ? size() : 2 * size());
+  for_each([&](uint32_t a, uint32_t b, uint64_t routes, uint64_t peers) {
+    arcs.push_back({ uint64_t(a) << 32 | b, routes, peers });
+    if (!options_.directed) arcs.push_back({ uint64_t(b) << 32 | a, routes, peers });
+  });
+  std::sort(arcs.begin(), arcs.end());
+
+  Csr csr;
+  csr.asns.reserve(arcs.size());
+  for (auto& arc : arcs) {
+    csr.asns.push_back(uint32_t(arc.key >> 32));
+    if (options_.directed) csr.asns.push_back(uint32_t(arc.key));
+  }
+  std::sort(csr.asns.begin(), csr.asns.end());
+  csr.asns.erase(std::unique(csr.asns.begin(), csr.asns.end()), csr.asns.end());
+  csr.asns.shrink_to_fit();
+
+  auto index = [&](uint32_t asn) {
+    return uint32_t(std::lower_bound(csr.asns.begin(), csr.asns.end(), asn) - csr.asns.begin());
+  };
+  csr.offsets.assign(csr.asns.size() + 1, 0);
+  csr.neighbors.reserve(arcs.size());
+  csr.routes.reserve(arcs.size());
+  csr.peers.reserve(arcs.size());
+  for (auto& arc : arcs) {
+    csr.offsets[index(uint32_t(arc.key >> 32)) + 1]++;
+    csr.neighbors.push_back(index(uint32_t(arc.key)));
+    csr.routes.push_back(arc.routes);
+    csr.peers.push_back(arc.peers);
+  }
+  for (std::size_t i = 1; i < csr.offsets.size(); i++) csr.offsets[i] += csr.offsets[i - 1];
+  return csr;
+}
+
+//==============================================================================
+// rib::AsTopology::Extractor
+//==============================================================================
+
+void AsTopology::Extractor::add(const mrt::Message& msg,
+                                const mrt::table_dump_v2::PeerTable& peers) {
+  if (msg.type().is_table_dump_v2()) {
+    auto table_dump_v2 = msg.to_table_dump_v2();
+    if (!table_dump_v2.subtype().is_rib_ip()) return;
+    for (auto entry : table_dump_v2.to_rib()) {
+      auto attrs = entry.path_attributes();
+      if (!attrs.has_as_path()) continue;
+      auto peer = entry.peer(peers);
+      add(attrs.as_path(), 1, peer ? peer_id(peers.ip(*peer), peer->asn()) : 0);
+    }
+  } else if (msg.type().is_bgp4mp()) {
+    auto bgp4mp = msg.to_bgp4mp();
+    if (!bgp4mp.subtype().is_message()) return;
+    auto bgp = bgp4mp.to_bgp();
+    if (!bgp.type().is_update()) return;
+    auto update = bgp.to_update();
+    auto attrs = update.path_attributes();
+    if (!attrs.has_as_path()) return;
+    std::size_t prefixes = update.announced().size();
+    if (attrs.has_mp_reach()) prefixes += attrs.mp_reach().size();
+    if (!prefixes) return;
+    auto peer = peer_id(utils::IpAddr::from_bytes(bgp4mp.peer_ip()), bgp4mp.peer_asn());
+    add(attrs.as_path(), uint32_t(prefixes), peer);
+  }
+}
+
+void AsTopology::Extractor::add(const bgp::PathAttributes::AsPath& path, uint32_t count,
+                                uint64_t peer) {
+  auto& options = topology_.options();
+  paths_ += count;
+  // Previous AS of the path, 0 at its start and where it was cut.
+  uint32_t prev = 0;
+  for (auto segment : path) {
+    auto type = segment.type();
+    bool sequence = type.is_as_seq() || (options.confederations && type.is_confed_seq());
+    bool set = type.is_as_set() || (options.confederations && type.is_confed_set());
+    if (sequence) {
+      for (auto asn : segment.asns()) {
+        if (asn == prev) continue;
+        if (prev && asn) add_edge(prev, asn, count, peer);
+        prev = asn;
+      }
+    } else {
+      if (set && options.as_sets && prev) {
+        for (auto asn : segment.asns()) {
+          if (asn && asn != prev) add_edge(prev, asn, count, peer);
+        }
+      }
+      prev = 0;
+    }
+  }
+}
+
+void AsTopology::Extractor::add_edge(uint32_t a, uint32_t b, uint32_t count, uint64_t peer) {
+  uint64_t key = topology_.key(a, b);
+  auto& slot = cache_[utils::Hasher::hash_u64(key) & (CACHE_SIZE - 1)];
+  if (slot.key != key) {
+    flush(slot);
+    slot.key = key;
+  }
+  slot.routes += count;
+
+  if (!peer || !topology_.options_.peers_per_edge) return;
+  uint64_t pair = peer_pair(key, peer);
+  auto& known = pair_cache_[pair & (CACHE_SIZE - 1)];
+  if (known == pair) return;
+  switch (topology_.peer_pairs_.insert(pair)) {
+  case utils::ConcurrentCounter::Insert::INSERTED:
+    slot.peers++;
+    break;
+  case utils::ConcurrentCounter::Insert::PRESENT:
+    break;
+  case utils::ConcurrentCounter::Insert::FULL:
+    topology_.peers_overflowed_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  known = pair;
+}
+
+void AsTopology::Extractor::flush(CacheSlot& slot) {
+  if (slot.routes && !topology_.edges_.add(slot.key, slot.routes)) {
+    topology_.overflowed_.fetch_add(slot.routes, std::memory_order_relaxed);
+  }
+  if (slot.peers && !topology_.edge_peers_.add(slot.key, slot.peers)) {
+    topology_.peers_overflowed_.fetch_add(slot.peers, std::memory_order_relaxed);
+  }
+  slot.routes = 0;
+  slot.peers = 0;
+}
+
+void AsTopology::Extractor::flush() {
+  for (auto& slot : cache_) flush(slot);
+}
+
+} // namespace rib
+} // namespace parsebgp
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#include <parsebgp/utils/bitmap.hpp>
+
+namespace parsebgp {
+namespace utils {
+
+//==============================================================================
+// utils::Bitmap::Container
+//==============================================================================
+
+void Bitmap::Container::add(uint16_t low) {
+  if (is_bitset()) {
+    uint64_t mask = uint64_t(1) << (low % 64);
+    if (!(bits[low / 64] & mask)) {
+      bits[low / 64] |= mask;
+      cardinality++;
+    }
+    return;
+  }
+  if (array.empty() || array.back() < low) {
+    array.push_back(low);
+  } else {
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (*it == low) return;
+    array.insert(it, low);
+  }
+  cardinality++;
+  if (cardinality > ARRAY_MAX_SIZE) to_bitset();
+}
+
+bool Bitmap::Container::contains(uint16_t low) const {
+  if (is_bitset()) return bits[low / 64] & (uint64_t(1) << (low % 64));
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+void Bitmap::Container::to_bitset() {
+  assert(!is_bitset());
+  bits.assign(BITSET_WORDS, 0);
+  for (auto low : array) bits[low / 64] |= uint64_t(1) << (low % 64);
+  array.clear();
+  array.shrink_to_fit();
+}
+
+void Bitmap::Container::to_array() {
+  assert(is_bitset());
+  array.clear();
+  array.reserve(cardinality);
+  for (std::size_t i = 0; i < BITSET_WORDS; i++) {
+    for (uint64_t word = bits[i]; word; word &= word - 1) {
+      array.push_back(uint16_t(i * 64 + __builtin_ctzll(word)));
+    }
+  }
+  bits.clear();
+  bits.shrink_to_fit();
+}
+
+//==============================================================================
+// utils::Bitmap
+//==============================================================================
+
+auto Bitmap::find_or_insert(uint16_t key) -> Container* {
+  if (containers_.empty() || containers_.back().key < key) {
+    containers_.push_back({ key, 0, {}, {} });
+    return &containers_.back();
+  }
+  if (containers_.back().key == key) return &containers_.back();
+  auto it = std::lower_bound(containers_.begin(),
+                             containers_.end(),
+                             key,
+                             [](const Container& c, uint16_t k) { return c.key < k; });
+  if (it->key != key) it = containers_.insert(it, { key, 0, {}, {} });
+  return &*it;
+}
+
+auto Bitmap::find(uint16_t key) const -> const Container* {
+  auto it = std::lower_bound(containers_.begin(),
+                             containers_.end(),
+                             key,
+                             [](const Container& c, uint16_t k) { return c.key < k; });
+  if (it == containers_.end() || it->key != key) return nullptr;
+  return &*it;
+}
+
+void Bitmap::add(uint32_t value) {
+  find_or_insert(uint16_t(value >> 16))->add(uint16_t(value));
+}
+
+bool Bitmap::contains(uint32_t value) const {
+  auto c = find(uint16_t(value >> 16));
+  return c && c->contains(uint16_t(value));
+}
+
+uint64_t Bitmap::cardinality() const {
+  uint64_t total = 0;
+  for (auto& c : containers_) total += c.cardinality;
+  return total;
+}
+
+auto Bitmap::intersect(const Container& lhs, const Container& rhs) -> Container {
+  Container out{ lhs.key, 0, {}, {} };
+  if (lhs.is_bitset() && rhs.is_bitset()) {
+    out.bits.resize(BITSET_WORDS);
+    for (std::size_t i = 0; i < BITSET_WORDS; i++) {
+      out.bits[i] = lhs.bits[i] & rhs.bits[i];
+      out.cardinality += __builtin_popcountll(out.bits[i]);
+    }
+    if (out.cardinality <= ARRAY_MAX_SIZE) out.to_array();
+  } else if (lhs.is_bitset() || rhs.is_bitset()) {
+    auto& bitset = lhs.is_bitset() ? lhs : rhs;
+    auto& array = lhs.is_bitset() ? rhs : lhs;
+    for (auto low : array.array) {
+      if (bitset.contains(low)) out.array.push_back(low);
+    }
+    out.cardinality = uint32_t(out.array.size());
+  } else {
+    std::set_intersection(lhs.array.begin(),
+                          lhs.array.end(),
+                          rhs.array.begin(),
+                          rhs.array.end(),
+                          std::back_inserter(out.array));
+    out.cardinality = uint32_t(out.array.size());
+  }
+  return out;
+}
+
+auto Bitmap::unite(const Container& lhs, const Container& rhs) -> Container {
+  Container out{ lhs.key, 0, {}, {} };
+  if (!lhs.is_bitset() && !rhs.is_bitset()) {
+    out.array.reserve(lhs.array.size() + rhs.array.size());
+    std::set_union(lhs.array.begin(),
+                   lhs.array.end(),
+                   rhs.array.begin(),
+                   rhs.array.end(),
+                   std::back_inserter(out.array));
+    out.cardinality = uint32_t(out.array.size());
+    if (out.cardinality > ARRAY_MAX_SIZE) out.to_bitset();
+    return out;
+  }
+  out.bits.assign(BITSET_WORDS, 0);
+  for (auto c : { &lhs, &rhs }) {
+    if (c->is_bitset()) {
+      for (std::size_t i = 0; i < BITSET_WORDS; i++) out.bits[i] |= c->bits[i];
+    } else {
+      for (auto low : c->array) out.bits[low / 64] |= uint64_t(1) << (low % 64);
+    }
+  }
+  for (auto word : out.bits) out.cardinality += __builtin_popcountll(word);
+  return out;
+}
+
+Bitmap& Bitmap::operator&=(const Bitmap& rhs) {
+  *this = *this & rhs;
+  return *this;
+}
+
+Bitmap& Bitmap::operator|=(const Bitmap& rhs) {
+  *this = *this | rhs;
+  return *this;
+}
+
+Bitmap operator&(const Bitmap& lhs, const Bitmap& rhs) {
+  Bitmap out;
+  auto l = lhs.containers_.begin();
+  auto r = rhs.containers_.begin();
+  while (l != lhs.containers_.end() && r != rhs.containers_.end()) {
+    if (l->key < r->key) {
+      l++;
+    } else if (r->key < l->key) {
+      r++;
+    } else {
+      auto c = Bitmap::intersect(*l++, *r++);
+      if (c.cardinality) out.containers_.push_back(std::move(c));
+    }
+  }
+  return out;
+}
+
+Bitmap operator|(const Bitmap& lhs, const Bitmap& rhs) {
+  Bitmap out;
+  out.containers_.reserve(std::max(lhs.containers_.size(), rhs.containers_.size()));
+  auto l = lhs.containers_.begin();
+  auto r = rhs.containers_.begin();
+  while (l != lhs.containers_.end() || r != rhs.containers_.end()) {
+    if (r == rhs.containers_.end() || (l != lhs.containers_.end() && l->key < r->key)) {
+      out.containers_.push_back(*l++);
+    } else if (l == lhs.containers_.end() || r->key < l->key) {
+      out.containers_.push_back(*r++);
+    } else {
+      out.containers_.push_back(Bitmap::unite(*l++, *r++));
+    }
+  }
+  return out;
+}
+
+bool Bitmap::operator==(const Bitmap& rhs) const {
+  if (containers_.size() != rhs.containers_.size()) return false;
+  for (std::size_t i = 0; i < containers_.size(); i++) {
+    auto& l = containers_[i];
+    auto& r = rhs.containers_[i];
+    // Containers are canonical: bitsets only above ARRAY_MAX_SIZE values.
+    if (l.key != r.key || l.cardinality != r.cardinality || l.array != r.array ||
+        l.bits != r.bits) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<uint32_t> Bitmap::to_vector() const {
+  std::vector<uint32_t> out;
+  out.reserve(cardinality());
+  for_each([&out](uint32_t value) { out.push_back(value); });
+  return out;
+}
+
+std::size_t Bitmap::memory_usage() const {
+  std::size_t total = containers_.capacity() * sizeof(Container);
+  for (auto& c : containers_) {
+    total += c.array.capacity() * sizeof(uint16_t) + c.bits.capacity() * sizeof(uint64_t);
+  }
+  return total;
+}
+
+void Bitmap::shrink_to_fit() {
+  containers_.shrink_to_fit();
+  for (auto& c : containers_) c.array.shrink_to_fit();
+}
+
+} // namespace utils
+} // namespace parsebgp
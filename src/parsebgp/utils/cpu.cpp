@@ -0,0 +1,15 @@
+#include <parsebgp/utils/cpu.hpp>
+
+namespace parsebgp {
+namespace utils {
+
+Isa supported_isa() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  if (__builtin_cpu_supports("avx512f")) return Isa::AVX512;
+  if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+#endif
+  return Isa::SCALAR;
+}
+
+} // namespace utils
+} // namespace parsebgp
@@ -0,0 +1,45 @@
+#include <parsebgp/utils/ip.hpp>
+
+namespace parsebgp {
+namespace utils {
+
+//==============================================================================
+// utils::IpPrefix
+//==============================================================================
+
+namespace {
+
+constexpr IpPrefix prefix(string_view text) { return *IpPrefix::parse(text); }
+constexpr IpAddr addr(string_view text) { return *IpAddr::parse(text); }
+
+} // namespace
+
+static_assert(prefix("10.1.2.3/8") == prefix("10.0.0.0/8"));
+static_assert(prefix("10.0.0.0/8").addr() == addr("10.0.0.0"));
+
+static_assert(prefix("10.0.0.0/8").contains(addr("10.255.0.1")));
+static_assert(!prefix("10.0.0.0/8").contains(addr("11.0.0.0")));
+static_assert(!prefix("10.0.0.0/8").contains(addr("::ffff:10.0.0.1")));
+static_assert(prefix("10.0.0.0/8").contains(prefix("10.0.0.0/8")));
+static_assert(prefix("10.0.0.0/8").contains(prefix("10.1.0.0/16")));
+static_assert(prefix("10.0.0.0/8").contains(prefix("10.1.2.3/32")));
+static_assert(!prefix("10.0.0.0/8").contains(prefix("11.0.0.0/16")));
+static_assert(!prefix("10.0.0.0/8").contains(prefix("0.0.0.0/0")));
+static_assert(!prefix("10.1.0.0/16").contains(prefix("10.0.0.0/8")));
+static_assert(prefix("0.0.0.0/0").contains(prefix("255.255.255.255/32")));
+static_assert(!prefix("0.0.0.0/0").contains(prefix("::/0")));
+
+static_assert(prefix("2001:db8::/32").contains(addr("2001:db8:ffff::1")));
+static_assert(!prefix("2001:db8::/32").contains(addr("2001:db9::")));
+static_assert(prefix("2001:db8::/32").contains(prefix("2001:db8::/32")));
+static_assert(prefix("2001:db8::/32").contains(prefix("2001:db8:1::/48")));
+static_assert(prefix("2001:db8::/32").contains(prefix("2001:db8::1/128")));
+static_assert(!prefix("2001:db8::/32").contains(prefix("2001:db9::/48")));
+static_assert(!prefix("2001:db8:1::/48").contains(prefix("2001:db8::/32")));
+static_assert(prefix("2001:db8::/96").contains(prefix("2001:db8::a00:0/104")));
+static_assert(!prefix("2001:db8::/96").contains(prefix("2001:db8::1:a00:0/104")));
+static_assert(prefix("::/0").contains(prefix("ffff::/16")));
+static_assert(!prefix("::/0").contains(prefix("0.0.0.0/0")));
+
+} // namespace utils
+} // namespace parsebgp
@@ -1,51 +1,387 @@
-#include <cassert>
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <parsebgp.hpp>
 #include <parsebgp/io.hpp>
+#include <parsebgp/io/bgpdump.hpp>
 
 namespace pbgp = parsebgp;
-namespace mrt = parsebgp::mrt;
 namespace io = parsebgp::io;
 
-int main(int argc, char *argv[]) {
-  if (argc != 2) return 1;
+/*
+ * Print MRT files like `bgpdump -m`, decoding them on a thread pool.
+ *
+ * Files are decoded in batches of about BATCH_SIZE bytes of text. Each file queues at most
+ * MAX_QUEUED batches for the writer, which stalls its decoding until the writer catches up, so
+ * memory stays bounded however far ahead the pool gets. Without --merge, files are printed one
+ * after the other in argument order and only the next few are decoded ahead. With --merge, all
+ * files are open at once and records are interleaved by MRT timestamp.
+ */
 
-  io::GzipStream gzs(argv[1], 32678 * 4);
-  pbgp::Options options;
+namespace {
 
-  options.set_ignore_not_implemented(true);
-  auto reader = io::mrt_reader(gzs, std::move(options));
-  for(auto msg : reader) {
-    if(msg) {
-      // msg->dump();
-      auto tdv2 = msg->to_table_dump_v2();
-      if (tdv2.subtype().is_rib_ip()) {
-        auto rib = tdv2.to_rib();
-        for(auto entry : rib) {
-
-          assert(entry.path_attributes().has_as_path());
-          std::cout << "ASPATH: ";
-          for (auto seg : entry.path_attributes().as_path()) {
-            std::cout << "(" << seg.type() << ") ";
-            for(auto asn : seg) {
-              std::cout << asn << (!asn.is_public() ? "[!]" : "") << " ";
-            }
-          }
-          std::cout << std::endl;
-
-          if (entry.path_attributes().has_communities()) {
-            std::cout << "COMMUNITIES: ";
-            for(auto comm : entry.path_attributes().communities()) {
-              std::cout << comm.asn << ":" << comm.value << " ";
-            }
-            std::cout << std::endl;
-          }
+constexpr size_t BATCH_SIZE = 1 << 18;
+constexpr size_t MAX_QUEUED = 4;
+constexpr size_t OUTPUT_CHUNK = 1 << 20;
+
+using Formatter = io::BgpdumpFormatter;
+
+struct Record {
+  uint64_t timestamp; // Microseconds.
+  size_t end;         // Offset of the end of the record's lines in the batch text.
+};
+
+struct Batch {
+  explicit Batch(const Formatter::Filter& filter) : text(BATCH_SIZE + BATCH_SIZE / 4, filter) {}
+
+  Formatter text;
+  // Only kept for --merge.
+  std::vector<Record> records;
+};
+
+/* Decoding state of one file, advanced one batch at a time by any worker. */
+class Job {
+public:
+  virtual ~Job() = default;
+  /* Fill batch. Return false once the file is finished, with error set if it failed. */
+  virtual bool decode(Batch& batch, bool keep_records) = 0;
+
+  std::string error;
+};
+
+template<typename Stream>
+class FileJob : public Job {
+public:
+  FileJob(Stream&& stream, pbgp::Options options)
+    : reader_(io::mrt_reader(std::forward<Stream>(stream), std::move(options), 1 << 17)) {}
+
+  // Checked before the first decode, while errno still tells why the file could not be opened.
+  static std::unique_ptr<Job> open(Stream&& stream, pbgp::Options options) {
+    int open_errno = stream.bad() ? errno : 0;
+    auto job = std::make_unique<FileJob>(std::forward<Stream>(stream), std::move(options));
+    if (open_errno) job->error = std::strerror(open_errno);
+    return job;
+  }
+
+  bool decode(Batch& batch, bool keep_records) override {
+    if (!error.empty()) return false;
+    while (batch.text.size() < BATCH_SIZE) {
+      auto msg = reader_.message();
+      if (!msg) {
+        auto status = msg.error();
+        if (status.is_decoder_error()) {
+          error = "decode error: " + std::string(pbgp::to_string(status.to_decoder_error()));
+        } else if (!status.is_finished()) {
+          error = "read error " + std::to_string(int(status.value()));
         }
+        return false;
+      }
+      size_t size = batch.text.size();
+      batch.text.append(*msg, reader_.peer_table());
+      if (keep_records && batch.text.size() != size) {
+        uint64_t timestamp = uint64_t(msg->timestamp_sec()) * 1000000 + msg->timestamp_usec();
+        batch.records.push_back({ timestamp, batch.text.size() });
       }
+      reader_.decode_one();
+    }
+    return true;
+  }
+
+private:
+  io::MrtReader<Stream> reader_;
+};
+
+bool ends_with(const std::string& s, const char* suffix) {
+  size_t n = std::strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+std::unique_ptr<Job> open_job(const std::string& path) {
+  pbgp::Options options;
+  options.set_ignore_not_implemented(true);
+  if (ends_with(path, ".bz2")) {
+    return FileJob<io::Bzip2Stream>::open(io::Bzip2Stream(path), std::move(options));
+  }
+  if (ends_with(path, ".gz")) {
+    return FileJob<io::GzipStream>::open(io::GzipStream(path, 1 << 17), std::move(options));
+  }
+  return FileJob<io::FileStream>::open(io::FileStream(path), std::move(options));
+}
+
+/* Hands batches of files from a pool of decoding threads to the writer. */
+class Scheduler {
+public:
+  Scheduler(std::vector<std::string> paths,
+            size_t threads,
+            size_t window,
+            bool keep_records,
+            const Formatter::Filter& filter)
+    : paths_(std::move(paths)), files_(paths_.size()), keep_records_(keep_records), filter_(filter) {
+    admit(window);
+    for (size_t i = 0; i < threads; i++) threads_.emplace_back([this] { work(); });
+  }
+
+  ~Scheduler() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& thread : threads_) thread.join();
+  }
+
+  size_t size() const { return files_.size(); }
+  const std::string& path(size_t file) const { return paths_[file]; }
+
+  /* Let files up to limit be decoded. */
+  void admit(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (; admitted_ < std::min(limit, files_.size()); admitted_++) ready_.push_back(admitted_);
+    work_cv_.notify_all();
+  }
+
+  /* Next batch of file, or nullptr once it is finished. Blocks until either is known. */
+  std::unique_ptr<Batch> next(size_t file) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& state = files_[file];
+    output_cv_.wait(lock, [&] { return !state.queue.empty() || state.done; });
+    if (state.queue.empty()) return nullptr;
+    auto batch = std::move(state.queue.front());
+    state.queue.pop_front();
+    if (state.blocked) {
+      state.blocked = false;
+      ready_.push_back(file);
+      work_cv_.notify_one();
+    }
+    return batch;
+  }
+
+  /* Errors of finished files. */
+  const std::string& error(size_t file) const { return files_[file].error; }
+
+private:
+  struct File {
+    std::unique_ptr<Job> job;
+    std::deque<std::unique_ptr<Batch>> queue;
+    // Waiting for the writer to make room in queue.
+    bool blocked = false;
+    bool done = false;
+    std::string error;
+  };
+
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_cv_.wait(lock, [&] { return stopped_ || !ready_.empty(); });
+      if (stopped_) return;
+      size_t file = ready_.front();
+      ready_.pop_front();
+      auto& state = files_[file];
+      lock.unlock();
+
+      if (!state.job) state.job = open_job(paths_[file]);
+      auto batch = std::make_unique<Batch>(filter_);
+      bool more = state.job->decode(*batch, keep_records_);
+
+      lock.lock();
+      if (batch->text.size()) state.queue.push_back(std::move(batch));
+      if (!more) {
+        state.done = true;
+        state.error = state.job->error;
+        state.job.reset();
+      } else if (state.queue.size() < MAX_QUEUED) {
+        ready_.push_back(file);
+      } else {
+        state.blocked = true;
+      }
+      output_cv_.notify_all();
+    }
+  }
+
+  std::vector<std::string> paths_;
+  std::vector<File> files_;
+  bool keep_records_;
+  Formatter::Filter filter_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable output_cv_;
+  std::deque<size_t> ready_;
+  size_t admitted_ = 0;
+  bool stopped_ = false;
+  std::vector<std::thread> threads_;
+};
+
+class Output {
+public:
+  Output() { buffer_.reserve(2 * OUTPUT_CHUNK); }
+  ~Output() { flush(); }
+
+  void write(const char* data, size_t size) {
+    if (buffer_.size() + size > OUTPUT_CHUNK) flush();
+    if (size >= OUTPUT_CHUNK) {
+      good_ &= std::fwrite(data, 1, size, stdout) == size;
+    } else {
+      buffer_.insert(buffer_.end(), data, data + size);
+    }
+  }
+
+  bool flush() {
+    good_ &= std::fwrite(buffer_.data(), 1, buffer_.size(), stdout) == buffer_.size();
+    buffer_.clear();
+    good_ &= std::fflush(stdout) == 0;
+    return good_;
+  }
+
+private:
+  std::vector<char> buffer_;
+  bool good_ = true;
+};
+
+void print_ordered(Scheduler& scheduler, size_t window, Output& out) {
+  for (size_t file = 0; file < scheduler.size(); file++) {
+    scheduler.admit(file + window);
+    while (auto batch = scheduler.next(file)) out.write(batch->text.data(), batch->text.size());
+  }
+}
+
+void print_merged(Scheduler& scheduler, Output& out) {
+  struct Cursor {
+    std::unique_ptr<Batch> batch;
+    size_t record = 0;
+  };
+  // Heap of (timestamp, file), smallest first; ties keep argument order.
+  using Head = std::pair<uint64_t, size_t>;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  std::vector<Cursor> cursors(scheduler.size());
+
+  auto advance = [&](size_t file) {
+    auto& cursor = cursors[file];
+    while (!cursor.batch || cursor.record == cursor.batch->records.size()) {
+      cursor.batch = scheduler.next(file);
+      cursor.record = 0;
+      if (!cursor.batch) return;
+    }
+    heads.push({ cursor.batch->records[cursor.record].timestamp, file });
+  };
+
+  for (size_t file = 0; file < scheduler.size(); file++) advance(file);
+  while (!heads.empty()) {
+    size_t file = heads.top().second;
+    heads.pop();
+    auto& cursor = cursors[file];
+    auto& records = cursor.batch->records;
+    size_t start = cursor.record ? records[cursor.record - 1].end : 0;
+    out.write(cursor.batch->text.data() + start, records[cursor.record].end - start);
+    cursor.record++;
+    advance(file);
+  }
+}
+
+bool parse_kinds(const char* arg, uint8_t& kinds) {
+  kinds = 0;
+  std::string list(arg);
+  size_t pos = 0;
+  while (pos <= list.size()) {
+    size_t end = std::min(list.find(',', pos), list.size());
+    auto kind = list.substr(pos, end - pos);
+    if (kind == "rib") {
+      kinds |= Formatter::RIB;
+    } else if (kind == "announce") {
+      kinds |= Formatter::ANNOUNCE;
+    } else if (kind == "withdraw") {
+      kinds |= Formatter::WITHDRAW;
+    } else if (kind == "update") {
+      kinds |= Formatter::ANNOUNCE | Formatter::WITHDRAW;
+    } else if (kind == "state") {
+      kinds |= Formatter::STATE;
     } else {
-      throw std::runtime_error(std::to_string(msg.error().value()));
+      return false;
     }
+    pos = end + 1;
+  }
+  return true;
+}
+
+bool parse_prefix(const char* arg, Formatter::Filter& filter) {
+  auto prefix = pbgp::utils::IpPrefix::parse(arg);
+  if (!prefix) return false;
+  filter.prefix = *prefix;
+  return true;
+}
+
+int usage(const char* argv0) {
+  std::fprintf(stderr,
+               "usage: %s [--threads N] [--merge] [--only-type KINDS] [--prefix PREFIX] FILE...\n"
+               "\n"
+               "Print MRT files, plain, .gz or .bz2, like `bgpdump -m`.\n"
+               "\n"
+               "  --threads N        decoding threads, default: number of CPUs\n"
+               "  --merge            interleave records of all files by timestamp instead of\n"
+               "                     printing files one after the other\n"
+               "  --only-type KINDS  comma separated line kinds to print: rib, announce,\n"
+               "                     withdraw, update (announce and withdraw), state\n"
+               "  --prefix PREFIX    only print lines for PREFIX and more specific prefixes\n",
+               argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t threads = std::max(1U, std::thread::hardware_concurrency());
+  bool merge = false;
+  Formatter::Filter filter;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--threads" && has_value) {
+      threads = size_t(std::max(1L, std::strtol(argv[++i], nullptr, 10)));
+    } else if (arg == "--merge") {
+      merge = true;
+    } else if (arg == "--only-type" && has_value) {
+      if (!parse_kinds(argv[++i], filter.kinds)) return usage(argv[0]);
+    } else if (arg == "--prefix" && has_value) {
+      if (!parse_prefix(argv[++i], filter)) return usage(argv[0]);
+    } else if (arg == "--") {
+      paths.insert(paths.end(), argv + i + 1, argv + argc);
+      break;
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      return usage(argv[0]);
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.empty()) return usage(argv[0]);
+
+  // Files decoded ahead of the one being printed, enough to keep the pool busy.
+  size_t window = merge ? paths.size() : 2 * threads;
+  Output out;
+  Scheduler scheduler(paths, threads, window, merge, filter);
+  if (merge) {
+    print_merged(scheduler, out);
+  } else {
+    print_ordered(scheduler, window, out);
+  }
+
+  int ret = out.flush() ? 0 : 1;
+  for (size_t file = 0; file < scheduler.size(); file++) {
+    if (scheduler.error(file).empty()) continue;
+    std::fprintf(stderr, "%s: %s\n", scheduler.path(file).c_str(), scheduler.error(file).c_str());
+    ret = 1;
   }
-  return 0;
+  return ret;
 }